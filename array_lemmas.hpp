@@ -0,0 +1,283 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file array_lemmas.hpp
+ *
+ * @brief lemmas on demand for arrays on backends without array support
+ *
+ * Every read select(a, i) is abstracted by a fresh bit-vector and
+ * every array equality by a fresh Boolean.  Array terms themselves
+ * (variables, store, ite and constant arrays) are never converted.
+ * After the solver found a model of the abstraction, each read is
+ * propagated through the array terms it reads from, following the
+ * model:
+ *
+ * - store(b, j, v) with i = j: the read must yield v (read-over-write),
+ *   otherwise it continues on b under the condition i != j;
+ * - ite(c, a, b): it continues on the branch selected by c;
+ * - a constant array ((as const ..) v): the read must yield v;
+ * - an array variable: all reads reaching the variable with equal
+ *   indices must yield equal values (congruence);
+ * - an equality a = b that is true in the model: the read continues
+ *   on both sides (extensionality).
+ *
+ * Every violation yields a lemma "path conditions imply the expected
+ * value", which excludes the current model.  For every equality a
+ * witness lemma not( a = b ) -> select( a, k ) != select( b, k ) with
+ * a fresh index k is added up front.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "bv_value.hpp"
+#include "z3_utils.hpp"
+
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/frontend/Logic.hpp>
+#include <metaSMT/frontend/QF_BV.hpp>
+
+#include <z3++.h>
+
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+template < typename Solver >
+class array_lemmas
+{
+public:
+  using result_type = typename Solver::result_type;
+
+  explicit array_lemmas( Solver& solver )
+    : solver( solver )
+  {}
+
+  bool empty() const
+  {
+    return reads.empty();
+  }
+
+  /* `value' abstracts select( array, index ) */
+  void add_read( const z3::expr& array, const result_type& index, const result_type& value )
+  {
+    read r = { array, index, value };
+    reads.push_back( r );
+  }
+
+  /* `value' abstracts lhs = rhs, the reads of the witness are added */
+  void add_equality( const z3::expr& lhs, const z3::expr& rhs, const result_type& value )
+  {
+    equality e = { lhs, rhs, value };
+    equalities_of[z3_expr_id( lhs )].push_back( equalities.size() );
+    equalities_of[z3_expr_id( rhs )].push_back( equalities.size() );
+    equalities.push_back( e );
+  }
+
+  /**
+   * Checks the reads against the current model and asserts a lemma
+   * for every violation.  `convert' maps the indices, values and
+   * conditions inside array terms to metaSMT terms; it must have
+   * converted them before the solver ran.  Returns the number of
+   * lemmas, i.e., 0 if the model is consistent.
+   */
+  template < typename Converter >
+  unsigned refine( Converter& convert )
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+
+    struct base_read
+    {
+      unsigned read;
+      std::vector< result_type > path;
+    };
+
+    /* the indices of one array variable have the same width */
+    struct index_less
+    {
+      bool operator()( const bv_value& a, const bv_value& b ) const { return bv_ult( a, b ); }
+    };
+
+    /* first read reaching an array variable, per index value */
+    std::unordered_map< unsigned, std::map< bv_value, base_read, index_less > > base;
+
+    unsigned num_lemmas = 0u;
+    for ( unsigned k = 0u; k < reads.size(); ++k )
+    {
+      const read& rd = reads[k];
+      const bv_value index = model_value( rd.index );
+      const bv_value value = model_value( rd.value );
+
+      std::unordered_set< unsigned > visited;
+      std::vector< std::pair< z3::expr, std::vector< result_type > > > worklist;
+      worklist.push_back( std::make_pair( rd.array, std::vector< result_type >() ) );
+      while ( !worklist.empty() )
+      {
+        const z3::expr t = worklist.back().first;
+        std::vector< result_type > path = worklist.back().second;
+        worklist.pop_back();
+        if ( !visited.insert( z3_expr_id( t ) ).second )
+        {
+          continue;
+        }
+
+        /*** equalities true in the model ***/
+        const auto eqs = equalities_of.find( z3_expr_id( t ) );
+        if ( eqs != equalities_of.end() )
+        {
+          for ( const unsigned q : eqs->second )
+          {
+            const equality& e = equalities[q];
+            if ( bool_value( e.value ) )
+            {
+              std::vector< result_type > p = path;
+              p.push_back( e.value );
+              worklist.push_back( std::make_pair( z3_expr_id( e.lhs ) == z3_expr_id( t ) ? e.rhs : e.lhs, p ) );
+            }
+          }
+        }
+
+        const Z3_decl_kind kind = t.decl().decl_kind();
+        if ( kind == Z3_OP_STORE )
+        {
+          const result_type& j = convert( t.arg( 1u ) );
+          if ( model_value( j ) == index )
+          {
+            const result_type& v = convert( t.arg( 2u ) );
+            if ( model_value( v ) != value )
+            {
+              path.push_back( evaluate( solver, logic::equal( rd.index, j ) ) );
+              add_lemma( path, rd.value, v );
+              ++num_lemmas;
+            }
+            continue;
+          }
+          path.push_back( evaluate( solver, logic::nequal( rd.index, j ) ) );
+          worklist.push_back( std::make_pair( t.arg( 0u ), path ) );
+        }
+        else if ( kind == Z3_OP_ITE )
+        {
+          const result_type& c = convert( t.arg( 0u ) );
+          if ( bool_value( c ) )
+          {
+            path.push_back( c );
+            worklist.push_back( std::make_pair( t.arg( 1u ), path ) );
+          }
+          else
+          {
+            path.push_back( evaluate( solver, Not( c ) ) );
+            worklist.push_back( std::make_pair( t.arg( 2u ), path ) );
+          }
+        }
+        else if ( kind == Z3_OP_CONST_ARRAY )
+        {
+          const result_type& v = convert( t.arg( 0u ) );
+          if ( model_value( v ) != value )
+          {
+            add_lemma( path, rd.value, v );
+            ++num_lemmas;
+          }
+        }
+        else if ( is_variable( t ) )
+        {
+          std::map< bv_value, base_read, index_less >& at = base[z3_expr_id( t )];
+          const auto it = at.find( index );
+          if ( it == at.end() )
+          {
+            base_read b = { k, path };
+            at.insert( std::make_pair( index, b ) );
+          }
+          else if ( model_value( reads[it->second.read].value ) != value )
+          {
+            const read& other = reads[it->second.read];
+            path.insert( path.end(), it->second.path.begin(), it->second.path.end() );
+            path.push_back( evaluate( solver, logic::equal( rd.index, other.index ) ) );
+            add_lemma( path, rd.value, other.value );
+            ++num_lemmas;
+          }
+        }
+        else
+        {
+          std::cerr << "[e] array_lemmas: does not support array term " << t.decl().name().str() << '\n';
+          assert( false );
+        }
+      }
+    }
+    return num_lemmas;
+  }
+
+private:
+  struct read
+  {
+    z3::expr array;
+    result_type index;
+    result_type value;
+  };
+
+  struct equality
+  {
+    z3::expr lhs;
+    z3::expr rhs;
+    result_type value;
+  };
+
+  bv_value model_value( const result_type& r )
+  {
+    const std::string bits = metaSMT::read_value( solver, r );
+    return bv_value::from_binary( bits );
+  }
+
+  bool bool_value( const result_type& r )
+  {
+    const bool b = metaSMT::read_value( solver, r );
+    return b;
+  }
+
+  /* asserts ( path[0] and ... and path[n-1] ) -> lhs = rhs */
+  void add_lemma( const std::vector< result_type >& path, const result_type& lhs, const result_type& rhs )
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+
+    result_type premise = evaluate( solver, True );
+    for ( const auto& p : path )
+    {
+      premise = evaluate( solver, And( premise, p ) );
+    }
+    assertion( solver, evaluate( solver, implies( premise, logic::equal( lhs, rhs ) ) ) );
+  }
+
+  Solver& solver;
+  std::vector< read > reads;
+  std::vector< equality > equalities;
+  std::unordered_map< unsigned, std::vector< unsigned > > equalities_of;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,106 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool backend_model::load( const std::string& filename )
+{
+  std::ifstream is( filename.c_str() );
+  if ( !is )
+  {
+    std::cerr << "[e] cannot open backend model " << filename << '\n';
+    return false;
+  }
+
+  const std::vector< std::string >& names = feature_names();
+  std::string line;
+  unsigned n = 0u;
+  while ( std::getline( is, line ) )
+  {
+    ++n;
+    if ( line.empty() || line[0] == '#' )
+    {
+      continue;
+    }
+
+    std::istringstream ss( line );
+    std::string backend, feature;
+    double weight;
+    if ( !( ss >> backend >> feature >> weight ) )
+    {
+      std::cerr << "[e] " << filename << ':' << n << ": expected <backend> <feature> <weight>\n";
+      return false;
+    }
+    if ( feature != "bias" && std::find( names.begin(), names.end(), feature ) == names.end() )
+    {
+      std::cerr << "[e] " << filename << ':' << n << ": unknown feature " << feature << '\n';
+      return false;
+    }
+    weights[backend][feature] = weight;
+  }
+  return true;
+}
+
+std::string backend_model::select( const instance_features& features, const std::vector< std::string >& candidates ) const
+{
+  const std::vector< std::string >& names = feature_names();
+  const std::vector< double > values = feature_values( features );
+
+  std::string best;
+  double best_score = 0.0;
+  for ( const auto& candidate : candidates )
+  {
+    const auto w = weights.find( candidate );
+    if ( w == weights.end() )
+    {
+      continue;
+    }
+
+    double score = 0.0;
+    for ( const auto& term : w->second )
+    {
+      if ( term.first == "bias" )
+      {
+        score += term.second;
+      }
+      else
+      {
+        const unsigned i = std::find( names.begin(), names.end(), term.first ) - names.begin();
+        score += term.second * std::log1p( values[i] );
+      }
+    }
+
+    if ( best.empty() || score > best_score )
+    {
+      best = candidate;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,66 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file backend_model.hpp
+ *
+ * @brief linear model that ranks backends by instance features
+ *
+ * The model is trained offline on the output of smt2_features and
+ * stored as plain text, one weight per line:
+ *
+ *   # comment
+ *   <backend> <feature> <weight>
+ *
+ * where <feature> is a column of smt2_features or `bias'.  The score
+ * of a backend is bias + sum of weight * log(1 + value) over its
+ * features; the backend with the highest score is selected.  Scores
+ * can be, e.g., negated predicted log run times.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "instance_features.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#pragma once
+
+class backend_model
+{
+public:
+  /* returns false and prints an error if the file cannot be read */
+  bool load( const std::string& filename );
+
+  /*
+   * The candidate with the highest score, candidates without weights
+   * are skipped.  Returns an empty string if no candidate is known.
+   */
+  std::string select( const instance_features& features, const std::vector< std::string >& candidates ) const;
+
+private:
+  std::map< std::string, std::map< std::string, double > > weights;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
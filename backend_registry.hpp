@@ -0,0 +1,92 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file backend_registry.hpp
+ *
+ * @brief all backends linked into one executable
+ *
+ * The build defines SMT2EVAL_HAVE_<backend> for every backend that was
+ * found, see backends.hpp for the types and traits.  Z3 is always
+ * available.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backends.hpp"
+#include "sat_check.hpp"
+
+#include <string>
+#include <vector>
+
+#pragma once
+
+struct backend_entry
+{
+  std::string name;
+
+  /* checks with the modes selected in the options */
+  bool (*check)( const z3::expr& instance, const checker_options& options );
+
+  /* converts under conversion_mutex(), may run concurrently */
+  bool (*solve)( const z3::expr& instance );
+
+  bool reentrant;
+};
+
+template < typename Solver >
+backend_entry make_backend_entry( const std::string& name )
+{
+  backend_entry entry = { name, &metaSMT_check_satisfiability< Solver >, &solve_component< Solver >, backend_traits< Solver >::reentrant };
+  return entry;
+}
+
+/* the linked backends, Z3 first */
+inline std::vector< backend_entry > available_backends()
+{
+  std::vector< backend_entry > entries;
+  entries.push_back( make_backend_entry< backends::Z3 >( "Z3" ) );
+#ifdef SMT2EVAL_HAVE_Boolector
+  entries.push_back( make_backend_entry< backends::Boolector >( "Boolector" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_CVC4
+  entries.push_back( make_backend_entry< backends::CVC4 >( "CVC4" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_STP
+  entries.push_back( make_backend_entry< backends::STP >( "STP" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_SMT2
+  entries.push_back( make_backend_entry< backends::SMT2 >( "SMT2" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_MiniSat
+  entries.push_back( make_backend_entry< backends::MiniSat >( "MiniSat" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_picosat
+  entries.push_back( make_backend_entry< backends::picosat >( "picosat" ) );
+#endif
+#ifdef SMT2EVAL_HAVE_lingeling
+  entries.push_back( make_backend_entry< backends::lingeling >( "lingeling" ) );
+#endif
+  return entries;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
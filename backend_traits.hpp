@@ -0,0 +1,91 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file backend_traits.hpp
+ *
+ * @brief properties of the metaSMT backends used by the checkers
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/BitBlast.hpp>
+#include <metaSMT/backend/SAT_Clause.hpp>
+
+#include <mutex>
+
+#pragma once
+
+/**
+ * Backends are assumed to be reentrant, i.e., several solver contexts
+ * of the same type may solve concurrently in different threads.  A
+ * checker specializes this template for backends that keep global
+ * state.
+ */
+template < typename Solver >
+struct backend_traits
+{
+  static const bool reentrant = true;
+};
+
+/**
+ * Backends that bit-blast to a SAT solver.  For those, `type` is the
+ * underlying SAT solver which can also be used directly on a CNF.
+ */
+template < typename Solver >
+struct sat_backend
+{
+  static const bool value = false;
+};
+
+template < typename SatSolver >
+struct sat_backend< metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause< SatSolver > > > >
+{
+  static const bool value = true;
+  using type = SatSolver;
+};
+
+/**
+ * Backends that support metaSMT's array frontend.  Arrays are
+ * converted natively for those, all other backends handle arrays with
+ * lemmas on demand.  A checker specializes this template for its
+ * backend.
+ */
+template < typename Solver >
+struct array_backend
+{
+  static const bool value = false;
+};
+
+/**
+ * metaSMT allocates the identifiers of new variables from a
+ * process-wide counter, hence building terms is serialized even if
+ * solving runs in parallel.
+ */
+inline std::mutex& conversion_mutex()
+{
+  static std::mutex m;
+  return m;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,164 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file backends.hpp
+ *
+ * @brief the metaSMT backends and their traits
+ *
+ * Declares the backends for which SMT2EVAL_HAVE_<backend> is defined.
+ * The single-backend checkers define the macro of their backend before
+ * including this file, the build defines it for every backend linked
+ * into smt2_sat_check_auto and smt2_consistency_check_all.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/BitBlast.hpp>
+#include <metaSMT/backend/SAT_Clause.hpp>
+
+#ifdef SMT2EVAL_HAVE_Z3
+#include <metaSMT/backend/Z3_Backend.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_Boolector
+#include <metaSMT/backend/Boolector.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_CVC4
+#include <metaSMT/backend/CVC4.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_STP
+#include <metaSMT/backend/STP.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_SMT2
+#include <metaSMT/backend/SMT2.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_MiniSat
+#include <metaSMT/backend/MiniSAT.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_picosat
+#include <metaSMT/backend/PicoSAT.hpp>
+#endif
+#ifdef SMT2EVAL_HAVE_lingeling
+#include <metaSMT/backend/Lingeling.hpp>
+#endif
+
+#pragma once
+
+namespace backends
+{
+
+#ifdef SMT2EVAL_HAVE_Z3
+using Z3 = metaSMT::DirectSolver_Context< metaSMT::solver::Z3_Backend >;
+#endif
+#ifdef SMT2EVAL_HAVE_Boolector
+using Boolector = metaSMT::DirectSolver_Context< metaSMT::solver::Boolector >;
+#endif
+#ifdef SMT2EVAL_HAVE_CVC4
+using CVC4 = metaSMT::DirectSolver_Context< metaSMT::solver::CVC4 >;
+#endif
+#ifdef SMT2EVAL_HAVE_STP
+using STP = metaSMT::DirectSolver_Context< metaSMT::solver::STP >;
+#endif
+#ifdef SMT2EVAL_HAVE_SMT2
+using SMT2 = metaSMT::DirectSolver_Context< metaSMT::solver::SMT2 >;
+#endif
+#ifdef SMT2EVAL_HAVE_MiniSat
+using MiniSat = metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause < metaSMT::solver::MiniSAT > > >;
+#endif
+#ifdef SMT2EVAL_HAVE_picosat
+using picosat = metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause < metaSMT::solver::PicoSAT > > >;
+#endif
+#ifdef SMT2EVAL_HAVE_lingeling
+using lingeling = metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause < metaSMT::solver::Lingeling > > >;
+#endif
+
+}
+
+/* Z3, Boolector, CVC4 and SMT2 convert arrays with metaSMT's array frontend */
+#ifdef SMT2EVAL_HAVE_Z3
+template <>
+struct array_backend< backends::Z3 >
+{
+  static const bool value = true;
+};
+#endif
+
+#ifdef SMT2EVAL_HAVE_Boolector
+template <>
+struct array_backend< backends::Boolector >
+{
+  static const bool value = true;
+};
+#endif
+
+#ifdef SMT2EVAL_HAVE_CVC4
+template <>
+struct array_backend< backends::CVC4 >
+{
+  static const bool value = true;
+};
+#endif
+
+/*
+ * STP keeps global state, hence contexts must not solve concurrently.
+ */
+#ifdef SMT2EVAL_HAVE_STP
+template <>
+struct backend_traits< backends::STP >
+{
+  static const bool reentrant = false;
+};
+#endif
+
+/*
+ * The SMT2 backend communicates with an external solver process through
+ * fixed files, hence contexts must not solve concurrently.
+ */
+#ifdef SMT2EVAL_HAVE_SMT2
+template <>
+struct backend_traits< backends::SMT2 >
+{
+  static const bool reentrant = false;
+};
+
+template <>
+struct array_backend< backends::SMT2 >
+{
+  static const bool value = true;
+};
+#endif
+
+/*
+ * PicoSAT keeps global state, hence contexts must not solve concurrently.
+ */
+#ifdef SMT2EVAL_HAVE_picosat
+template <>
+struct backend_traits< backends::picosat >
+{
+  static const bool reentrant = false;
+};
+#endif
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,406 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file batch_pipeline.hpp
+ *
+ * @brief batch runs as a pipeline of parse, convert and solve stages
+ *
+ * With --batch --pipeline the instances are checked in the checker
+ * process by three groups of threads.  The parse stage prefetches the
+ * next files and parses them with Z3, the convert stage preprocesses
+ * and converts them to a fresh solver context, and the solve stage
+ * runs the backend.  The stages are connected by bounded queues; a
+ * stage blocks when its output queue is full, hence at most
+ * threads + --queue-size instances per stage are in memory.  The Z3
+ * context of an instance is released after its conversion unless
+ * refinements still need the Z3 terms.
+ *
+ * Backends without reentrant contexts (see backend_traits) solve in
+ * the convert stage with one thread, such that only parsing overlaps
+ * with the backend.  Unlike the worker pool of batch_runner, a crash
+ * ends the whole run and --timeout is not supported.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+#include "batch_runner.hpp"
+#include "checker_options.hpp"
+#include "parallel_utils.hpp"
+#include "preprocess.hpp"
+#include "simulation.hpp"
+#include "snapshot.hpp"
+#include "z3_expr_visitor.hpp"
+
+#include <z3++.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#pragma once
+
+/* asks the kernel to read `path' ahead while the current file is parsed */
+inline void prefetch_file( const std::string& path )
+{
+  const int fd = open( path.c_str(), O_RDONLY );
+  if ( fd >= 0 )
+  {
+    posix_fadvise( fd, 0, 0, POSIX_FADV_WILLNEED );
+    close( fd );
+  }
+}
+
+/**
+ * Seconds the threads of a stage spent working, waiting for input
+ * and blocked by a full output queue.
+ */
+struct stage_counters
+{
+  stage_counters()
+    : items( 0u )
+    , busy( 0.0 )
+    , starved( 0.0 )
+    , blocked( 0.0 )
+  {}
+
+  void add( const stage_counters& other )
+  {
+    items += other.items;
+    busy += other.busy;
+    starved += other.starved;
+    blocked += other.blocked;
+  }
+
+  unsigned items;
+  double busy;
+  double starved;
+  double blocked;
+};
+
+inline void print_stage_counters( const char *name, unsigned threads, const stage_counters& c, double seconds )
+{
+  const double total = threads * seconds;
+  const double scale = total > 0.0 ? 100.0 / total : 0.0;
+  std::cout << "[i] stage " << name << ": " << threads << " threads, " << c.items << " instances, "
+            << ( scale * c.busy ) << "% busy, " << ( scale * c.starved ) << "% waiting for input, "
+            << ( scale * c.blocked ) << "% blocked by a full queue\n";
+}
+
+template < typename Solver >
+struct pipeline_item
+{
+  explicit pipeline_item( unsigned index )
+    : index( index )
+    , seconds( 0.0 )
+  {}
+
+  ~pipeline_item()
+  {
+    release_z3();
+  }
+
+  /* the generator refers to the Z3 terms, which refer to the context */
+  void release_z3()
+  {
+    generator.reset();
+    instance.reset();
+    ctx.reset();
+  }
+
+  unsigned index;
+  std::unique_ptr< z3::context > ctx;
+  std::unique_ptr< z3::expr > instance;
+  std::unique_ptr< Solver > solver;
+  std::unique_ptr< result_type_generator< Solver > > generator;
+  double seconds;  /* spent in the stages, without waiting */
+};
+
+/* solves a converted item, refinements create terms under the conversion lock */
+template < typename Solver >
+bool solve_pipeline_item( pipeline_item< Solver >& item )
+{
+  if ( !item.generator )
+  {
+    return metaSMT::solve( *item.solver );
+  }
+  while ( metaSMT::solve( *item.solver ) )
+  {
+    std::lock_guard< std::mutex > lock( conversion_mutex() );
+    if ( !item.generator->refine() )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Checks the instances of the list options.filename like
+ * metaSMT_check_file and prints them like run_batch, followed by the
+ * counters of every stage.
+ */
+template < typename Solver >
+int run_pipeline( const checker_options& options, const char *(*describe)( int code ) )
+{
+  using clock_type = std::chrono::steady_clock;
+  typedef std::unique_ptr< pipeline_item< Solver > > item_ptr;
+
+  std::vector< std::string > instances;
+  if ( !read_instance_list( options.filename, instances ) )
+  {
+    return -1;
+  }
+
+  /* per-instance statistics would interleave */
+  checker_options quiet = options;
+  quiet.stats = false;
+
+  const bool reentrant = backend_traits< Solver >::reentrant;
+  const unsigned convert_threads = reentrant ? options.convert_threads : 1u;
+  if ( !reentrant )
+  {
+    std::cout << "[i] pipeline: the backend keeps global state, conversion and solving share one thread\n";
+  }
+
+  std::vector< batch_result > results( instances.size() );
+  for ( unsigned i = 0u; i < instances.size(); ++i )
+  {
+    results[i].instance = instances[i];
+    results[i].status = batch_result::completed;
+    results[i].code = -1;
+    results[i].signal = 0;
+    results[i].seconds = 0.0;
+  }
+
+  bounded_queue< item_ptr > parsed( options.queue_size ), converted( options.queue_size );
+  stage_counters counters[3];
+  std::mutex counters_mutex;
+  std::atomic< unsigned > next( 0u );
+
+  auto seconds_since = []( const clock_type::time_point& start ) {
+    return std::chrono::duration< double >( clock_type::now() - start ).count();
+  };
+  auto finish = [&]( pipeline_item< Solver >& item, int code ) {
+    results[item.index].code = code;
+    results[item.index].seconds = item.seconds;
+  };
+  auto report = [&]( unsigned stage, const stage_counters& local ) {
+    std::lock_guard< std::mutex > lock( counters_mutex );
+    counters[stage].add( local );
+  };
+
+  /*** Prefetch and parse ***/
+  auto parse_stage = [&]() {
+    stage_counters local;
+    for ( unsigned i = next++; i < instances.size(); i = next++ )
+    {
+      if ( i + options.parse_threads < instances.size() )
+      {
+        prefetch_file( instances[i + options.parse_threads] );
+      }
+
+      const auto start = clock_type::now();
+      item_ptr item( new pipeline_item< Solver >( i ) );
+      try
+      {
+        item->ctx.reset( new z3::context );
+        item->instance.reset( new z3::expr( load_instance( *item->ctx, instances[i] ) ) );
+      }
+      catch ( const z3::exception& e )
+      {
+        std::cerr << "[e] " << instances[i] << ": " << e.msg() << '\n';
+        item->seconds += seconds_since( start );
+        finish( *item, -1 );
+        item.reset();
+      }
+      ++local.items;
+      local.busy += seconds_since( start );
+
+      if ( item )
+      {
+        item->seconds += seconds_since( start );
+        const auto wait = clock_type::now();
+        parsed.push( std::move( item ) );
+        local.blocked += seconds_since( wait );
+      }
+    }
+    report( 0u, local );
+  };
+
+  /*** Simulate, preprocess and convert ***/
+  auto convert_stage = [&]() {
+    stage_counters local;
+    item_ptr item;
+    for ( ;; )
+    {
+      const auto wait = clock_type::now();
+      if ( !parsed.pop( item ) )
+      {
+        break;
+      }
+      local.starved += seconds_since( wait );
+
+      const auto start = clock_type::now();
+      int code = -1;
+      bool solve = false;
+      try
+      {
+        if ( quiet.simulate > 0u && find_model_by_simulation( *item->instance, quiet ) )
+        {
+          code = sat_by_simulation;
+        }
+        else
+        {
+          {
+            const z3::expr instance = preprocess_instance( *item->instance, quiet );
+            std::lock_guard< std::mutex > lock( conversion_mutex() );
+            item->solver.reset( new Solver );
+            item->generator.reset( new result_type_generator< Solver >( *item->solver ) );
+            item->generator->abstract_nonlinear( quiet.cegar );
+            metaSMT::assertion( *item->solver, ( *item->generator )( instance ) );
+          }
+          if ( !item->generator->needs_refinement() )
+          {
+            item->release_z3();
+          }
+          solve = true;
+        }
+
+        if ( solve && !reentrant )
+        {
+          code = solve_pipeline_item( *item ) ? 1 : 0;
+          solve = false;
+        }
+      }
+      catch ( const z3::exception& e )
+      {
+        std::cerr << "[e] " << instances[item->index] << ": " << e.msg() << '\n';
+        solve = false;
+      }
+      catch ( const std::exception& e )
+      {
+        std::cerr << "[e] " << instances[item->index] << ": " << e.what() << '\n';
+        solve = false;
+      }
+      ++local.items;
+      local.busy += seconds_since( start );
+      item->seconds += seconds_since( start );
+
+      if ( solve )
+      {
+        const auto blocked = clock_type::now();
+        converted.push( std::move( item ) );
+        local.blocked += seconds_since( blocked );
+      }
+      else
+      {
+        finish( *item, code );
+        item.reset();
+      }
+    }
+    report( 1u, local );
+  };
+
+  /*** Solve ***/
+  auto solve_stage = [&]() {
+    stage_counters local;
+    item_ptr item;
+    for ( ;; )
+    {
+      const auto wait = clock_type::now();
+      if ( !converted.pop( item ) )
+      {
+        break;
+      }
+      local.starved += seconds_since( wait );
+
+      const auto start = clock_type::now();
+      int code = -1;
+      try
+      {
+        code = solve_pipeline_item( *item ) ? 1 : 0;
+      }
+      catch ( const std::exception& e )
+      {
+        std::cerr << "[e] " << instances[item->index] << ": " << e.what() << '\n';
+      }
+      item->seconds += seconds_since( start );
+      finish( *item, code );
+      item.reset();
+      ++local.items;
+      local.busy += seconds_since( start );
+    }
+    report( 2u, local );
+  };
+
+  const auto start = clock_type::now();
+  std::vector< std::thread > parsers, converters, solvers;
+  for ( unsigned t = 0u; t < options.parse_threads; ++t )
+  {
+    parsers.push_back( std::thread( parse_stage ) );
+  }
+  for ( unsigned t = 0u; t < convert_threads; ++t )
+  {
+    converters.push_back( std::thread( convert_stage ) );
+  }
+  for ( unsigned t = 0u; t < options.solve_threads; ++t )
+  {
+    solvers.push_back( std::thread( solve_stage ) );
+  }
+
+  /* a stage ends when its input is closed and drained */
+  for ( auto& t : parsers )
+  {
+    t.join();
+  }
+  parsed.close();
+  for ( auto& t : converters )
+  {
+    t.join();
+  }
+  converted.close();
+  for ( auto& t : solvers )
+  {
+    t.join();
+  }
+  const double seconds = seconds_since( start );
+
+  const int code = report_batch( results, describe );
+  std::cout << "[i] pipeline: " << seconds << " s\n";
+  print_stage_counters( "parse", options.parse_threads, counters[0u], seconds );
+  print_stage_counters( "convert", convert_threads, counters[1u], seconds );
+  print_stage_counters( "solve", options.solve_threads, counters[2u], seconds );
+  return code;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
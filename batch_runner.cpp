@@ -0,0 +1,416 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch_runner.hpp"
+
+#include <z3++.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+struct worker
+{
+  pid_t pid;
+  int request;   /* paths to the worker */
+  int response;  /* exit codes from the worker */
+  int instance;  /* index of the running instance, -1 if idle */
+  clock_type::time_point start;
+  std::string buffer;
+};
+
+bool write_all( int fd, const std::string& s )
+{
+  std::size_t pos = 0u;
+  while ( pos < s.size() )
+  {
+    const ssize_t n = write( fd, s.data() + pos, s.size() - pos );
+    if ( n < 0 )
+    {
+      return false;
+    }
+    pos += n;
+  }
+  return true;
+}
+
+/* reads a line from `fd', returns false on end of file */
+bool read_line( int fd, std::string& line )
+{
+  line.clear();
+  char c;
+  for ( ;; )
+  {
+    const ssize_t n = read( fd, &c, 1u );
+    if ( n <= 0 )
+    {
+      return false;
+    }
+    if ( c == '\n' )
+    {
+      return true;
+    }
+    line.push_back( c );
+  }
+}
+
+void worker_main( int request, int response, const checker_options& options, batch_job job, void (*warm_up)() )
+{
+  warm_up();
+
+  std::string path;
+  while ( read_line( request, path ) )
+  {
+    checker_options opts = options;
+    opts.filename = path;
+
+    int code = -1;
+    try
+    {
+      code = job( opts );
+    }
+    catch ( const z3::exception& e )
+    {
+      std::cerr << "[e] " << path << ": " << e.msg() << '\n';
+    }
+    catch ( const std::exception& e )
+    {
+      std::cerr << "[e] " << path << ": " << e.what() << '\n';
+    }
+    std::cout.flush();
+
+    if ( !write_all( response, std::to_string( code ) + '\n' ) )
+    {
+      return;
+    }
+  }
+}
+
+void start_worker( std::vector< worker >& workers, unsigned k, const checker_options& options, batch_job job, void (*warm_up)() )
+{
+  int request[2], response[2];
+  if ( pipe( request ) != 0 || pipe( response ) != 0 )
+  {
+    std::cerr << "[e] cannot create pipes for a worker: " << std::strerror( errno ) << '\n';
+    std::exit( -1 );
+  }
+
+  /* the child must not write out what the parent buffered */
+  std::cout.flush();
+  std::cerr.flush();
+
+  const pid_t pid = fork();
+  if ( pid < 0 )
+  {
+    std::cerr << "[e] cannot fork a worker: " << std::strerror( errno ) << '\n';
+    std::exit( -1 );
+  }
+
+  if ( pid == 0 )
+  {
+    /* the request pipes of the siblings must only be open in the parent,
+       otherwise closing them does not stop the siblings */
+    for ( unsigned i = 0u; i < workers.size(); ++i )
+    {
+      if ( i != k && workers[i].pid > 0 )
+      {
+        close( workers[i].request );
+        close( workers[i].response );
+      }
+    }
+    close( request[1] );
+    close( response[0] );
+    worker_main( request[0], response[1], options, job, warm_up );
+    std::cout.flush();
+    _exit( 0 );
+  }
+
+  close( request[0] );
+  close( response[1] );
+  worker& w = workers[k];
+  w.pid = pid;
+  w.request = request[1];
+  w.response = response[0];
+  w.instance = -1;
+  w.buffer.clear();
+}
+
+/* closes the pipes and reaps the worker, returns its wait status */
+int stop_worker( worker& w, bool kill_it )
+{
+  if ( kill_it )
+  {
+    kill( w.pid, SIGKILL );
+  }
+  close( w.request );
+  close( w.response );
+
+  int status = 0;
+  while ( waitpid( w.pid, &status, 0 ) < 0 && errno == EINTR ) {}
+  w.pid = 0;
+  w.instance = -1;
+  return status;
+}
+
+double seconds_since( const clock_type::time_point& start )
+{
+  return std::chrono::duration< double >( clock_type::now() - start ).count();
+}
+
+void finish( batch_result& r, const std::string& instance, batch_result::status_t status, int code, int signal, double seconds )
+{
+  r.instance = instance;
+  r.status = status;
+  r.code = code;
+  r.signal = signal;
+  r.seconds = seconds;
+}
+
+}
+
+std::vector< batch_result > run_worker_pool( const std::vector< std::string >& instances, const checker_options& options,
+                                             batch_job job, void (*warm_up)(), unsigned workers, unsigned timeout )
+{
+  std::vector< batch_result > results( instances.size() );
+  if ( instances.empty() )
+  {
+    return results;
+  }
+
+  /* a worker may die while a path is written to it */
+  signal( SIGPIPE, SIG_IGN );
+
+  worker idle = { 0, -1, -1, -1, clock_type::time_point(), std::string() };
+  std::vector< worker > pool( std::max( 1u, std::min< unsigned >( workers, instances.size() ) ), idle );
+  for ( unsigned k = 0u; k < pool.size(); ++k )
+  {
+    start_worker( pool, k, options, job, warm_up );
+  }
+
+  /* workers that die before they accept an instance, e.g., in warm_up, since the last answer */
+  const unsigned max_failed_starts = 3u * pool.size();
+  unsigned failed_starts = 0u;
+
+  unsigned next = 0u, done = 0u;
+  while ( done < instances.size() )
+  {
+    /*** Hand out instances to idle workers ***/
+    for ( unsigned k = 0u; k < pool.size() && next < instances.size(); ++k )
+    {
+      worker& w = pool[k];
+      if ( w.instance >= 0 )
+      {
+        continue;
+      }
+      while ( next < instances.size() && !write_all( w.request, instances[next] + '\n' ) )
+      {
+        /* died while idle, retry with a fresh worker */
+        const int status = stop_worker( w, true );
+        if ( ++failed_starts > max_failed_starts )
+        {
+          std::cerr << "[e] " << failed_starts << " workers died before accepting an instance, skipping the remaining "
+                    << instances.size() - next << " instances\n";
+          for ( ; next < instances.size(); ++next, ++done )
+          {
+            finish( results[next], instances[next], batch_result::crashed, -1, WIFSIGNALED( status ) ? WTERMSIG( status ) : 0, 0.0 );
+          }
+          break;
+        }
+        start_worker( pool, k, options, job, warm_up );
+      }
+      if ( w.pid == 0 )
+      {
+        break;
+      }
+      w.instance = next++;
+      w.start = clock_type::now();
+    }
+
+    /*** Wait for an answer or the next deadline ***/
+    std::vector< pollfd > fds;
+    std::vector< unsigned > fd_worker;
+    int wait_ms = -1;
+    for ( unsigned k = 0u; k < pool.size(); ++k )
+    {
+      if ( pool[k].instance < 0 )
+      {
+        continue;
+      }
+      pollfd p = { pool[k].response, POLLIN, 0 };
+      fds.push_back( p );
+      fd_worker.push_back( k );
+      if ( timeout > 0u )
+      {
+        const int left = static_cast< int >( ( timeout - seconds_since( pool[k].start ) ) * 1000.0 );
+        wait_ms = std::max( 0, wait_ms < 0 ? left : std::min( wait_ms, left ) );
+      }
+    }
+    if ( fds.empty() )
+    {
+      continue;
+    }
+    if ( poll( fds.data(), fds.size(), wait_ms ) < 0 && errno != EINTR )
+    {
+      std::cerr << "[e] poll failed: " << std::strerror( errno ) << '\n';
+      std::exit( -1 );
+    }
+
+    /*** Collect answers, crashes and timeouts ***/
+    for ( unsigned i = 0u; i < fds.size(); ++i )
+    {
+      const unsigned k = fd_worker[i];
+      worker& w = pool[k];
+      batch_result& r = results[w.instance];
+      const double seconds = seconds_since( w.start );
+
+      if ( fds[i].revents != 0 )
+      {
+        char buf[64];
+        const ssize_t n = read( w.response, buf, sizeof( buf ) );
+        if ( n > 0 )
+        {
+          w.buffer.append( buf, n );
+          const std::size_t eol = w.buffer.find( '\n' );
+          if ( eol != std::string::npos )
+          {
+            finish( r, instances[w.instance], batch_result::completed, std::atoi( w.buffer.substr( 0u, eol ).c_str() ), 0, seconds );
+            w.buffer.erase( 0u, eol + 1u );
+            w.instance = -1;
+            failed_starts = 0u;
+            ++done;
+          }
+          continue;
+        }
+
+        /* end of file: the worker is gone */
+        const std::string& instance = instances[w.instance];
+        const int status = stop_worker( w, false );
+        finish( r, instance, batch_result::crashed, -1, WIFSIGNALED( status ) ? WTERMSIG( status ) : 0, seconds );
+        ++done;
+        start_worker( pool, k, options, job, warm_up );
+      }
+      else if ( timeout > 0u && seconds >= timeout )
+      {
+        finish( r, instances[w.instance], batch_result::timed_out, -1, SIGKILL, seconds );
+        stop_worker( w, true );
+        ++done;
+        start_worker( pool, k, options, job, warm_up );
+      }
+    }
+  }
+
+  for ( auto& w : pool )
+  {
+    if ( w.pid > 0 )
+    {
+      stop_worker( w, false );
+    }
+  }
+  return results;
+}
+
+bool read_instance_list( const std::string& filename, std::vector< std::string >& instances )
+{
+  std::ifstream is( filename.c_str() );
+  if ( !is )
+  {
+    std::cerr << "[e] cannot open instance list " << filename << '\n';
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline( is, line ) )
+  {
+    if ( !line.empty() && line[0] != '#' )
+    {
+      instances.push_back( line );
+    }
+  }
+  return true;
+}
+
+int report_batch( const std::vector< batch_result >& results, const char *(*describe)( int code ) )
+{
+  unsigned failures = 0u;
+  std::map< std::string, std::pair< unsigned, double > > outcomes;  /* instances and seconds per answer */
+  for ( const auto& r : results )
+  {
+    switch ( r.status )
+    {
+    case batch_result::completed:
+      std::cout << ( r.code == -1 ? "[e] " : "[i] " ) << r.instance << ": " << describe( r.code );
+      failures += ( r.code == -1 );
+      ++outcomes[describe( r.code )].first;
+      outcomes[describe( r.code )].second += r.seconds;
+      break;
+    case batch_result::crashed:
+      std::cout << "[e] " << r.instance << ": crashed";
+      if ( r.signal != 0 )
+      {
+        std::cout << " (" << strsignal( r.signal ) << ")";
+      }
+      ++failures;
+      break;
+    case batch_result::timed_out:
+      std::cout << "[e] " << r.instance << ": timeout";
+      ++failures;
+      break;
+    }
+    std::cout << ", " << r.seconds << " s\n";
+  }
+  std::cout << "[i] batch: " << results.size() << " instances, " << failures << " failed\n";
+  for ( const auto& o : outcomes )
+  {
+    std::cout << "[i]   " << o.first << ": " << o.second.first << " instances, " << o.second.second << " s\n";
+  }
+  return failures == 0u ? 0 : -1;
+}
+
+int run_batch( const checker_options& options, batch_job job, void (*warm_up)(), const char *(*describe)( int code ) )
+{
+  std::vector< std::string > instances;
+  if ( !read_instance_list( options.filename, instances ) )
+  {
+    return -1;
+  }
+
+  return report_batch( run_worker_pool( instances, options, job, warm_up, checker_threads( options ), options.timeout ), describe );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
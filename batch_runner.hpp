@@ -0,0 +1,95 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file batch_runner.hpp
+ *
+ * @brief crash-isolated batch runs in a pool of worker processes
+ *
+ * With --batch the filename of a checker names a list of instances,
+ * one path per line.  The checker forks a fixed number of workers
+ * which initialize the backend once and then receive the paths over
+ * a pipe, one at a time.  A worker that crashes (e.g., on an
+ * assertion for an unsupported operator) or exceeds --timeout is
+ * killed and replaced; the instance is recorded as failed and the
+ * run continues with the next one.  Workers that die before they
+ * accept an instance are replaced a bounded number of times, then
+ * the remaining instances are recorded as crashed.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "checker_options.hpp"
+
+#include <string>
+#include <vector>
+
+#pragma once
+
+/* checks options.filename, returns the exit code of the checker */
+typedef int (*batch_job)( const checker_options& options );
+
+struct batch_result
+{
+  enum status_t { completed, crashed, timed_out };
+
+  std::string instance;
+  status_t status;
+  int code;       /* return value of the job if completed */
+  int signal;     /* terminating signal if crashed, 0 on a plain exit */
+  double seconds;
+};
+
+/**
+ * Runs `job' for every instance on `workers' processes.  `warm_up'
+ * is called once in every worker before the first instance, `timeout'
+ * is in seconds (0 = none).  The results are in the order of
+ * `instances'.
+ */
+std::vector< batch_result > run_worker_pool( const std::vector< std::string >& instances, const checker_options& options,
+                                             batch_job job, void (*warm_up)(), unsigned workers, unsigned timeout );
+
+/* reads one path per line, lines starting with # are skipped */
+bool read_instance_list( const std::string& filename, std::vector< std::string >& instances );
+
+/**
+ * Prints one line per instance and a summary.  `describe' names the
+ * exit codes of the job, a code of -1 is a failure.  Returns 0 if no
+ * instance failed.
+ */
+int report_batch( const std::vector< batch_result >& results, const char *(*describe)( int code ) );
+
+/**
+ * Reads the instance list options.filename, runs the pool and prints
+ * one line per instance.  `describe' names the exit codes of `job',
+ * a code of -1 is a failure.  Returns 0 if no instance failed.
+ */
+int run_batch( const checker_options& options, batch_job job, void (*warm_up)(), const char *(*describe)( int code ) );
+
+/* creates and destroys a solver context to initialize the backend */
+template < typename Solver >
+void warm_up_backend()
+{
+  Solver solver_ctx;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,453 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bv_value.hpp"
+
+#include <cassert>
+
+namespace
+{
+
+unsigned num_words( unsigned width )
+{
+  return width == 0u ? 1u : ( width + 63u ) / 64u;
+}
+
+uint64_t mask( unsigned width )
+{
+  return width >= 64u ? ~uint64_t( 0u ) : ( uint64_t( 1u ) << width ) - 1u;
+}
+
+}
+
+bv_value::bv_value()
+  : w( 0u )
+  , words( 1u, 0u )
+{}
+
+bv_value::bv_value( unsigned width, uint64_t value )
+  : w( width )
+  , words( num_words( width ), 0u )
+{
+  words[0u] = value;
+  normalize();
+}
+
+bv_value bv_value::from_binary( const std::string& bits )
+{
+  bv_value r( bits.size(), 0u );
+  for ( unsigned i = 0u; i < bits.size(); ++i )
+  {
+    if ( bits[bits.size() - 1u - i] == '1' )
+    {
+      r.words[i / 64u] |= uint64_t( 1u ) << ( i % 64u );
+    }
+  }
+  return r;
+}
+
+std::string bv_value::to_binary() const
+{
+  std::string s( w, '0' );
+  for ( unsigned i = 0u; i < w; ++i )
+  {
+    if ( bit( i ) )
+    {
+      s[w - 1u - i] = '1';
+    }
+  }
+  return s;
+}
+
+bool bv_value::is_zero() const
+{
+  for ( const auto x : words )
+  {
+    if ( x != 0u )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void bv_value::normalize()
+{
+  if ( w % 64u != 0u )
+  {
+    words.back() &= mask( w % 64u );
+  }
+  else if ( w == 0u )
+  {
+    words[0u] = 0u;
+  }
+}
+
+/******************************************************************************
+ * bitwise                                                                    *
+ ******************************************************************************/
+
+bv_value bv_not( const bv_value& a )
+{
+  bv_value r = a;
+  for ( auto& x : r.words )
+  {
+    x = ~x;
+  }
+  r.normalize();
+  return r;
+}
+
+bv_value bv_and( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  bv_value r = a;
+  for ( unsigned i = 0u; i < r.words.size(); ++i )
+  {
+    r.words[i] &= b.words[i];
+  }
+  return r;
+}
+
+bv_value bv_or( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  bv_value r = a;
+  for ( unsigned i = 0u; i < r.words.size(); ++i )
+  {
+    r.words[i] |= b.words[i];
+  }
+  return r;
+}
+
+bv_value bv_xor( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  bv_value r = a;
+  for ( unsigned i = 0u; i < r.words.size(); ++i )
+  {
+    r.words[i] ^= b.words[i];
+  }
+  return r;
+}
+
+/******************************************************************************
+ * arithmetic                                                                 *
+ ******************************************************************************/
+
+bv_value bv_add( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  bv_value r = a;
+  if ( a.fits_word() )
+  {
+    r.words[0u] += b.words[0u];
+  }
+  else
+  {
+    uint64_t carry = 0u;
+    for ( unsigned i = 0u; i < r.words.size(); ++i )
+    {
+      const uint64_t x = a.words[i];
+      const uint64_t s = x + b.words[i];
+      r.words[i] = s + carry;
+      carry = ( s < x ) || ( r.words[i] < s ) ? 1u : 0u;
+    }
+  }
+  r.normalize();
+  return r;
+}
+
+bv_value bv_neg( const bv_value& a )
+{
+  return bv_add( bv_not( a ), bv_value( a.w, 1u ) );
+}
+
+bv_value bv_sub( const bv_value& a, const bv_value& b )
+{
+  return bv_add( a, bv_neg( b ) );
+}
+
+bv_value bv_mul( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  bv_value r( a.w, 0u );
+  if ( a.fits_word() )
+  {
+    r.words[0u] = a.words[0u] * b.words[0u];
+    r.normalize();
+    return r;
+  }
+
+  /* schoolbook on 32-bit limbs, only the low half of the product is kept */
+  const unsigned n = 2u * a.words.size();
+  std::vector< uint32_t > x( n ), y( n ), z( n, 0u );
+  for ( unsigned i = 0u; i < a.words.size(); ++i )
+  {
+    x[2u * i] = static_cast< uint32_t >( a.words[i] );
+    x[2u * i + 1u] = static_cast< uint32_t >( a.words[i] >> 32u );
+    y[2u * i] = static_cast< uint32_t >( b.words[i] );
+    y[2u * i + 1u] = static_cast< uint32_t >( b.words[i] >> 32u );
+  }
+  for ( unsigned i = 0u; i < n; ++i )
+  {
+    uint64_t carry = 0u;
+    for ( unsigned j = 0u; i + j < n; ++j )
+    {
+      const uint64_t t = uint64_t( x[i] ) * y[j] + z[i + j] + carry;
+      z[i + j] = static_cast< uint32_t >( t );
+      carry = t >> 32u;
+    }
+  }
+  for ( unsigned i = 0u; i < r.words.size(); ++i )
+  {
+    r.words[i] = uint64_t( z[2u * i] ) | ( uint64_t( z[2u * i + 1u] ) << 32u );
+  }
+  r.normalize();
+  return r;
+}
+
+void bv_divide( const bv_value& a, const bv_value& b, bv_value& quotient, bv_value& remainder )
+{
+  assert( a.w == b.w );
+  if ( b.is_zero() )
+  {
+    quotient = bv_not( bv_value( a.w, 0u ) );
+    remainder = a;
+    return;
+  }
+
+  if ( a.fits_word() )
+  {
+    quotient = bv_value( a.w, a.words[0u] / b.words[0u] );
+    remainder = bv_value( a.w, a.words[0u] % b.words[0u] );
+    return;
+  }
+
+  /* restoring division, the partial remainder needs one extra bit */
+  bv_value q( a.w, 0u );
+  bv_value r( a.w + 1u, 0u );
+  const bv_value d = bv_zero_extend( b, 1u );
+  for ( unsigned i = a.w; i > 0u; --i )
+  {
+    r = bv_shl( r, 1u );
+    if ( a.bit( i - 1u ) )
+    {
+      r.words[0u] |= 1u;
+    }
+    if ( !bv_ult( r, d ) )
+    {
+      r = bv_sub( r, d );
+      q.words[( i - 1u ) / 64u] |= uint64_t( 1u ) << ( ( i - 1u ) % 64u );
+    }
+  }
+  quotient = q;
+  remainder = bv_extract( r, a.w - 1u, 0u );
+}
+
+bv_value bv_udiv( const bv_value& a, const bv_value& b )
+{
+  bv_value q, r;
+  bv_divide( a, b, q, r );
+  return q;
+}
+
+bv_value bv_urem( const bv_value& a, const bv_value& b )
+{
+  bv_value q, r;
+  bv_divide( a, b, q, r );
+  return r;
+}
+
+bv_value bv_sdiv( const bv_value& a, const bv_value& b )
+{
+  const bv_value q = bv_udiv( a.msb() ? bv_neg( a ) : a, b.msb() ? bv_neg( b ) : b );
+  return a.msb() != b.msb() ? bv_neg( q ) : q;
+}
+
+bv_value bv_srem( const bv_value& a, const bv_value& b )
+{
+  const bv_value r = bv_urem( a.msb() ? bv_neg( a ) : a, b.msb() ? bv_neg( b ) : b );
+  return a.msb() ? bv_neg( r ) : r;
+}
+
+bv_value bv_smod( const bv_value& a, const bv_value& b )
+{
+  const bv_value u = bv_urem( a.msb() ? bv_neg( a ) : a, b.msb() ? bv_neg( b ) : b );
+  if ( u.is_zero() || b.is_zero() )
+  {
+    return b.is_zero() ? a : u;
+  }
+  if ( !a.msb() && !b.msb() )
+  {
+    return u;
+  }
+  else if ( a.msb() && !b.msb() )
+  {
+    return bv_add( bv_neg( u ), b );
+  }
+  else if ( !a.msb() && b.msb() )
+  {
+    return bv_add( u, b );
+  }
+  return bv_neg( u );
+}
+
+/******************************************************************************
+ * shifts and structure                                                       *
+ ******************************************************************************/
+
+bv_value bv_shl( const bv_value& a, unsigned n )
+{
+  bv_value r( a.w, 0u );
+  if ( n >= a.w )
+  {
+    return r;
+  }
+
+  const unsigned ws = n / 64u, bs = n % 64u;
+  for ( unsigned i = r.words.size(); i-- > ws; )
+  {
+    uint64_t x = a.words[i - ws] << bs;
+    if ( bs != 0u && i > ws )
+    {
+      x |= a.words[i - ws - 1u] >> ( 64u - bs );
+    }
+    r.words[i] = x;
+  }
+  r.normalize();
+  return r;
+}
+
+bv_value bv_lshr( const bv_value& a, unsigned n )
+{
+  bv_value r( a.w, 0u );
+  if ( n >= a.w )
+  {
+    return r;
+  }
+
+  const unsigned ws = n / 64u, bs = n % 64u;
+  for ( unsigned i = 0u; i + ws < r.words.size(); ++i )
+  {
+    uint64_t x = a.words[i + ws] >> bs;
+    if ( bs != 0u && i + ws + 1u < r.words.size() )
+    {
+      x |= a.words[i + ws + 1u] << ( 64u - bs );
+    }
+    r.words[i] = x;
+  }
+  return r;
+}
+
+bv_value bv_ashr( const bv_value& a, unsigned n )
+{
+  return a.msb() ? bv_not( bv_lshr( bv_not( a ), n ) ) : bv_lshr( a, n );
+}
+
+bv_value bv_rotate_left( const bv_value& a, unsigned n )
+{
+  n %= a.width();
+  if ( n == 0u )
+  {
+    return a;
+  }
+  return bv_or( bv_shl( a, n ), bv_lshr( a, a.width() - n ) );
+}
+
+bool bv_ult( const bv_value& a, const bv_value& b )
+{
+  assert( a.w == b.w );
+  for ( unsigned i = a.words.size(); i-- > 0u; )
+  {
+    if ( a.words[i] != b.words[i] )
+    {
+      return a.words[i] < b.words[i];
+    }
+  }
+  return false;
+}
+
+bool bv_slt( const bv_value& a, const bv_value& b )
+{
+  return a.msb() != b.msb() ? a.msb() : bv_ult( a, b );
+}
+
+bv_value bv_zero_extend( const bv_value& a, unsigned n )
+{
+  return bv_concat( bv_value( n, 0u ), a );
+}
+
+bv_value bv_sign_extend( const bv_value& a, unsigned n )
+{
+  return bv_concat( a.msb() ? bv_not( bv_value( n, 0u ) ) : bv_value( n, 0u ), a );
+}
+
+bv_value bv_concat( const bv_value& hi, const bv_value& lo )
+{
+  bv_value r( hi.w + lo.w, 0u );
+  if ( r.fits_word() )
+  {
+    r.words[0u] = lo.w == 0u ? hi.words[0u] : ( ( hi.words[0u] << ( lo.w % 64u ) ) | lo.words[0u] );
+    r.normalize();
+    return r;
+  }
+
+  /* lo first, then hi shifted into place */
+  for ( unsigned i = 0u; i < lo.words.size(); ++i )
+  {
+    r.words[i] = lo.words[i];
+  }
+  bv_value h( r.w, 0u );
+  for ( unsigned i = 0u; i < hi.words.size(); ++i )
+  {
+    h.words[i] = hi.words[i];
+  }
+  return bv_or( r, bv_shl( h, lo.w ) );
+}
+
+bv_value bv_extract( const bv_value& a, unsigned hi, unsigned lo )
+{
+  assert( hi < a.w && lo <= hi );
+  const bv_value s = bv_lshr( a, lo );
+  bv_value r( hi - lo + 1u, 0u );
+  for ( unsigned i = 0u; i < r.words.size(); ++i )
+  {
+    r.words[i] = s.words[i];
+  }
+  r.normalize();
+  return r;
+}
+
+unsigned bv_shift_amount( const bv_value& amount )
+{
+  if ( !amount.fits_word() )
+  {
+    const bv_value high = bv_lshr( amount, 64u );
+    if ( !high.is_zero() )
+    {
+      return amount.width();
+    }
+  }
+  return amount.word() >= amount.width() ? amount.width() : static_cast< unsigned >( amount.word() );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
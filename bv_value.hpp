@@ -0,0 +1,101 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bv_value.hpp
+ *
+ * @brief concrete bit-vectors of arbitrary width in 64-bit words
+ *
+ * Values up to 64 bits are computed directly on one machine word, wider
+ * values word by word.  Bits above the width are always zero.  The
+ * semantics of all operations is the one of SMT-LIB, in particular
+ * division by zero is defined: bvudiv yields all ones and bvurem the
+ * dividend.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+class bv_value
+{
+public:
+  bv_value();
+  bv_value( unsigned width, uint64_t value );
+
+  /* most significant bit first */
+  static bv_value from_binary( const std::string& bits );
+  std::string to_binary() const;
+
+  unsigned width() const { return w; }
+  bool bit( unsigned i ) const { return ( words[i / 64u] >> ( i % 64u ) ) & 1u; }
+  bool is_zero() const;
+  bool msb() const { return bit( w - 1u ); }
+
+  /* the value if it fits in 64 bits */
+  bool fits_word() const { return w <= 64u; }
+  uint64_t word() const { return words[0u]; }
+
+  bool operator==( const bv_value& other ) const { return w == other.w && words == other.words; }
+  bool operator!=( const bv_value& other ) const { return !( *this == other ); }
+
+  friend bv_value bv_not( const bv_value& a );
+  friend bv_value bv_and( const bv_value& a, const bv_value& b );
+  friend bv_value bv_or( const bv_value& a, const bv_value& b );
+  friend bv_value bv_xor( const bv_value& a, const bv_value& b );
+  friend bv_value bv_neg( const bv_value& a );
+  friend bv_value bv_add( const bv_value& a, const bv_value& b );
+  friend bv_value bv_sub( const bv_value& a, const bv_value& b );
+  friend bv_value bv_mul( const bv_value& a, const bv_value& b );
+  friend void bv_divide( const bv_value& a, const bv_value& b, bv_value& quotient, bv_value& remainder );
+  friend bv_value bv_shl( const bv_value& a, unsigned n );
+  friend bv_value bv_lshr( const bv_value& a, unsigned n );
+  friend bool bv_ult( const bv_value& a, const bv_value& b );
+  friend bv_value bv_concat( const bv_value& hi, const bv_value& lo );
+  friend bv_value bv_extract( const bv_value& a, unsigned hi, unsigned lo );
+
+private:
+  void normalize();
+
+  unsigned w;
+  std::vector< uint64_t > words;  /* least significant word first */
+};
+
+bv_value bv_udiv( const bv_value& a, const bv_value& b );
+bv_value bv_urem( const bv_value& a, const bv_value& b );
+bv_value bv_sdiv( const bv_value& a, const bv_value& b );
+bv_value bv_srem( const bv_value& a, const bv_value& b );
+bv_value bv_smod( const bv_value& a, const bv_value& b );
+bv_value bv_ashr( const bv_value& a, unsigned n );
+bv_value bv_rotate_left( const bv_value& a, unsigned n );
+bv_value bv_zero_extend( const bv_value& a, unsigned n );
+bv_value bv_sign_extend( const bv_value& a, unsigned n );
+bool bv_slt( const bv_value& a, const bv_value& b );
+
+/* shift amounts saturate at the width */
+unsigned bv_shift_amount( const bv_value& amount );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,279 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "checker_options.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+bool parse_unsigned( const std::string& s, unsigned& value )
+{
+  if ( s.empty() )
+  {
+    return false;
+  }
+  char *end = 0;
+  const unsigned long v = std::strtoul( s.c_str(), &end, 10 );
+  if ( *end != '\0' )
+  {
+    return false;
+  }
+  value = static_cast< unsigned >( v );
+  return true;
+}
+
+/* parses <parse>,<convert>,<solve> with positive numbers */
+bool parse_stage_threads( const std::string& s, checker_options& options )
+{
+  const std::size_t first = s.find( ',' );
+  const std::size_t second = first == std::string::npos ? first : s.find( ',', first + 1u );
+  if ( second == std::string::npos ||
+       !parse_unsigned( s.substr( 0u, first ), options.parse_threads ) ||
+       !parse_unsigned( s.substr( first + 1u, second - first - 1u ), options.convert_threads ) ||
+       !parse_unsigned( s.substr( second + 1u ), options.solve_threads ) )
+  {
+    return false;
+  }
+  return options.parse_threads > 0u && options.convert_threads > 0u && options.solve_threads > 0u;
+}
+
+}
+
+bool parse_checker_options( int argc, char *argv[], checker_options& options )
+{
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string arg = argv[i];
+    if ( arg == "--decompose" )
+    {
+      options.decompose = true;
+    }
+    else if ( arg == "--threads" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.threads ) )
+      {
+        std::cerr << "[e] --threads expects a number\n";
+        return false;
+      }
+    }
+    else if ( arg == "--cube-and-conquer" )
+    {
+      options.cube_and_conquer = true;
+    }
+    else if ( arg == "--cube-depth" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.cube_depth ) )
+      {
+        std::cerr << "[e] --cube-depth expects a number\n";
+        return false;
+      }
+    }
+    else if ( arg == "--export-dimacs" )
+    {
+      if ( i+1 >= argc )
+      {
+        std::cerr << "[e] --export-dimacs expects a filename\n";
+        return false;
+      }
+      options.export_dimacs = argv[++i];
+    }
+    else if ( arg == "--native-parser" )
+    {
+      options.native_parser = true;
+    }
+    else if ( arg == "--low-memory" )
+    {
+      options.low_memory = true;
+    }
+    else if ( arg == "--stats" )
+    {
+      options.stats = true;
+    }
+    else if ( arg == "--cegar" )
+    {
+      options.cegar = true;
+    }
+    else if ( arg == "--model" )
+    {
+      if ( i+1 >= argc )
+      {
+        std::cerr << "[e] --model expects a filename\n";
+        return false;
+      }
+      options.model = argv[++i];
+    }
+    else if ( arg == "--batch" )
+    {
+      options.batch = true;
+    }
+    else if ( arg == "--timeout" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.timeout ) )
+      {
+        std::cerr << "[e] --timeout expects a number\n";
+        return false;
+      }
+    }
+    else if ( arg == "--preprocess" )
+    {
+      options.preprocess = true;
+    }
+    else if ( arg == "--reduce-widths" )
+    {
+      options.reduce_widths = true;
+    }
+    else if ( arg == "--simulate" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.simulate ) )
+      {
+        std::cerr << "[e] --simulate expects a number\n";
+        return false;
+      }
+    }
+    else if ( arg == "--sweep" )
+    {
+      options.sweep = true;
+    }
+    else if ( arg == "--pipeline" )
+    {
+      options.pipeline = true;
+      if ( i+1 >= argc || !parse_stage_threads( argv[++i], options ) )
+      {
+        std::cerr << "[e] --pipeline expects <parse>,<convert>,<solve> thread counts\n";
+        return false;
+      }
+    }
+    else if ( arg == "--reuse" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.reuse ) )
+      {
+        std::cerr << "[e] --reuse expects a number\n";
+        return false;
+      }
+    }
+    else if ( arg == "--counters" )
+    {
+      options.counters = true;
+    }
+    else if ( arg == "--polarity" )
+    {
+      options.polarity = true;
+    }
+    else if ( arg == "--minimize" )
+    {
+      if ( i+1 >= argc )
+      {
+        std::cerr << "[e] --minimize expects a filename\n";
+        return false;
+      }
+      options.minimize = argv[++i];
+    }
+    else if ( arg == "--queue-size" )
+    {
+      if ( i+1 >= argc || !parse_unsigned( argv[++i], options.queue_size ) || options.queue_size == 0u )
+      {
+        std::cerr << "[e] --queue-size expects a positive number\n";
+        return false;
+      }
+    }
+    else if ( arg.size() > 1u && arg[0] == '-' )
+    {
+      std::cerr << "[e] unknown option " << arg << '\n';
+      return false;
+    }
+    else if ( options.filename.empty() )
+    {
+      options.filename = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !options.filename.empty();
+}
+
+void print_checker_usage( const char *program )
+{
+  std::cerr << "Usage: " << program << " [options] <filename>\n"
+            << "Options:\n"
+            << "  --decompose    solve variable-disjoint components separately\n"
+            << "  --threads <n>  number of worker threads (default: all cores)\n"
+            << "  --cube-and-conquer\n"
+            << "                 solve cubes of the bit-blasted instance in parallel\n"
+            << "                 (SAT-based backends only)\n"
+            << "  --cube-depth <n>\n"
+            << "                 number of splitting variables for the cubes\n"
+            << "  --export-dimacs <file>\n"
+            << "                 write the bit-blasted CNF to <file> and the CNF\n"
+            << "                 literals of every variable to <file>.map\n"
+            << "  --native-parser\n"
+            << "                 read QF_BV instances without building a Z3 AST\n"
+            << "  --low-memory   release all Z3 structures before solving and report\n"
+            << "                 the peak resident set size of every phase\n"
+            << "  --stats        print the number of converted nodes, memo hits,\n"
+            << "                 heap allocations and the conversion time\n"
+            << "  --cegar        abstract bvmul, bvudiv and bvurem and add their\n"
+            << "                 circuits only where a model violates them\n"
+            << "  --model <file> backend model for smt2_sat_check_auto\n"
+            << "  --batch        <filename> lists one instance per line, the instances\n"
+            << "                 are checked by a pool of --threads worker processes\n"
+            << "  --timeout <s>  seconds per instance in batch runs\n"
+            << "  --preprocess   substitute top-level variable definitions and fold\n"
+            << "                 constants before the conversion\n"
+            << "  --reduce-widths\n"
+            << "                 narrow bit-vector terms whose high bits are known or\n"
+            << "                 never read before the conversion\n"
+            << "  --simulate <n> simulate <n> blocks of random assignments before the\n"
+            << "                 conversion and report SAT if one satisfies the instance\n"
+            << "  --sweep        merge terms that are equivalent on random assignments\n"
+            << "                 and proven equivalent before the conversion\n"
+            << "  --pipeline <p>,<c>,<s>\n"
+            << "                 with --batch, parse, convert and solve the instances in\n"
+            << "                 one process on <p>, <c> and <s> threads\n"
+            << "  --queue-size <n>\n"
+            << "                 instances waiting between two pipeline stages (default: 2)\n"
+            << "  --reuse <n>    check up to <n> instances with one solver context, the\n"
+            << "                 instances are passed as assumptions\n"
+            << "  --minimize <file>\n"
+            << "                 write a minimized instance to <file> if metaSMT and Z3\n"
+            << "                 disagree (consistency checkers)\n"
+            << "  --polarity     define and, or, =>, iff and Boolean ite only in the\n"
+            << "                 directions their polarity needs (SAT-based backends)\n"
+            << "  --counters     print cycles, instructions, cache and branch misses of\n"
+            << "                 parsing, conversion, assertion and solving\n";
+}
+
+unsigned checker_threads( const checker_options& options )
+{
+  if ( options.threads > 0u )
+  {
+    return options.threads;
+  }
+  const unsigned n = std::thread::hardware_concurrency();
+  return n > 0u ? n : 1u;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,138 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file checker_options.hpp
+ *
+ * @brief command line options of the checker executables
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <string>
+
+#pragma once
+
+struct checker_options
+{
+  checker_options()
+    : decompose( false )
+    , threads( 0u )
+    , cube_and_conquer( false )
+    , cube_depth( 0u )
+    , native_parser( false )
+    , low_memory( false )
+    , stats( false )
+    , cegar( false )
+    , batch( false )
+    , timeout( 0u )
+    , preprocess( false )
+    , reduce_widths( false )
+    , simulate( 0u )
+    , sweep( false )
+    , pipeline( false )
+    , parse_threads( 1u )
+    , convert_threads( 1u )
+    , solve_threads( 1u )
+    , queue_size( 2u )
+    , reuse( 0u )
+    , polarity( false )
+    , counters( false )
+  {}
+
+  std::string filename;
+
+  /* solve variable-disjoint components separately */
+  bool decompose;
+
+  /* number of worker threads (0 = hardware concurrency) */
+  unsigned threads;
+
+  /* split the bit-blasted instance into cubes solved in parallel */
+  bool cube_and_conquer;
+
+  /* number of splitting variables (0 = derived from the threads) */
+  unsigned cube_depth;
+
+  /* write the bit-blasted CNF to this file instead of solving */
+  std::string export_dimacs;
+
+  /* read QF_BV instances with smt2_qfbv_parser instead of Z3 */
+  bool native_parser;
+
+  /* release the Z3 structures before solving and report peak RSS */
+  bool low_memory;
+
+  /* print conversion statistics */
+  bool stats;
+
+  /* abstract bvmul, bvudiv and bvurem and refine on demand */
+  bool cegar;
+
+  /* backend model of smt2_sat_check_auto */
+  std::string model;
+
+  /* filename is a list of instances checked by a pool of processes */
+  bool batch;
+
+  /* seconds per instance in batch runs (0 = no limit) */
+  unsigned timeout;
+
+  /* substitute top-level definitions and fold constants before conversion */
+  bool preprocess;
+
+  /* narrow bit-vector terms to their demanded and non-constant bits */
+  bool reduce_widths;
+
+  /* rounds of random simulation before the conversion (0 = none) */
+  unsigned simulate;
+
+  /* merge functionally equivalent terms before conversion */
+  bool sweep;
+
+  /* batch runs in one process with parse, convert and solve stages */
+  bool pipeline;
+  unsigned parse_threads;
+  unsigned convert_threads;
+  unsigned solve_threads;
+
+  /* instances waiting between two pipeline stages */
+  unsigned queue_size;
+
+  /* instances per solver context (0 = a new context per instance) */
+  unsigned reuse;
+
+  /* write a minimized instance to this file if metaSMT and Z3 disagree */
+  std::string minimize;
+
+  /* encode the Boolean skeleton by polarity-aware definitions (SAT-based backends) */
+  bool polarity;
+
+  /* report hardware performance counters per phase */
+  bool counters;
+};
+
+bool parse_checker_options( int argc, char *argv[], checker_options& options );
+void print_checker_usage( const char *program );
+unsigned checker_threads( const checker_options& options );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,147 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cnf.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+
+thread_local clause_sink *current_sink = 0;
+
+}
+
+void clause_sink::add_unit( metaSMT::SAT::tag::lit_tag lit )
+{
+  add_clause( std::vector< metaSMT::SAT::tag::lit_tag >( 1u, lit ) );
+}
+
+void cnf::add_clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause )
+{
+  for ( const auto& lit : clause )
+  {
+    assert( lit.id != 0 );
+    literals.push_back( lit.id );
+    num_vars = std::max( num_vars, static_cast< unsigned >( std::abs( lit.id ) ) );
+  }
+  literals.push_back( 0 );
+  ++num_clauses;
+}
+
+std::vector< int > select_split_variables( const cnf& formula, unsigned n )
+{
+  std::vector< double > pos( formula.num_vars + 1u, 0.0 );
+  std::vector< double > neg( formula.num_vars + 1u, 0.0 );
+  std::vector< bool > fixed( formula.num_vars + 1u, false );
+
+  auto begin = formula.literals.begin();
+  while ( begin != formula.literals.end() )
+  {
+    const auto end = std::find( begin, formula.literals.end(), 0 );
+    const unsigned size = end - begin;
+    if ( size == 1u )
+    {
+      fixed[ std::abs( *begin ) ] = true;
+    }
+    const double weight = std::ldexp( 1.0, -static_cast< int >( std::min( size, 64u ) ) );
+    for ( auto it = begin; it != end; ++it )
+    {
+      ( *it > 0 ? pos : neg )[ std::abs( *it ) ] += weight;
+    }
+    begin = end + 1;
+  }
+
+  std::vector< std::pair< double, int > > ranking;
+  for ( unsigned v = 1u; v <= formula.num_vars; ++v )
+  {
+    if ( !fixed[v] && pos[v] > 0.0 && neg[v] > 0.0 )
+    {
+      ranking.push_back( std::make_pair( pos[v] * neg[v], static_cast< int >( v ) ) );
+    }
+  }
+
+  n = std::min< unsigned >( n, ranking.size() );
+  std::partial_sort( ranking.begin(), ranking.begin() + n, ranking.end(),
+                     []( const std::pair< double, int >& a, const std::pair< double, int >& b ) {
+                       return a.first > b.first || ( a.first == b.first && a.second < b.second );
+                     } );
+
+  std::vector< int > split;
+  for ( unsigned i = 0u; i < n; ++i )
+  {
+    split.push_back( ranking[i].second );
+  }
+  return split;
+}
+
+cnf_recorder::cnf_recorder()
+  : sink( cnf_recording_scope::current() )
+{}
+
+void cnf_recorder::clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause )
+{
+  sink.add_clause( clause );
+}
+
+void cnf_recorder::assertion( metaSMT::SAT::tag::lit_tag lit )
+{
+  sink.add_unit( lit );
+}
+
+void cnf_recorder::assumption( metaSMT::SAT::tag::lit_tag lit )
+{
+  assert( false && "cnf_recorder does not support assumptions" );
+}
+
+bool cnf_recorder::solve()
+{
+  assert( false && "cnf_recorder cannot solve" );
+  return false;
+}
+
+metaSMT::result_wrapper cnf_recorder::read_value( metaSMT::SAT::tag::lit_tag lit )
+{
+  assert( false && "cnf_recorder has no model" );
+  return metaSMT::result_wrapper( false );
+}
+
+cnf_recording_scope::cnf_recording_scope( clause_sink& sink )
+  : previous( current_sink )
+{
+  current_sink = &sink;
+}
+
+cnf_recording_scope::~cnf_recording_scope()
+{
+  current_sink = previous;
+}
+
+clause_sink& cnf_recording_scope::current()
+{
+  assert( current_sink && "cnf_recorder constructed outside of a recording scope" );
+  return *current_sink;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
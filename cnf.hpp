@@ -0,0 +1,161 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cnf.hpp
+ *
+ * @brief in-memory CNF of a bit-blasted instance
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <metaSMT/tags/SAT.hpp>
+#include <metaSMT/result_wrapper.hpp>
+
+#include <boost/variant.hpp>
+
+#include <vector>
+
+#pragma once
+
+/**
+ * Receiver of the clauses produced by bit-blasting.
+ */
+class clause_sink
+{
+public:
+  virtual ~clause_sink() {}
+
+  virtual void add_clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause ) = 0;
+  void add_unit( metaSMT::SAT::tag::lit_tag lit );
+};
+
+/**
+ * Clauses are stored in DIMACS style, i.e., as a flat sequence of
+ * non-zero literals where each clause is terminated by 0.
+ */
+struct cnf : public clause_sink
+{
+  cnf()
+    : num_vars( 0u )
+    , num_clauses( 0u )
+  {}
+
+  void add_clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause );
+
+  std::vector< int > literals;
+  unsigned num_vars;
+  unsigned num_clauses;
+};
+
+/**
+ * Chooses up to `n` variables to split on.  Variables are ranked by
+ * the product of their positive and negative Jeroslow-Wang scores
+ * such that both halves of a split simplify the formula.  Variables
+ * fixed by unit clauses are never chosen.
+ */
+std::vector< int > select_split_variables( const cnf& formula, unsigned n );
+
+/**
+ * SAT solver interface for metaSMT::SAT_Clause that records all
+ * clauses instead of solving them.  SAT_Clause default-constructs its
+ * solver, hence the recorder writes into the clause sink of the
+ * innermost cnf_recording_scope of the constructing thread.
+ */
+class cnf_recorder
+{
+public:
+  cnf_recorder();
+
+  void clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause );
+  void assertion( metaSMT::SAT::tag::lit_tag lit );
+  void assumption( metaSMT::SAT::tag::lit_tag lit );
+  bool solve();
+  metaSMT::result_wrapper read_value( metaSMT::SAT::tag::lit_tag lit );
+
+private:
+  clause_sink& sink;
+};
+
+class cnf_recording_scope
+{
+public:
+  explicit cnf_recording_scope( clause_sink& sink );
+  ~cnf_recording_scope();
+
+  static clause_sink& current();
+
+private:
+  clause_sink *previous;
+};
+
+/**
+ * Adds all clauses of `formula` to the SAT solver `solver` which
+ * implements the SAT_Clause solver interface.
+ */
+template < typename SatSolver >
+void load_cnf( SatSolver& solver, const cnf& formula )
+{
+  std::vector< metaSMT::SAT::tag::lit_tag > clause;
+  for ( const int l : formula.literals )
+  {
+    if ( l == 0 )
+    {
+      solver.clause( clause );
+      clause.clear();
+    }
+    else
+    {
+      metaSMT::SAT::tag::lit_tag lit = { l };
+      clause.push_back( lit );
+    }
+  }
+}
+
+/**
+ * Literals of a bit-blasted result, least significant bit first.
+ */
+struct bit_literals_visitor : public boost::static_visitor< std::vector< int > >
+{
+  std::vector< int > operator()( const metaSMT::SAT::tag::lit_tag& lit ) const
+  {
+    return std::vector< int >( 1u, lit.id );
+  }
+
+  std::vector< int > operator()( const std::vector< metaSMT::SAT::tag::lit_tag >& bits ) const
+  {
+    std::vector< int > lits;
+    for ( const auto& lit : bits )
+    {
+      lits.push_back( lit.id );
+    }
+    return lits;
+  }
+};
+
+template < typename ResultType >
+std::vector< int > bit_literals( const ResultType& r )
+{
+  return boost::apply_visitor( bit_literals_visitor(), r );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
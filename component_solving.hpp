@@ -0,0 +1,97 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file component_solving.hpp
+ *
+ * @brief solve variable-disjoint components in separate solver contexts
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+#include "decomposition.hpp"
+#include "parallel_utils.hpp"
+#include "z3_expr_visitor.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#pragma once
+
+template < typename Solver >
+bool solve_component( const z3::expr& formula )
+{
+  std::unique_ptr< Solver > solver_ctx;
+  std::unique_ptr< result_type_generator< Solver > > generator;
+  {
+    std::lock_guard< std::mutex > lock( conversion_mutex() );
+    solver_ctx.reset( new Solver );
+    generator.reset( new result_type_generator< Solver >( *solver_ctx ) );
+    typename Solver::result_type r = ( *generator )( formula );
+    metaSMT::assertion( *solver_ctx, r );
+  }
+
+  while ( metaSMT::solve( *solver_ctx ) )
+  {
+    /* array lemmas create new terms */
+    std::lock_guard< std::mutex > lock( conversion_mutex() );
+    if ( !generator->refine() )
+    {
+      generator.reset();
+      return true;
+    }
+  }
+
+  /* the generator holds terms of the shared Z3 context */
+  std::lock_guard< std::mutex > lock( conversion_mutex() );
+  generator.reset();
+  return false;
+}
+
+/**
+ * The instance is unsatisfiable as soon as one component is
+ * unsatisfiable and satisfiable if all components are satisfiable.
+ * Remaining components are skipped after the first UNSAT answer.
+ */
+template < typename Solver >
+bool solve_by_components( const z3::expr& instance, unsigned threads )
+{
+  std::vector< instance_component > components = make_components( instance );
+
+  if ( !backend_traits< Solver >::reentrant )
+  {
+    threads = 1u;
+  }
+
+  std::atomic< bool > unsat( false );
+  parallel_for_each( components.size(), threads, unsat, [&]( unsigned i ) {
+      if ( !solve_component< Solver >( components[i].formula ) )
+      {
+        unsat = true;
+      }
+    } );
+  return !unsat.load();
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -24,35 +24,76 @@
  * @since  1.0
  */
 
+#include "batch_runner.hpp"
+#include "checker_options.hpp"
+#include "component_solving.hpp"
+#include "minimizer.hpp"
+#include "preprocess.hpp"
+#include "smt2_parser.hpp"
+#include "snapshot.hpp"
 #include "z3_expr_visitor.hpp"
 
 #pragma once
 
+/**
+ * Checks options.filename, returns 0 if metaSMT and Z3 agree and -1
+ * otherwise.
+ */
 template < typename Solver >
-int metaSMT_Z3_consistency_checker_main( int argc, char *argv[] )
+int metaSMT_Z3_consistency_check_file( const checker_options& options )
 {
-  if ( argc != 2 )
+  const std::string filename = options.filename;
+  // std::cout << "Read SMT-LIB2 benchmark file ''" << filename << "''\n";
+
+  bool metaSMT_sat = false;
+  const bool native = options.native_parser && !options.decompose && !is_snapshot_file( filename );
+  if ( native )
   {
-    std::cerr << "Usage: " << argv[0] << " <filename>\n";
-    return -1;
+    /*** Solve with metaSMT before the reference instance is parsed ***/
+    Solver solver_ctx;
+    if ( !parse_smt2_qfbv( solver_ctx, filename ) )
+    {
+      return -1;
+    }
+    metaSMT_sat = metaSMT::solve( solver_ctx );
   }
 
-  const std::string filename = argv[1];
-  // std::cout << "Read SMT-LIB2 benchmark file ''" << filename << "''\n";
-
-  /*** Parse SMT-LIB2 instance ***/
+  /*** Parse SMT-LIB2 instance or snapshot ***/
   z3::context ctx;
-  const Z3_ast ast = Z3_parse_smtlib2_file( ctx, filename.c_str(), 0, 0, 0, 0, 0, 0 );
+  const z3::expr instance = load_instance( ctx, filename );
 
-  /*** Convert to metaSMT result_type ***/
-  Solver solver_ctx;
-  result_type_generator< Solver > generator( solver_ctx );
-  const z3::expr instance( ctx, ast );
-  typename Solver::result_type r = generator( instance );
+  if ( native )
+  {
+    /* already solved */
+  }
+  else if ( options.decompose )
+  {
+    /*** Convert and solve each component separately ***/
+    metaSMT_sat = solve_by_components< Solver >( preprocess_instance( instance, options ), checker_threads( options ) );
+  }
+  else if ( options.polarity )
+  {
+    if ( contains_arrays( instance ) )
+    {
+      std::cerr << "[e] --polarity does not support arrays\n";
+      return -1;
+    }
 
-  /*** Check satisfiability utilizing metaSMT ***/
-  metaSMT::assertion( solver_ctx, r );
-  const bool metaSMT_sat = metaSMT::solve( solver_ctx );
+    /*** Bit-blast with the polarity-aware skeleton ***/
+    metaSMT_sat = solve_polarity_aware< Solver >( preprocess_instance( instance, options ), options.stats );
+  }
+  else
+  {
+    /*** Convert to metaSMT result_type, Z3 solves the original instance ***/
+    Solver solver_ctx;
+    result_type_generator< Solver > generator( solver_ctx );
+    generator.abstract_nonlinear( options.cegar );
+    typename Solver::result_type r = generator( preprocess_instance( instance, options ) );
+
+    /*** Check satisfiability utilizing metaSMT, refining abstracted operators ***/
+    metaSMT::assertion( solver_ctx, r );
+    metaSMT_sat = solve_with_refinement( solver_ctx, generator );
+  }
 
   z3::solver z3( ctx );
   z3.add( instance );
@@ -68,9 +109,68 @@ int metaSMT_Z3_consistency_checker_main( int argc, char *argv[] )
 
   std::cout << "[metaSMT] Instance is " << ( metaSMT_sat ? "SAT" : "UNSAT" ) << '\n';
   std::cout << "[z3] Instance is " << ( z3_sat == z3::sat ? "SAT" : ( z3_sat == z3::unsat ? "UNSAT" : "UNKNOWN" ) ) << '\n';
+
+  if ( !options.minimize.empty() && z3_sat != z3::unknown )
+  {
+    /*** Shrink the instance while the answers still differ ***/
+    minimize_inconsistency< Solver >( instance, options );
+  }
   return -1;
 }
 
+inline const char *describe_consistency( int code )
+{
+  return code == 0 ? "consistent" : "inconsistent or error";
+}
+
+template < typename Solver >
+int metaSMT_Z3_consistency_checker_main( int argc, char *argv[] )
+{
+  checker_options options;
+  if ( !parse_checker_options( argc, argv, options ) )
+  {
+    print_checker_usage( argv[0] );
+    return -1;
+  }
+
+  if ( options.simulate > 0u || options.pipeline || options.reuse > 0u || options.counters )
+  {
+    std::cerr << "[e] --simulate, --pipeline, --reuse and --counters are only supported by the satisfiability checkers\n";
+    return -1;
+  }
+  if ( ( options.preprocess || options.reduce_widths || options.sweep ) && options.native_parser )
+  {
+    std::cerr << "[e] --preprocess, --reduce-widths and --sweep cannot be combined with --native-parser\n";
+    return -1;
+  }
+
+  if ( options.cegar && ( options.decompose || options.native_parser || options.polarity ) )
+  {
+    std::cerr << "[e] --cegar cannot be combined with --decompose, --native-parser or --polarity\n";
+    return -1;
+  }
+
+  if ( options.polarity && ( !sat_backend< Solver >::value || options.decompose || options.native_parser ) )
+  {
+    std::cerr << "[e] --polarity requires a SAT-based backend and cannot be combined with --decompose or --native-parser\n";
+    return -1;
+  }
+  if ( !options.minimize.empty() && ( options.batch || options.decompose || options.native_parser ) )
+  {
+    /* the minimizer converts the whole Z3 AST */
+    std::cerr << "[e] --minimize cannot be combined with --batch, --decompose or --native-parser\n";
+    return -1;
+  }
+
+  if ( options.batch )
+  {
+    /*** Check every listed instance in a worker process ***/
+    return run_batch( options, &metaSMT_Z3_consistency_check_file< Solver >, &warm_up_backend< Solver >, &describe_consistency );
+  }
+
+  return metaSMT_Z3_consistency_check_file< Solver >( options );
+}
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)
@@ -0,0 +1,123 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file context_pool.hpp
+ *
+ * @brief solver contexts reused across the instances of a process
+ *
+ * With --reuse, an instance is passed to the solver as an assumption
+ * instead of an assertion.  Assumptions only hold for the next solve,
+ * hence the context is unconstrained afterwards and checks the next
+ * instance without paying the backend initialization again, e.g.,
+ * starting the external solver of the SMT2 backend.  Lemmas of
+ * refinements are asserted; they are valid and only mention terms of
+ * their instance.  The terms of earlier instances stay in the context,
+ * therefore it is recreated after a fixed number of instances.
+ *
+ * There is one context per process, which is what the workers of
+ * batch_runner need.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#pragma once
+
+template < typename Solver >
+class context_pool
+{
+public:
+  /**
+   * Returns the context for the next instance, which is created anew
+   * after `limit' instances.  With `print_stats' the setup time of a
+   * new context, or the setup time saved by a reused one, is printed.
+   */
+  static Solver& acquire( unsigned limit, bool print_stats )
+  {
+    context_pool& pool = get();
+    if ( !pool.solver || pool.uses >= limit )
+    {
+      pool.create();
+      if ( print_stats )
+      {
+        std::cout << "[i] context: created in " << pool.setup_ms << " ms\n";
+      }
+    }
+    else if ( print_stats )
+    {
+      std::cout << "[i] context: reused for instance " << ( pool.uses + 1u ) << " of " << limit << ", "
+                << pool.setup_ms << " ms setup saved\n";
+    }
+    ++pool.uses;
+    return *pool.solver;
+  }
+
+  /* creates the context before the first instance, e.g., in the warm-up of a batch worker */
+  static void prepare()
+  {
+    context_pool& pool = get();
+    if ( !pool.solver )
+    {
+      pool.create();
+    }
+  }
+
+private:
+  context_pool()
+    : uses( 0u )
+    , setup_ms( 0.0 )
+  {}
+
+  static context_pool& get()
+  {
+    static context_pool pool;
+    return pool;
+  }
+
+  void create()
+  {
+    /* backends with global state must not see two contexts at once */
+    solver.reset();
+
+    const auto start = std::chrono::steady_clock::now();
+    solver.reset( new Solver );
+    setup_ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+    uses = 0u;
+  }
+
+  std::unique_ptr< Solver > solver;
+  unsigned uses;
+  double setup_ms;
+};
+
+/* warm-up of batch workers with --reuse */
+template < typename Solver >
+void prepare_pooled_context()
+{
+  context_pool< Solver >::prepare();
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
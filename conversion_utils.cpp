@@ -73,6 +73,59 @@ std::string convert_hex2bin( const std::string& hex )
   return bin;
 }
 
+/*
+ * Decimal digits are kept least significant first and doubled once
+ * per bit.
+ */
+std::string convert_bin2dec( const std::string& bits )
+{
+  std::string digits( 1u, 0 );
+  for ( const char b : bits )
+  {
+    int carry = ( b == '1' ) ? 1 : 0;
+    for ( char& d : digits )
+    {
+      const int v = 2 * d + carry;
+      d = v % 10;
+      carry = v / 10;
+    }
+    if ( carry )
+    {
+      digits.push_back( carry );
+    }
+  }
+
+  std::string dec( digits.rbegin(), digits.rend() );
+  for ( char& d : dec )
+  {
+    d += '0';
+  }
+  return dec;
+}
+
+/*
+ * The decimal string is halved once per bit; the remainders are the
+ * bits from the least significant one.  Bits beyond `width' are
+ * dropped, i.e., the value is taken modulo 2^width.
+ */
+std::string convert_dec2bin( const std::string& dec, unsigned width )
+{
+  std::string digits = dec;
+  std::string bits( width, '0' );
+  for ( unsigned i = 0u; i < width; ++i )
+  {
+    int remainder = 0;
+    for ( char& d : digits )
+    {
+      const int v = 10 * remainder + ( d - '0' );
+      d = static_cast< char >( '0' + v / 2 );
+      remainder = v % 2;
+    }
+    bits[width - 1u - i] = remainder ? '1' : '0';
+  }
+  return bits;
+}
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)
@@ -30,6 +30,8 @@
 char convert_bin2hex( const std::string& bits );
 std::string convert_hex2bin( const char& hex );
 std::string convert_hex2bin( const std::string& hex );
+std::string convert_bin2dec( const std::string& bits );
+std::string convert_dec2bin( const std::string& dec, unsigned width );
 
 // Local Variables:
 // c-basic-offset: 2
@@ -0,0 +1,175 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cube_and_conquer.hpp
+ *
+ * @brief parallel cube-and-conquer search for SAT-based backends
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+#include "cnf.hpp"
+#include "parallel_utils.hpp"
+#include "polarity_encoding.hpp"
+#include "z3_expr_visitor.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+#pragma once
+
+using cnf_recording_solver = metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause< cnf_recorder > > >;
+
+/**
+ * Bit-blasts the instance into a CNF.  With `polarity_aware' the
+ * Boolean skeleton is encoded by assert_polarity_aware.
+ */
+inline void bit_blast_to_cnf( const z3::expr& instance, cnf& formula, bool polarity_aware = false, bool print_stats = false )
+{
+  cnf_recording_scope scope( formula );
+  cnf_recording_solver recorder_ctx;
+  result_type_generator< cnf_recording_solver > generator( recorder_ctx );
+  if ( polarity_aware )
+  {
+    const polarity_stats stats = assert_polarity_aware( recorder_ctx, generator, instance, formula );
+    if ( print_stats )
+    {
+      print_polarity_stats( stats, formula.num_clauses );
+    }
+    return;
+  }
+  cnf_recording_solver::result_type r = generator( instance );
+  metaSMT::assertion( recorder_ctx, r );
+}
+
+/**
+ * The instance is bit-blasted once.  2^depth cubes over the selected
+ * splitting variables are solved under assumptions by `threads`
+ * workers, each with its own copy of the CNF.  No further cube is
+ * started once a worker finds a satisfiable cube.  If depth is 0, it
+ * is chosen to give about four cubes per thread.
+ */
+template < typename SatSolver >
+bool cube_and_conquer( const z3::expr& instance, unsigned threads, unsigned depth, bool polarity_aware )
+{
+  cnf formula;
+  bit_blast_to_cnf( instance, formula, polarity_aware );
+
+  if ( depth == 0u )
+  {
+    depth = static_cast< unsigned >( std::ceil( std::log2( threads ) ) ) + 2u;
+  }
+  const std::vector< int > split = select_split_variables( formula, std::min( depth, 20u ) );
+  const unsigned num_cubes = 1u << split.size();
+
+  std::atomic< unsigned > next( 0u );
+  std::atomic< bool > sat( false );
+  parallel_for_each( std::min( threads, num_cubes ), threads, sat, [&]( unsigned ) {
+      SatSolver solver;
+      load_cnf( solver, formula );
+      for ( ;; )
+      {
+        const unsigned cube = next++;
+        if ( cube >= num_cubes || sat.load() )
+        {
+          return;
+        }
+        for ( unsigned i = 0u; i < split.size(); ++i )
+        {
+          metaSMT::SAT::tag::lit_tag lit = { ( ( cube >> i ) & 1u ) ? split[i] : -split[i] };
+          solver.assumption( lit );
+        }
+        if ( solver.solve() )
+        {
+          sat = true;
+          return;
+        }
+      }
+    } );
+  return sat.load();
+}
+
+template < typename Solver >
+bool solve_by_cubes( const z3::expr& instance, unsigned threads, unsigned depth, bool polarity_aware, std::true_type )
+{
+  if ( !backend_traits< Solver >::reentrant )
+  {
+    threads = 1u;
+  }
+  return cube_and_conquer< typename sat_backend< Solver >::type >( instance, threads, depth, polarity_aware );
+}
+
+template < typename Solver >
+bool solve_by_cubes( const z3::expr& instance, unsigned threads, unsigned depth, bool polarity_aware, std::false_type )
+{
+  assert( false && "cube-and-conquer requires a SAT-based backend" );
+  return false;
+}
+
+template < typename Solver >
+bool solve_by_cubes( const z3::expr& instance, unsigned threads, unsigned depth, bool polarity_aware )
+{
+  return solve_by_cubes< Solver >( instance, threads, depth, polarity_aware, std::integral_constant< bool, sat_backend< Solver >::value >() );
+}
+
+/**
+ * Bit-blasts the instance with the polarity-aware skeleton and solves
+ * the CNF with the SAT solver of the backend.
+ */
+template < typename SatSolver >
+bool solve_cnf_polarity_aware( const z3::expr& instance, bool print_stats )
+{
+  cnf formula;
+  {
+    /* new variables come from metaSMT's process-wide counter */
+    std::lock_guard< std::mutex > lock( conversion_mutex() );
+    bit_blast_to_cnf( instance, formula, true, print_stats );
+  }
+  SatSolver solver;
+  load_cnf( solver, formula );
+  return solver.solve();
+}
+
+template < typename Solver >
+bool solve_polarity_aware( const z3::expr& instance, bool print_stats, std::true_type )
+{
+  return solve_cnf_polarity_aware< typename sat_backend< Solver >::type >( instance, print_stats );
+}
+
+template < typename Solver >
+bool solve_polarity_aware( const z3::expr& instance, bool print_stats, std::false_type )
+{
+  assert( false && "the polarity-aware encoding requires a SAT-based backend" );
+  return false;
+}
+
+template < typename Solver >
+bool solve_polarity_aware( const z3::expr& instance, bool print_stats )
+{
+  return solve_polarity_aware< Solver >( instance, print_stats, std::integral_constant< bool, sat_backend< Solver >::value >() );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
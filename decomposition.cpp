@@ -0,0 +1,179 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "decomposition.hpp"
+#include "z3_utils.hpp"
+
+#include <map>
+#include <unordered_map>
+
+namespace
+{
+
+unsigned find_root( std::vector< unsigned >& parent, unsigned i )
+{
+  while ( parent[i] != i )
+  {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+void unite( std::vector< unsigned >& parent, unsigned i, unsigned j )
+{
+  i = find_root( parent, i );
+  j = find_root( parent, j );
+  if ( i != j )
+  {
+    parent[ std::max( i, j ) ] = std::min( i, j );
+  }
+}
+
+}
+
+void collect_conjuncts( const z3::expr& e, std::vector< z3::expr >& conjuncts )
+{
+  if ( e.is_app() && e.decl().decl_kind() == Z3_OP_AND )
+  {
+    for ( unsigned i = 0u; i < e.num_args(); ++i )
+    {
+      collect_conjuncts( e.arg( i ), conjuncts );
+    }
+  }
+  else
+  {
+    conjuncts.push_back( e );
+  }
+}
+
+z3::expr translate_expr( const z3::expr& e, z3::context& target )
+{
+  return z3::expr( target, Z3_translate( e.ctx(), e, target ) );
+}
+
+std::vector< z3::expr > decompose_components( const z3::expr& instance )
+{
+  std::vector< z3::expr > conjuncts;
+  collect_conjuncts( instance, conjuncts );
+
+  const unsigned n = conjuncts.size();
+  std::vector< unsigned > parent( n );
+  for ( unsigned i = 0u; i < n; ++i )
+  {
+    parent[i] = i;
+  }
+
+  /*
+   * Every node of the DAG is visited once: the first conjunct that
+   * reaches a node becomes its owner, every later conjunct that
+   * reaches the same node is merged with the owner.  Nodes without
+   * variables below them never connect conjuncts.
+   */
+  std::unordered_map< unsigned, unsigned > owner;
+  std::unordered_map< unsigned, bool > has_variable;
+  for ( unsigned c = 0u; c < n; ++c )
+  {
+    std::vector< std::pair< z3::expr, bool > > stack;
+    stack.push_back( std::make_pair( conjuncts[c], false ) );
+    while ( !stack.empty() )
+    {
+      const z3::expr e = stack.back().first;
+      const bool expanded = stack.back().second;
+      stack.pop_back();
+
+      const unsigned id = z3_expr_id( e );
+      if ( expanded )
+      {
+        bool v = false;
+        for ( unsigned i = 0u; i < e.num_args() && !v; ++i )
+        {
+          v = has_variable[ z3_expr_id( e.arg( i ) ) ];
+        }
+        has_variable[id] = v;
+        continue;
+      }
+
+      auto it = owner.find( id );
+      if ( it != owner.end() )
+      {
+        if ( has_variable[id] )
+        {
+          unite( parent, c, it->second );
+        }
+        continue;
+      }
+      owner.insert( std::make_pair( id, c ) );
+
+      if ( is_variable( e ) )
+      {
+        has_variable[id] = true;
+      }
+      else if ( e.is_app() && e.num_args() > 0u )
+      {
+        stack.push_back( std::make_pair( e, true ) );
+        for ( unsigned i = 0u; i < e.num_args(); ++i )
+        {
+          stack.push_back( std::make_pair( e.arg( i ), false ) );
+        }
+      }
+      else
+      {
+        has_variable[id] = false;
+      }
+    }
+  }
+
+  std::map< unsigned, std::vector< Z3_ast > > groups;
+  for ( unsigned c = 0u; c < n; ++c )
+  {
+    groups[ find_root( parent, c ) ].push_back( conjuncts[c] );
+  }
+
+  std::vector< z3::expr > components;
+  for ( const auto& g : groups )
+  {
+    if ( g.second.size() == 1u )
+    {
+      components.push_back( z3::expr( instance.ctx(), g.second.front() ) );
+    }
+    else
+    {
+      const Z3_ast a = Z3_mk_and( instance.ctx(), g.second.size(), &g.second[0] );
+      components.push_back( z3::expr( instance.ctx(), a ) );
+    }
+  }
+  return components;
+}
+
+std::vector< instance_component > make_components( const z3::expr& instance )
+{
+  std::vector< instance_component > result;
+  for ( const auto& c : decompose_components( instance ) )
+  {
+    std::unique_ptr< z3::context > ctx( new z3::context );
+    const z3::expr formula = translate_expr( c, *ctx );
+    result.push_back( instance_component( std::move( ctx ), formula ) );
+  }
+  return result;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,58 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file decomposition.hpp
+ *
+ * @brief split an instance into variable-disjoint components
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <z3++.h>
+
+#include <memory>
+#include <vector>
+
+#pragma once
+
+/**
+ * A component owns its own Z3 context such that it can be converted
+ * and solved independently of all other components.
+ */
+struct instance_component
+{
+  instance_component( std::unique_ptr< z3::context > c, const z3::expr& e )
+    : ctx( std::move( c ) )
+    , formula( e )
+  {}
+
+  std::unique_ptr< z3::context > ctx;
+  z3::expr formula;
+};
+
+void collect_conjuncts( const z3::expr& e, std::vector< z3::expr >& conjuncts );
+z3::expr translate_expr( const z3::expr& e, z3::context& target );
+std::vector< z3::expr > decompose_components( const z3::expr& instance );
+std::vector< instance_component > make_components( const z3::expr& instance );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,82 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dimacs_export.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+
+/* "p cnf <vars> <clauses>" with room for two 32-bit numbers */
+const std::size_t header_width = 40u;
+
+}
+
+dimacs_stream::dimacs_stream( const std::string& filename )
+  : num_vars( 0u )
+  , num_clauses( 0u )
+  , os( filename.c_str() )
+{
+  os << std::string( header_width - 1u, ' ' ) << '\n';
+}
+
+dimacs_stream::~dimacs_stream()
+{
+  close();
+}
+
+bool dimacs_stream::good() const
+{
+  return os.good();
+}
+
+void dimacs_stream::add_clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause )
+{
+  for ( const auto& lit : clause )
+  {
+    os << lit.id << ' ';
+    num_vars = std::max( num_vars, static_cast< unsigned >( std::abs( lit.id ) ) );
+  }
+  os << "0\n";
+  ++num_clauses;
+}
+
+void dimacs_stream::close()
+{
+  if ( !os.is_open() )
+  {
+    return;
+  }
+
+  std::ostringstream header;
+  header << "p cnf " << num_vars << ' ' << num_clauses;
+  std::string line = header.str();
+  line.resize( header_width - 1u, ' ' );
+
+  os.seekp( 0 );
+  os << line;
+  os.close();
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
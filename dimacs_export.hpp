@@ -0,0 +1,127 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dimacs_export.hpp
+ *
+ * @brief streaming DIMACS export of the bit-blasted instance
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "cube_and_conquer.hpp"
+#include "cnf.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#pragma once
+
+/**
+ * Writes clauses to a DIMACS file as they are produced.  The header is
+ * reserved as a fixed-width line at the beginning of the file and
+ * overwritten with the final counts by close(), hence no clause is
+ * kept in memory.
+ */
+class dimacs_stream : public clause_sink
+{
+public:
+  explicit dimacs_stream( const std::string& filename );
+  ~dimacs_stream();
+
+  bool good() const;
+  void add_clause( const std::vector< metaSMT::SAT::tag::lit_tag >& clause );
+  void close();
+
+  unsigned num_vars;
+  unsigned num_clauses;
+
+private:
+  std::ofstream os;
+};
+
+/**
+ * Writes the literals of every variable of `instance` to `os`, one
+ * line per variable: name, width (0 for Boolean variables) and the CNF
+ * literals least significant bit first.  Returns the largest CNF
+ * variable in the map.
+ */
+template < typename Generator >
+unsigned write_variable_map( std::ostream& os, const z3::expr& instance, Generator& generator )
+{
+  unsigned num_vars = 0u;
+  os << "c smt2eval variable map: <name> <width> <literals, lsb first>\n";
+  for ( const auto& v : collect_variables( instance ) )
+  {
+    const z3::sort s = v.get_sort();
+    os << v.decl().name().str() << ' ' << ( s.is_bv() ? s.bv_size() : 0u );
+    for ( const int lit : bit_literals( generator( v ) ) )
+    {
+      os << ' ' << lit;
+      num_vars = std::max( num_vars, static_cast< unsigned >( std::abs( lit ) ) );
+    }
+    os << '\n';
+  }
+  return num_vars;
+}
+
+/**
+ * Bit-blasts `instance` and streams the CNF to `filename`.  The
+ * variable map is written to `filename`.map; the header counts the
+ * variables of both, such that unconstrained bits of the map are
+ * declared as well.  With `polarity_aware` the Boolean skeleton is
+ * encoded by assert_polarity_aware.
+ */
+inline bool export_dimacs( const z3::expr& instance, const std::string& filename, bool polarity_aware )
+{
+  dimacs_stream out( filename );
+  std::ofstream map( ( filename + ".map" ).c_str() );
+  if ( !out.good() || !map.good() )
+  {
+    std::cerr << "[e] cannot write " << filename << '\n';
+    return false;
+  }
+
+  {
+    cnf_recording_scope scope( out );
+    cnf_recording_solver recorder_ctx;
+    result_type_generator< cnf_recording_solver > generator( recorder_ctx );
+    if ( polarity_aware )
+    {
+      assert_polarity_aware( recorder_ctx, generator, instance, out );
+    }
+    else
+    {
+      cnf_recording_solver::result_type r = generator( instance );
+      metaSMT::assertion( recorder_ctx, r );
+    }
+    out.num_vars = std::max( out.num_vars, write_variable_map( map, instance, generator ) );
+  }
+
+  out.close();
+  std::cout << "[i] wrote " << out.num_vars << " variables and " << out.num_clauses << " clauses to " << filename << '\n';
+  return true;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,219 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance_features.hpp"
+#include "z3_utils.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <unordered_map>
+
+namespace
+{
+
+/* operator classes of the histogram, the last one collects the rest */
+struct operator_class
+{
+  const char *name;
+  std::vector< Z3_decl_kind > kinds;
+};
+
+const std::vector< operator_class >& operator_classes()
+{
+  static const std::vector< operator_class > classes = {
+    { "op_const",   { Z3_OP_TRUE, Z3_OP_FALSE, Z3_OP_BNUM } },
+    { "op_var",     { Z3_OP_UNINTERPRETED } },
+    { "op_eq",      { Z3_OP_EQ, Z3_OP_DISTINCT, Z3_OP_IFF } },
+    { "op_ite",     { Z3_OP_ITE } },
+    { "op_bool",    { Z3_OP_AND, Z3_OP_OR, Z3_OP_XOR, Z3_OP_NOT, Z3_OP_IMPLIES } },
+    { "op_add",     { Z3_OP_BADD, Z3_OP_BSUB, Z3_OP_BNEG } },
+    { "op_mul",     { Z3_OP_BMUL } },
+    { "op_div",     { Z3_OP_BUDIV, Z3_OP_BSDIV, Z3_OP_BUREM, Z3_OP_BSREM, Z3_OP_BSMOD } },
+    { "op_cmp",     { Z3_OP_ULEQ, Z3_OP_SLEQ, Z3_OP_UGEQ, Z3_OP_SGEQ, Z3_OP_ULT, Z3_OP_SLT, Z3_OP_UGT, Z3_OP_SGT } },
+    { "op_bitwise", { Z3_OP_BAND, Z3_OP_BOR, Z3_OP_BNOT, Z3_OP_BXOR, Z3_OP_BNAND, Z3_OP_BNOR, Z3_OP_BXNOR, Z3_OP_BCOMP } },
+    { "op_shift",   { Z3_OP_BSHL, Z3_OP_BLSHR, Z3_OP_BASHR, Z3_OP_ROTATE_LEFT, Z3_OP_ROTATE_RIGHT } },
+    { "op_slice",   { Z3_OP_CONCAT, Z3_OP_EXTRACT, Z3_OP_SIGN_EXT, Z3_OP_ZERO_EXT, Z3_OP_REPEAT } },
+    { "op_array",   { Z3_OP_SELECT, Z3_OP_STORE, Z3_OP_CONST_ARRAY } },
+    { "op_other",   {} }
+  };
+  return classes;
+}
+
+std::unordered_map< int, unsigned > make_operator_class_index()
+{
+  std::unordered_map< int, unsigned > index;
+  const auto& classes = operator_classes();
+  for ( unsigned i = 0u; i < classes.size(); ++i )
+  {
+    for ( const auto k : classes[i].kinds )
+    {
+      index[k] = i;
+    }
+  }
+  return index;
+}
+
+unsigned operator_class_of( Z3_decl_kind kind )
+{
+  static const std::unordered_map< int, unsigned > index = make_operator_class_index();
+  const auto it = index.find( kind );
+  return it != index.end() ? it->second : operator_classes().size() - 1u;
+}
+
+std::vector< std::string > make_feature_names()
+{
+  std::vector< std::string > names = { "dag_size", "depth", "variables", "max_width", "avg_width", "nonlinear" };
+  for ( const auto& c : operator_classes() )
+  {
+    names.push_back( c.name );
+  }
+  return names;
+}
+
+}
+
+instance_features::instance_features()
+  : dag_size( 0u )
+  , depth( 0u )
+  , variables( 0u )
+  , max_width( 0u )
+  , avg_width( 0.0 )
+  , nonlinear( 0u )
+  , histogram( operator_classes().size(), 0u )
+{}
+
+/*
+ * Iterative post-order traversal; the depth of a node is known once
+ * all of its arguments have been visited.
+ */
+instance_features extract_features( const z3::expr& instance )
+{
+  instance_features f;
+  std::unordered_map< unsigned, unsigned > depth_of;
+  unsigned long long width_sum = 0u;
+  unsigned bv_nodes = 0u;
+
+  std::vector< std::pair< z3::expr, bool > > stack( 1u, std::make_pair( instance, false ) );
+  while ( !stack.empty() )
+  {
+    const z3::expr e = stack.back().first;
+    const bool expanded = stack.back().second;
+    stack.pop_back();
+
+    const unsigned id = z3_expr_id( e );
+    if ( depth_of.find( id ) != depth_of.end() )
+    {
+      continue;
+    }
+
+    const unsigned num_args = e.is_app() ? e.num_args() : 0u;
+    if ( !expanded && num_args > 0u )
+    {
+      stack.push_back( std::make_pair( e, true ) );
+      for ( unsigned i = 0u; i < num_args; ++i )
+      {
+        stack.push_back( std::make_pair( e.arg( i ), false ) );
+      }
+      continue;
+    }
+
+    unsigned d = 0u;
+    for ( unsigned i = 0u; i < num_args; ++i )
+    {
+      d = std::max( d, depth_of[z3_expr_id( e.arg( i ) )] + 1u );
+    }
+    depth_of[id] = d;
+    f.depth = std::max( f.depth, d );
+    ++f.dag_size;
+
+    if ( e.is_app() )
+    {
+      const Z3_decl_kind kind = e.decl().decl_kind();
+      ++f.histogram[operator_class_of( kind )];
+      if ( is_variable( e ) )
+      {
+        ++f.variables;
+      }
+      if ( kind == Z3_OP_BMUL || kind == Z3_OP_BUDIV || kind == Z3_OP_BSDIV ||
+           kind == Z3_OP_BUREM || kind == Z3_OP_BSREM || kind == Z3_OP_BSMOD )
+      {
+        ++f.nonlinear;
+      }
+    }
+    else
+    {
+      ++f.histogram.back();
+    }
+
+    if ( e.get_sort().is_bv() )
+    {
+      const unsigned w = e.get_sort().bv_size();
+      f.max_width = std::max( f.max_width, w );
+      width_sum += w;
+      ++bv_nodes;
+    }
+  }
+
+  f.avg_width = bv_nodes > 0u ? static_cast< double >( width_sum ) / bv_nodes : 0.0;
+  return f;
+}
+
+const std::vector< std::string >& feature_names()
+{
+  static const std::vector< std::string > names = make_feature_names();
+  return names;
+}
+
+std::vector< double > feature_values( const instance_features& features )
+{
+  std::vector< double > values = {
+    static_cast< double >( features.dag_size ),
+    static_cast< double >( features.depth ),
+    static_cast< double >( features.variables ),
+    static_cast< double >( features.max_width ),
+    features.avg_width,
+    static_cast< double >( features.nonlinear )
+  };
+  values.insert( values.end(), features.histogram.begin(), features.histogram.end() );
+  return values;
+}
+
+void write_features_header( std::ostream& os )
+{
+  os << "instance";
+  for ( const auto& name : feature_names() )
+  {
+    os << ',' << name;
+  }
+  os << '\n';
+}
+
+void write_features( std::ostream& os, const std::string& name, const instance_features& features )
+{
+  os << name;
+  for ( const auto v : feature_values( features ) )
+  {
+    os << ',' << v;
+  }
+  os << '\n';
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,68 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file instance_features.hpp
+ *
+ * @brief static features of a parsed instance
+ *
+ * The features are computed in a single pass over the DAG and are
+ * used to select a backend automatically (see backend_model.hpp).
+ * smt2_features writes them as CSV to produce training data.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <z3++.h>
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+struct instance_features
+{
+  instance_features();
+
+  unsigned dag_size;
+  unsigned depth;
+  unsigned variables;
+  unsigned max_width;
+  double avg_width;          /* over bit-vector nodes */
+  unsigned nonlinear;        /* bvmul, division and remainder */
+
+  /* occurrences per operator class, see feature_names() */
+  std::vector< unsigned > histogram;
+};
+
+instance_features extract_features( const z3::expr& instance );
+
+/* names of the values of feature_values(), also the CSV columns */
+const std::vector< std::string >& feature_names();
+std::vector< double > feature_values( const instance_features& features );
+
+void write_features_header( std::ostream& os );
+void write_features( std::ostream& os, const std::string& name, const instance_features& features );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
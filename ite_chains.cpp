@@ -0,0 +1,103 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ite_chains.hpp"
+#include "z3_utils.hpp"
+
+#include <unordered_set>
+
+namespace
+{
+
+/* matches (= s k) and (= k s) with a bit-vector constant k */
+bool match_case( const z3::expr& cond, z3::expr& selector, std::string& key )
+{
+  if ( !cond.is_app() || cond.decl().decl_kind() != Z3_OP_EQ || cond.num_args() != 2u )
+  {
+    return false;
+  }
+
+  const z3::expr lhs = cond.arg( 0u );
+  const z3::expr rhs = cond.arg( 1u );
+  if ( !lhs.get_sort().is_bv() )
+  {
+    return false;
+  }
+
+  const bool lhs_const = lhs.decl().decl_kind() == Z3_OP_BNUM;
+  const bool rhs_const = rhs.decl().decl_kind() == Z3_OP_BNUM;
+  if ( lhs_const == rhs_const )
+  {
+    return false;
+  }
+
+  selector = lhs_const ? rhs : lhs;
+  key = expr_to_bin( lhs_const ? lhs : rhs );
+  return true;
+}
+
+}
+
+bool match_ite_chain( const z3::expr& e, ite_chain& chain )
+{
+  if ( !e.is_app() || e.decl().decl_kind() != Z3_OP_ITE || !( e.get_sort().is_bv() || e.get_sort().is_bool() ) )
+  {
+    return false;
+  }
+
+  chain.keys.clear();
+  chain.values.clear();
+
+  std::unordered_set< std::string > seen;
+  z3::expr t = e;
+  bool first = true;
+  while ( t.is_app() && t.decl().decl_kind() == Z3_OP_ITE )
+  {
+    z3::expr selector = t;
+    std::string key;
+    if ( !match_case( t.arg( 0u ), selector, key ) || ( !first && z3_expr_id( selector ) != z3_expr_id( chain.selector ) ) )
+    {
+      break;
+    }
+    if ( first )
+    {
+      chain.selector = selector;
+      first = false;
+    }
+
+    if ( seen.insert( key ).second )
+    {
+      chain.keys.push_back( key );
+      chain.values.push_back( t.arg( 1u ) );
+    }
+    t = t.arg( 2u );
+  }
+  chain.otherwise = t;
+
+  return chain.keys.size() >= ite_chain_min_cases;
+}
+
+bool use_mux_tree( unsigned selector_width, unsigned num_cases )
+{
+  return selector_width <= 16u && ( 1u << selector_width ) <= 4u * num_cases;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,194 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ite_chains.hpp
+ *
+ * @brief table lookups written as ITE cascades
+ *
+ * A cascade (ite (= s k0) v0 (ite (= s k1) v1 ... d)) over a single
+ * selector s and constants ki is converted as one lookup instead of
+ * one Ite per case, which compares s again in every case and yields a
+ * chain of muxes as deep as the cascade.  If the table over all values
+ * of s is small compared to the number of cases, a balanced mux tree
+ * is driven by the bits of s; equal subtrees, e.g., ranges of the
+ * default d, are shared.  Otherwise the cases are selected one-hot:
+ * the values masked by s = ki are or-ed in a balanced tree.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "operator_conversion.hpp"
+
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/frontend/Logic.hpp>
+#include <metaSMT/frontend/QF_BV.hpp>
+
+#include <z3++.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+struct ite_chain
+{
+  explicit ite_chain( const z3::expr& e )
+    : selector( e )
+    , otherwise( e )
+  {}
+
+  z3::expr selector;
+  std::vector< std::string > keys;      /* distinct, in binary */
+  std::vector< z3::expr > values;
+  z3::expr otherwise;
+};
+
+/* cascades with fewer cases are converted one Ite at a time */
+const unsigned ite_chain_min_cases = 4u;
+
+/**
+ * Matches the cascade rooted at `e'.  Cases shadowed by an earlier
+ * case with the same constant are dropped.  Returns false if `e' is
+ * not a bit-vector or Boolean ITE with at least ite_chain_min_cases
+ * cases.
+ */
+bool match_ite_chain( const z3::expr& e, ite_chain& chain );
+
+/* true if the lookup is encoded as mux tree rather than one-hot */
+bool use_mux_tree( unsigned selector_width, unsigned num_cases );
+
+/**
+ * Balanced reduction of `xs' with the binary function `op'.  `xs'
+ * must not be empty.
+ */
+template < typename T, typename Op >
+T reduce_balanced( std::vector< T > xs, Op op )
+{
+  while ( xs.size() > 1u )
+  {
+    std::vector< T > next;
+    next.reserve( ( xs.size() + 1u ) / 2u );
+    for ( unsigned i = 0u; i + 1u < xs.size(); i += 2u )
+    {
+      next.push_back( op( xs[i], xs[i + 1u] ) );
+    }
+    if ( xs.size() % 2u == 1u )
+    {
+      next.push_back( xs.back() );
+    }
+    xs.swap( next );
+  }
+  return xs.front();
+}
+
+/**
+ * Converts a matched cascade, `selector', `values' and `otherwise'
+ * are the converted operands of `chain'.
+ */
+template < typename Solver, typename Arguments >
+typename Solver::result_type convert_ite_chain( Solver& solver, const ite_chain& chain, const typename Solver::result_type& selector,
+                                                const Arguments& values, const typename Solver::result_type& otherwise )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic;
+  using namespace metaSMT::logic::QF_BV;
+  using result_type = typename Solver::result_type;
+
+  const unsigned width = chain.selector.get_sort().bv_size();
+  const unsigned num_cases = chain.keys.size();
+
+  if ( use_mux_tree( width, num_cases ) )
+  {
+    /*** Table over all selector values, leaves are case numbers ***/
+    std::vector< unsigned > level( 1u << width, num_cases );
+    for ( unsigned i = 0u; i < num_cases; ++i )
+    {
+      unsigned index = 0u;
+      for ( const auto c : chain.keys[i] )
+      {
+        index = ( index << 1u ) | ( c == '1' );
+      }
+      level[index] = i;
+    }
+
+    /*** Mux bit 0 first, equal pairs of subtrees are not muxed ***/
+    std::vector< result_type > nodes;
+    for ( unsigned i = 0u; i < num_cases; ++i )
+    {
+      nodes.push_back( values[i] );
+    }
+    nodes.push_back( otherwise );
+
+    for ( unsigned bit = 0u; bit < width; ++bit )
+    {
+      const result_type b = evaluate( solver, logic::equal( extract( bit, bit, selector ), bvbin( "1" ) ) );
+      std::map< std::pair< unsigned, unsigned >, unsigned > muxes;
+      std::vector< unsigned > next( level.size() / 2u );
+      for ( unsigned j = 0u; j < next.size(); ++j )
+      {
+        const unsigned lo = level[2u * j];
+        const unsigned hi = level[2u * j + 1u];
+        if ( lo == hi )
+        {
+          next[j] = lo;
+          continue;
+        }
+
+        const auto key = std::make_pair( lo, hi );
+        const auto it = muxes.find( key );
+        if ( it != muxes.end() )
+        {
+          next[j] = it->second;
+          continue;
+        }
+        nodes.push_back( evaluate( solver, Ite( b, nodes[hi], nodes[lo] ) ) );
+        next[j] = nodes.size() - 1u;
+        muxes.insert( std::make_pair( key, next[j] ) );
+      }
+      level.swap( next );
+    }
+    return nodes[level.front()];
+  }
+
+  /*** One-hot select, at most one case holds ***/
+  std::vector< result_type > hits, selected;
+  const bool boolean = chain.otherwise.get_sort().is_bool();
+  const result_type zero = boolean ? evaluate( solver, False ) : evaluate( solver, bvbin( std::string( chain.otherwise.get_sort().bv_size(), '0' ) ) );
+  for ( unsigned i = 0u; i < num_cases; ++i )
+  {
+    hits.push_back( evaluate( solver, logic::equal( selector, bvbin( chain.keys[i] ) ) ) );
+    selected.push_back( boolean ? evaluate( solver, And( hits.back(), values[i] ) ) : evaluate( solver, Ite( hits.back(), values[i], zero ) ) );
+  }
+
+  const result_type any = reduce_balanced( hits, [&]( const result_type& a, const result_type& b ) {
+      return evaluate( solver, Or( a, b ) );
+    } );
+  const result_type value = reduce_balanced( selected, [&]( const result_type& a, const result_type& b ) {
+      return boolean ? evaluate( solver, Or( a, b ) ) : evaluate( solver, bvor( a, b ) );
+    } );
+  return evaluate( solver, Ite( any, value, otherwise ) );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,128 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memory_utils.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace
+{
+
+std::atomic< std::size_t > num_allocations( 0u );
+
+std::size_t read_status_kb( const std::string& key )
+{
+  std::ifstream is( "/proc/self/status" );
+  std::string line;
+  while ( std::getline( is, line ) )
+  {
+    if ( line.compare( 0u, key.size(), key ) == 0 && line.size() > key.size() && line[key.size()] == ':' )
+    {
+      std::istringstream ss( line.substr( key.size() + 1u ) );
+      std::size_t kb = 0u;
+      ss >> kb;
+      return kb;
+    }
+  }
+  return 0u;
+}
+
+}
+
+std::size_t current_rss_kb()
+{
+  return read_status_kb( "VmRSS" );
+}
+
+std::size_t peak_rss_kb()
+{
+  return read_status_kb( "VmHWM" );
+}
+
+bool reset_peak_rss()
+{
+  std::ofstream os( "/proc/self/clear_refs" );
+  os << "5";
+  os.close();
+  return os.good();
+}
+
+void release_free_memory()
+{
+#ifdef __GLIBC__
+  malloc_trim( 0 );
+#endif
+}
+
+std::size_t allocation_count()
+{
+  return num_allocations.load();
+}
+
+#ifdef SMT2EVAL_COUNT_ALLOCATIONS
+void* operator new( std::size_t size )
+{
+  num_allocations.fetch_add( 1u, std::memory_order_relaxed );
+  if ( void *p = std::malloc( size > 0u ? size : 1u ) )
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete( void *p ) noexcept
+{
+  std::free( p );
+}
+#endif
+
+memory_phase_report::memory_phase_report( bool enabled )
+  : enabled( enabled )
+  , resettable( enabled && reset_peak_rss() )
+{}
+
+void memory_phase_report::phase( const std::string& name )
+{
+  if ( !enabled )
+  {
+    return;
+  }
+
+  std::cout << "[i] " << std::left << std::setw( 9 ) << ( name + ":" ) << std::right
+            << "peak " << peak_rss_kb() << " kB, current " << current_rss_kb() << " kB"
+            << ( resettable ? "" : " (peak since start)" ) << '\n';
+  if ( resettable )
+  {
+    reset_peak_rss();
+  }
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,76 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file memory_utils.hpp
+ *
+ * @brief resident set size of the running process
+ *
+ * The values are read from /proc/self/status, i.e., they are only
+ * available on Linux; elsewhere all functions report 0.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <cstddef>
+#include <string>
+
+#pragma once
+
+/* current and peak resident set size in kB */
+std::size_t current_rss_kb();
+std::size_t peak_rss_kb();
+
+/*
+ * Resets the peak resident set size to the current one (Linux 4.0 and
+ * later).  Returns false if the kernel does not support it.
+ */
+bool reset_peak_rss();
+
+/* returns freed heap memory to the operating system if possible */
+void release_free_memory();
+
+/*
+ * Number of calls to operator new so far.  Only counted if built with
+ * SMT2EVAL_COUNT_ALLOCATIONS, otherwise always 0.
+ */
+std::size_t allocation_count();
+
+/**
+ * Prints the peak resident set size of consecutive phases, e.g.,
+ *
+ *   [i] parse:   peak 812340 kB, current 790112 kB
+ */
+class memory_phase_report
+{
+public:
+  explicit memory_phase_report( bool enabled );
+
+  /* ends the current phase */
+  void phase( const std::string& name );
+
+private:
+  bool enabled;
+  bool resettable;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
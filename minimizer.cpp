@@ -0,0 +1,126 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "minimizer.hpp"
+#include "z3_utils.hpp"
+
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+bool is_kind( const z3::expr& e, Z3_decl_kind kind )
+{
+  return e.is_app() && e.decl().decl_kind() == kind;
+}
+
+z3::expr fresh_constant( const z3::expr& e, unsigned& fresh )
+{
+  const std::string name = "minimize!" + std::to_string( fresh++ );
+  return e.ctx().constant( name.c_str(), e.get_sort() );
+}
+
+}
+
+z3::expr make_conjunction( z3::context& ctx, const std::vector< z3::expr >& conjuncts )
+{
+  if ( conjuncts.empty() )
+  {
+    return ctx.bool_val( true );
+  }
+  if ( conjuncts.size() == 1u )
+  {
+    return conjuncts.front();
+  }
+  std::vector< Z3_ast > asts( conjuncts.begin(), conjuncts.end() );
+  return z3::expr( ctx, Z3_mk_and( ctx, asts.size(), &asts[0u] ) );
+}
+
+std::vector< z3::expr > simpler_terms( const z3::expr& e, unsigned& fresh )
+{
+  std::vector< z3::expr > terms;
+  if ( !e.is_app() || is_variable( e ) || is_kind( e, Z3_OP_TRUE ) || is_kind( e, Z3_OP_FALSE ) )
+  {
+    return terms;
+  }
+
+  /*** Constants ***/
+  if ( e.is_bool() )
+  {
+    terms.push_back( e.ctx().bool_val( false ) );
+    terms.push_back( e.ctx().bool_val( true ) );
+  }
+  else if ( e.is_bv() )
+  {
+    const z3::expr zero = e.ctx().bv_val( 0, e.get_sort().bv_size() );
+    if ( is_kind( e, Z3_OP_BNUM ) )
+    {
+      /* numerals only become zero */
+      if ( !z3::eq( e, zero ) )
+      {
+        terms.push_back( zero );
+      }
+      return terms;
+    }
+    terms.push_back( zero );
+  }
+
+  /*** Arguments of the same sort ***/
+  for ( unsigned i = 0u; i < e.num_args(); ++i )
+  {
+    if ( z3::eq( e.arg( i ).get_sort(), e.get_sort() ) )
+    {
+      terms.push_back( e.arg( i ) );
+    }
+  }
+
+  if ( e.is_bool() || e.is_bv() || e.is_array() )
+  {
+    terms.push_back( fresh_constant( e, fresh ) );
+  }
+  return terms;
+}
+
+bool write_smt2_instance( const std::string& filename, const std::vector< z3::expr >& assertions, z3::context& ctx )
+{
+  std::ofstream os( filename.c_str() );
+  if ( !os )
+  {
+    std::cerr << "[e] cannot write " << filename << '\n';
+    return false;
+  }
+
+  /* the solver prints the declarations and assertions in SMT-LIB2 */
+  z3::solver solver( ctx );
+  bool arrays = false;
+  for ( const auto& a : assertions )
+  {
+    arrays = arrays || contains_arrays( a );
+    solver.add( a );
+  }
+  os << "(set-logic " << ( arrays ? "QF_ABV" : "QF_BV" ) << ")\n"
+     << Z3_solver_to_string( ctx, solver )
+     << "(check-sat)\n";
+  return static_cast< bool >( os );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
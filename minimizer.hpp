@@ -0,0 +1,487 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file minimizer.hpp
+ *
+ * @brief delta debugging of instances on which metaSMT and Z3 disagree
+ *
+ * The parsed instance stays in memory while it is shrunk in two
+ * phases.  First, top-level assertions are dropped by ddmin, i.e.,
+ * subsets and complements of ever smaller chunks are kept as long as
+ * the answers still differ.  Second, the terms are visited parents
+ * first and replaced by a constant, one of their arguments of the same
+ * sort or a fresh variable.  A change is kept if the answers of the
+ * backend and Z3 still differ; an unknown answer of Z3 counts as
+ * agreement.
+ *
+ * Without rewriting options and --polarity, the assertions are
+ * dropped incrementally: every assertion is converted once under a
+ * selector literal and the subsets are checked under assumptions, in
+ * the backend as well as in Z3.  Since a conversion problem may depend
+ * on the dropped assertions, the result is checked again on its own
+ * and the assertions are dropped with fresh contexts if the
+ * disagreement is lost.  All other checks convert the candidate in a
+ * fresh context; the candidates of one step are checked on --threads
+ * threads if the backend is reentrant (see backend_traits), each in
+ * its own Z3 context.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+#include "checker_options.hpp"
+#include "component_solving.hpp"
+#include "cube_and_conquer.hpp"
+#include "decomposition.hpp"
+#include "parallel_utils.hpp"
+#include "preprocess.hpp"
+#include "z3_expr_visitor.hpp"
+#include "z3_utils.hpp"
+
+#include <z3++.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#pragma once
+
+struct minimizer_stats
+{
+  minimizer_stats()
+    : assertions_before( 0u )
+    , assertions_after( 0u )
+    , nodes_before( 0u )
+    , nodes_after( 0u )
+    , checks( 0u )
+    , replacements( 0u )
+  {}
+
+  unsigned assertions_before;
+  unsigned assertions_after;
+  unsigned nodes_before;
+  unsigned nodes_after;
+  unsigned checks;        /* solves of both metaSMT and Z3 */
+  unsigned replacements;  /* accepted term replacements */
+};
+
+/* conjunction of `conjuncts', true if empty */
+z3::expr make_conjunction( z3::context& ctx, const std::vector< z3::expr >& conjuncts );
+
+/**
+ * Replacements of `e' from simplest to most general: false and true
+ * or zero, the arguments of the same sort and a fresh variable.
+ * Variables and Boolean constants have none.
+ */
+std::vector< z3::expr > simpler_terms( const z3::expr& e, unsigned& fresh );
+
+bool write_smt2_instance( const std::string& filename, const std::vector< z3::expr >& assertions, z3::context& ctx );
+
+/**
+ * ddmin over the indices 0, ..., n-1.  `first_failing' receives a list
+ * of subsets and returns the index of the first one that still fails,
+ * or the size of the list.  Returns a subset of which no chunk at the
+ * finest granularity can be removed.
+ */
+template < typename F >
+std::vector< unsigned > delta_debug( unsigned n, F first_failing )
+{
+  std::vector< unsigned > current( n );
+  for ( unsigned i = 0u; i < n; ++i )
+  {
+    current[i] = i;
+  }
+
+  unsigned granularity = 2u;
+  while ( current.size() >= 2u )
+  {
+    /*** Chunks first, then their complements ***/
+    std::vector< std::vector< unsigned > > subsets( 2u * granularity );
+    for ( unsigned i = 0u; i < current.size(); ++i )
+    {
+      const unsigned chunk = static_cast< unsigned >( static_cast< uint64_t >( i ) * granularity / current.size() );
+      subsets[chunk].push_back( current[i] );
+      for ( unsigned c = 0u; c < granularity; ++c )
+      {
+        if ( c != chunk )
+        {
+          subsets[granularity + c].push_back( current[i] );
+        }
+      }
+    }
+
+    const unsigned i = first_failing( subsets );
+    if ( i < granularity )
+    {
+      current = subsets[i];
+      granularity = 2u;
+    }
+    else if ( i < subsets.size() )
+    {
+      current = subsets[i];
+      granularity = std::max( granularity - 1u, 2u );
+    }
+    else if ( granularity >= current.size() )
+    {
+      break;
+    }
+    else
+    {
+      granularity = std::min( 2u * granularity, static_cast< unsigned >( current.size() ) );
+    }
+  }
+  return current;
+}
+
+/**
+ * Checks candidates with a fresh solver context each, preprocessed as
+ * by the consistency check.
+ */
+template < typename Solver >
+class disagreement_checker
+{
+public:
+  explicit disagreement_checker( const checker_options& options )
+    : options( options )
+    , threads( backend_traits< Solver >::reentrant ? checker_threads( options ) : 1u )
+    , checks( 0u )
+  {
+    this->options.stats = false;
+  }
+
+  /* index of the first candidate on which metaSMT and Z3 disagree, or the number of candidates */
+  unsigned first_disagreement( const std::vector< z3::expr >& candidates )
+  {
+    std::atomic< bool > found( false );
+    std::atomic< unsigned > first( candidates.size() );
+    std::atomic< unsigned > calls( 0u );
+    std::mutex translate_mutex;
+
+    /* candidates are handed out in order, hence all before `first' were checked */
+    parallel_for_each( candidates.size(), threads, found, [&]( unsigned i ) {
+        z3::context ctx;
+        z3::expr formula( ctx );
+        {
+          /* the context of the candidates is shared */
+          std::lock_guard< std::mutex > lock( translate_mutex );
+          formula = translate_expr( candidates[i], ctx );
+        }
+        ++calls;
+        if ( disagrees( formula ) )
+        {
+          unsigned f = first.load();
+          while ( i < f && !first.compare_exchange_weak( f, i ) ) {}
+          found = true;
+        }
+      } );
+    checks += calls.load();
+    return first.load();
+  }
+
+  unsigned num_checks() const
+  {
+    return checks;
+  }
+
+private:
+  bool disagrees( const z3::expr& formula ) const
+  {
+    try
+    {
+      z3::solver z3( formula.ctx() );
+      z3.add( formula );
+      const z3::check_result expected = z3.check();
+      if ( expected == z3::unknown )
+      {
+        return false;
+      }
+      const z3::expr instance = preprocess_instance( formula, options );
+      const bool sat = options.polarity ? solve_polarity_aware< Solver >( instance, false ) : solve_component< Solver >( instance );
+      return sat != ( expected == z3::sat );
+    }
+    catch ( const z3::exception& )
+    {
+      return false;
+    }
+  }
+
+  checker_options options;
+  unsigned threads;
+  unsigned checks;
+};
+
+/**
+ * All assertions converted once into one context, each enabled by a
+ * selector literal that is assumed for the checked subsets.
+ */
+template < typename Solver >
+class assertion_tester
+{
+public:
+  using result_type = typename Solver::result_type;
+
+  explicit assertion_tester( const std::vector< z3::expr >& assertions )
+    : generator( solver )
+    , z3( assertions.front().ctx() )
+    , checks( 0u )
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+
+    z3::context& ctx = assertions.front().ctx();
+    for ( unsigned i = 0u; i < assertions.size(); ++i )
+    {
+      const std::string name = "minimize!assertion" + std::to_string( i );
+      z3_selectors.push_back( ctx.bool_const( name.c_str() ) );
+      z3.add( z3::implies( z3_selectors.back(), assertions[i] ) );
+
+      selectors.push_back( evaluate( solver, new_variable() ) );
+      const result_type r = generator( assertions[i] );
+      assertion( solver, evaluate( solver, implies( selectors.back(), r ) ) );
+    }
+  }
+
+  /* index of the first subset on which metaSMT and Z3 disagree, or the number of subsets */
+  unsigned first_disagreement( const std::vector< std::vector< unsigned > >& subsets )
+  {
+    for ( unsigned i = 0u; i < subsets.size(); ++i )
+    {
+      ++checks;
+      if ( disagrees( subsets[i] ) )
+      {
+        return i;
+      }
+    }
+    return subsets.size();
+  }
+
+  unsigned num_checks() const
+  {
+    return checks;
+  }
+
+private:
+  bool disagrees( const std::vector< unsigned >& subset )
+  {
+    z3::expr_vector assumptions( z3.ctx() );
+    for ( const auto& i : subset )
+    {
+      assumptions.push_back( z3_selectors[i] );
+    }
+    const z3::check_result expected = z3.check( assumptions );
+    if ( expected == z3::unknown )
+    {
+      return false;
+    }
+
+    /* assumptions only hold for one solve, refinements solve again */
+    bool sat = false;
+    for ( ;; )
+    {
+      for ( const auto& i : subset )
+      {
+        metaSMT::assumption( solver, selectors[i] );
+      }
+      if ( !metaSMT::solve( solver ) )
+      {
+        break;
+      }
+      if ( !generator.refine() )
+      {
+        sat = true;
+        break;
+      }
+    }
+    return sat != ( expected == z3::sat );
+  }
+
+  Solver solver;
+  result_type_generator< Solver > generator;
+  std::vector< result_type > selectors;
+  z3::solver z3;
+  std::vector< z3::expr > z3_selectors;
+  unsigned checks;
+};
+
+/* the assertions with the given indices */
+inline std::vector< z3::expr > select_assertions( const std::vector< z3::expr >& assertions, const std::vector< unsigned >& subset )
+{
+  std::vector< z3::expr > selected;
+  for ( const auto& i : subset )
+  {
+    selected.push_back( assertions[i] );
+  }
+  return selected;
+}
+
+/**
+ * Drops top-level assertions of `instance' and replaces its terms
+ * while metaSMT and Z3 still disagree, and writes the result to
+ * options.minimize.  Returns false if the disagreement does not
+ * reproduce with a fresh context or the file cannot be written.
+ */
+template < typename Solver >
+bool minimize_inconsistency( const z3::expr& instance, const checker_options& options )
+{
+  const auto start = std::chrono::steady_clock::now();
+  z3::context& ctx = instance.ctx();
+  minimizer_stats stats;
+  disagreement_checker< Solver > checker( options );
+
+  std::vector< z3::expr > assertions;
+  collect_conjuncts( instance, assertions );
+  stats.assertions_before = assertions.size();
+  stats.nodes_before = topological_order( instance ).size();
+
+  if ( checker.first_disagreement( std::vector< z3::expr >( 1u, instance ) ) != 0u )
+  {
+    std::cerr << "[e] minimize: metaSMT and Z3 agree when the instance is checked again\n";
+    return false;
+  }
+
+  /*** Drop top-level assertions ***/
+  auto fresh_contexts = [&]( const std::vector< std::vector< unsigned > >& subsets ) {
+    std::vector< z3::expr > candidates;
+    for ( const auto& s : subsets )
+    {
+      candidates.push_back( make_conjunction( ctx, select_assertions( assertions, s ) ) );
+    }
+    return checker.first_disagreement( candidates );
+  };
+
+  std::vector< unsigned > kept;
+  if ( !options.preprocess && !options.reduce_widths && !options.sweep && !options.polarity )
+  {
+    unsigned incremental_checks = 0u;
+    {
+      assertion_tester< Solver > tester( assertions );
+      kept = delta_debug( assertions.size(), [&]( const std::vector< std::vector< unsigned > >& subsets ) {
+          return tester.first_disagreement( subsets );
+        } );
+      incremental_checks = tester.num_checks();
+    }
+    stats.checks += incremental_checks;
+
+    const z3::expr reduced = make_conjunction( ctx, select_assertions( assertions, kept ) );
+    if ( checker.first_disagreement( std::vector< z3::expr >( 1u, reduced ) ) != 0u )
+    {
+      std::cout << "[i] minimize: the disagreement depends on the dropped assertions, dropping again with fresh contexts\n";
+      kept = delta_debug( assertions.size(), fresh_contexts );
+    }
+  }
+  else
+  {
+    kept = delta_debug( assertions.size(), fresh_contexts );
+  }
+  z3::expr current = make_conjunction( ctx, select_assertions( assertions, kept ) );
+
+  /*** Replace terms, parents first, one term per thread and step ***/
+  const unsigned batch = backend_traits< Solver >::reentrant ? checker_threads( options ) : 1u;
+  std::unordered_set< unsigned > tried;
+  std::vector< z3::expr > tried_terms;  /* keeps their ids from being reused */
+  auto mark_tried = [&]( const z3::expr& e ) {
+    if ( tried.insert( z3_expr_id( e ) ).second )
+    {
+      tried_terms.push_back( e );
+    }
+  };
+  unsigned fresh = 0u;
+  for ( ;; )
+  {
+    const std::vector< z3::expr > order = topological_order( current );
+    std::vector< z3::expr > candidates;
+    std::vector< unsigned > owners;  /* positions in `order' */
+    unsigned terms = 0u;
+    for ( unsigned k = order.size(); k > 0u && terms < batch; --k )
+    {
+      const z3::expr& e = order[k - 1u];
+      if ( tried.count( z3_expr_id( e ) ) )
+      {
+        continue;
+      }
+      const std::vector< z3::expr > simpler = simpler_terms( e, fresh );
+      if ( simpler.empty() )
+      {
+        mark_tried( e );
+        continue;
+      }
+
+      z3::expr_vector from( ctx ), to( ctx );
+      from.push_back( e );
+      for ( const auto& s : simpler )
+      {
+        to.push_back( s );
+        candidates.push_back( current.substitute( from, to ) );
+        to.pop_back();
+        owners.push_back( k - 1u );
+      }
+      ++terms;
+    }
+    if ( candidates.empty() )
+    {
+      break;
+    }
+
+    /* terms before the accepted one keep failing on the smaller instance */
+    const unsigned i = checker.first_disagreement( candidates );
+    for ( unsigned j = 0u; j < candidates.size() && ( i == candidates.size() || owners[j] != owners[i] ); ++j )
+    {
+      mark_tried( order[owners[j]] );
+    }
+    if ( i < candidates.size() )
+    {
+      current = candidates[i];
+      ++stats.replacements;
+    }
+  }
+
+  /*** Write the remaining assertions ***/
+  std::vector< z3::expr > result;
+  collect_conjuncts( current, result );
+  result.erase( std::remove_if( result.begin(), result.end(), []( const z3::expr& e ) {
+        return e.is_app() && e.decl().decl_kind() == Z3_OP_TRUE;
+      } ), result.end() );
+  stats.assertions_after = result.size();
+  stats.nodes_after = topological_order( current ).size();
+  stats.checks += checker.num_checks();
+
+  const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  std::cout << "[i] minimize: " << stats.assertions_before << " -> " << stats.assertions_after << " assertions, "
+            << stats.nodes_before << " -> " << stats.nodes_after << " nodes, " << stats.replacements << " replacements, "
+            << stats.checks << " checks, " << seconds << " s\n";
+
+  if ( !write_smt2_instance( options.minimize, result, ctx ) )
+  {
+    return false;
+  }
+  std::cout << "[i] minimize: written to " << options.minimize << '\n';
+  return true;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,189 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file nonlinear_abstraction.hpp
+ *
+ * @brief abstraction refinement for bvmul, bvudiv and bvurem
+ *
+ * Each application is replaced by a fresh bit-vector with a few cheap
+ * side constraints:
+ *
+ *   bvmul:  a = 0 or b = 0 -> r = 0,  a = 1 -> r = b,  b = 1 -> r = a
+ *   bvudiv: b = 0 -> r = ~0,  r <= a,  b = 1 -> r = a
+ *   bvurem: b = 0 -> r = a,  b != 0 -> r < b,  r <= a
+ *
+ * refine() evaluates every abstracted application on the model and
+ * adds the exact circuit only for the applications whose abstract
+ * result differs from the concrete one.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "bv_value.hpp"
+
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/frontend/Logic.hpp>
+#include <metaSMT/frontend/QF_BV.hpp>
+
+#include <z3++.h>
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+#pragma once
+
+template < typename Solver >
+class nonlinear_abstraction
+{
+public:
+  using result_type = typename Solver::result_type;
+
+  explicit nonlinear_abstraction( Solver& solver )
+    : solver( solver )
+    , enabled( false )
+    , num_refined( 0u )
+  {}
+
+  void enable( bool value ) { enabled = value; }
+
+  bool is_abstracted( Z3_decl_kind kind ) const
+  {
+    return enabled && ( kind == Z3_OP_BMUL || kind == Z3_OP_BUDIV || kind == Z3_OP_BUREM );
+  }
+
+  bool empty() const { return applications.empty(); }
+  unsigned abstracted() const { return applications.size(); }
+  unsigned refined() const { return num_refined; }
+
+  result_type abstract( Z3_decl_kind kind, unsigned width, const result_type& a, const result_type& b )
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+    using namespace metaSMT::logic::QF_BV;
+
+    const result_type r = evaluate( solver, new_bitvector( width ) );
+    const result_type zero = evaluate( solver, bvbin( std::string( width, '0' ) ) );
+    const result_type one = evaluate( solver, bvbin( std::string( width - 1u, '0' ) + "1" ) );
+
+    switch ( kind )
+    {
+    case Z3_OP_BMUL:
+      assertion( solver, evaluate( solver, implies( Or( logic::equal( a, zero ), logic::equal( b, zero ) ), logic::equal( r, zero ) ) ) );
+      assertion( solver, evaluate( solver, implies( logic::equal( a, one ), logic::equal( r, b ) ) ) );
+      assertion( solver, evaluate( solver, implies( logic::equal( b, one ), logic::equal( r, a ) ) ) );
+      break;
+    case Z3_OP_BUDIV:
+      assertion( solver, evaluate( solver, implies( logic::equal( b, zero ), logic::equal( r, bvbin( std::string( width, '1' ) ) ) ) ) );
+      assertion( solver, evaluate( solver, implies( logic::nequal( b, zero ), bvule( r, a ) ) ) );
+      assertion( solver, evaluate( solver, implies( logic::equal( b, one ), logic::equal( r, a ) ) ) );
+      break;
+    case Z3_OP_BUREM:
+      assertion( solver, evaluate( solver, implies( logic::equal( b, zero ), logic::equal( r, a ) ) ) );
+      assertion( solver, evaluate( solver, implies( logic::nequal( b, zero ), bvult( r, b ) ) ) );
+      assertion( solver, evaluate( solver, bvule( r, a ) ) );
+      break;
+    default:
+      assert( false );
+      break;
+    }
+
+    application app = { kind, a, b, r, false };
+    applications.push_back( app );
+    return r;
+  }
+
+  /**
+   * Adds the exact constraint for every application violated by the
+   * current model.  Returns the number of refined applications.
+   */
+  unsigned refine()
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+    using namespace metaSMT::logic::QF_BV;
+
+    unsigned n = 0u;
+    for ( auto& app : applications )
+    {
+      if ( app.refined )
+      {
+        continue;
+      }
+
+      const bv_value a = model_value( app.lhs );
+      const bv_value b = model_value( app.rhs );
+      bv_value expected;
+      switch ( app.kind )
+      {
+      case Z3_OP_BMUL:  expected = bv_mul( a, b ); break;
+      case Z3_OP_BUDIV: expected = bv_udiv( a, b ); break;
+      default:          expected = bv_urem( a, b ); break;
+      }
+      if ( expected == model_value( app.result ) )
+      {
+        continue;
+      }
+
+      switch ( app.kind )
+      {
+      case Z3_OP_BMUL:
+        assertion( solver, evaluate( solver, logic::equal( app.result, bvmul( app.lhs, app.rhs ) ) ) );
+        break;
+      case Z3_OP_BUDIV:
+        assertion( solver, evaluate( solver, logic::equal( app.result, bvudiv( app.lhs, app.rhs ) ) ) );
+        break;
+      default:
+        assertion( solver, evaluate( solver, logic::equal( app.result, bvurem( app.lhs, app.rhs ) ) ) );
+        break;
+      }
+      app.refined = true;
+      ++n;
+    }
+    num_refined += n;
+    return n;
+  }
+
+private:
+  struct application
+  {
+    Z3_decl_kind kind;
+    result_type lhs;
+    result_type rhs;
+    result_type result;
+    bool refined;
+  };
+
+  bv_value model_value( const result_type& r )
+  {
+    const std::string bits = metaSMT::read_value( solver, r );
+    return bv_value::from_binary( bits );
+  }
+
+  Solver& solver;
+  bool enabled;
+  unsigned num_refined;
+  std::vector< application > applications;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,793 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file operator_conversion.hpp
+ *
+ * @brief conversion of a single operator application to metaSMT
+ *
+ * The conversion only depends on the operator kind, its parameters
+ * and the already converted arguments, hence it is shared by all
+ * front ends that produce metaSMT terms (the Z3 expression visitor
+ * and the snapshot loader).
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "backend_traits.hpp"
+#include "conversion_utils.hpp"
+#include "z3_utils.hpp"
+
+#include <metaSMT/support/default_visitation_unrolling_limit.hpp>
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/frontend/Array.hpp>
+#include <metaSMT/frontend/Logic.hpp>
+#include <metaSMT/frontend/QF_BV.hpp>
+
+#include <z3++.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#pragma once
+
+/**
+ * Operator kind, result width (0 for Boolean results) and integer
+ * parameters, e.g., the bounds of an extract.  For shifts and rotates
+ * by a numeral, `amount' holds the numeral (see set_constant_amount).
+ */
+struct operator_node
+{
+  operator_node()
+    : kind( Z3_OP_UNINTERPRETED )
+    , width( 0u )
+    , param0( 0u )
+    , param1( 0u )
+    , constant_amount( false )
+    , amount( 0u )
+  {}
+
+  Z3_decl_kind kind;
+  unsigned width;
+  unsigned param0;
+  unsigned param1;
+  bool constant_amount;
+  unsigned amount;
+};
+
+/* operators whose second argument is a shift or rotate amount */
+inline bool has_amount_argument( Z3_decl_kind kind )
+{
+  return kind == Z3_OP_BSHL || kind == Z3_OP_BLSHR || kind == Z3_OP_BASHR || kind == Z3_OP_EXT_ROTATE_LEFT || kind == Z3_OP_EXT_ROTATE_RIGHT;
+}
+
+/**
+ * Records the numeral `bits' as amount of a shift or rotate with known
+ * width.  Shift amounts saturate at the width, rotate amounts are taken
+ * modulo the width.
+ */
+inline void set_constant_amount( operator_node& node, const std::string& bits )
+{
+  const bool rotate = node.kind == Z3_OP_EXT_ROTATE_LEFT || node.kind == Z3_OP_EXT_ROTATE_RIGHT;
+  unsigned long long v = 0u;
+  for ( const char c : bits )
+  {
+    v = 2u * v + ( c == '1' ? 1u : 0u );
+    v = rotate ? v % node.width : std::min< unsigned long long >( v, node.width );
+  }
+  node.constant_amount = true;
+  node.amount = static_cast< unsigned >( v );
+}
+
+inline operator_node make_operator_node( const z3::expr& e )
+{
+  operator_node node;
+  node.kind = e.decl().decl_kind();
+  node.width = e.get_sort().is_bv() ? e.get_sort().bv_size() : 0u;
+  const unsigned num_parameters = decl_num_parameters( e );
+  if ( num_parameters > 0u && Z3_get_decl_parameter_kind( e.ctx(), e.decl(), 0u ) == Z3_PARAMETER_INT )
+  {
+    node.param0 = decl_int_parameter( e, 0u );
+  }
+  if ( num_parameters > 1u && Z3_get_decl_parameter_kind( e.ctx(), e.decl(), 1u ) == Z3_PARAMETER_INT )
+  {
+    node.param1 = decl_int_parameter( e, 1u );
+  }
+  if ( has_amount_argument( node.kind ) && e.num_args() == 2u && e.arg( 1u ).decl().decl_kind() == Z3_OP_BNUM )
+  {
+    set_constant_amount( node, expr_to_bin( e.arg( 1u ) ) );
+  }
+  return node;
+}
+
+/**
+ * Arguments passed by reference, e.g., into the result table of a
+ * converter.  Bit-blasted results hold one literal per bit, copying
+ * them for every use of a shared node is expensive.
+ */
+template < typename T >
+class argument_refs
+{
+public:
+  void reserve( std::size_t n ) { refs.reserve( n ); }
+  void clear() { refs.clear(); }
+  void push_back( const T& value ) { refs.push_back( &value ); }
+
+  std::size_t size() const { return refs.size(); }
+  bool empty() const { return refs.empty(); }
+  const T& operator[]( std::size_t i ) const { return *refs[i]; }
+
+private:
+  std::vector< const T* > refs;
+};
+
+/*
+ * Arrays are only converted natively for backends with array support
+ * (see array_backend), the other backends never see array terms (see
+ * array_lemmas).
+ */
+template < typename Solver >
+typename Solver::result_type make_array_variable( Solver& solver, unsigned elem_width, unsigned index_width, std::true_type )
+{
+  return metaSMT::evaluate( solver, metaSMT::logic::Array::new_array( elem_width, index_width ) );
+}
+
+template < typename Solver >
+typename Solver::result_type make_array_variable( Solver&, unsigned, unsigned, std::false_type )
+{
+  std::cerr << "[e] make_array_variable: backend does not support arrays\n";
+  assert( false );
+  return typename Solver::result_type();
+}
+
+template < typename Solver, typename Arguments >
+typename Solver::result_type convert_array_application( Solver& solver, const operator_node& node, const Arguments& args, std::true_type )
+{
+  using namespace metaSMT::logic::Array;
+
+  if ( node.kind == Z3_OP_SELECT )
+  {
+    assert( args.size() == 2u );
+    return metaSMT::evaluate( solver, select( args[0], args[1] ) );
+  }
+  assert( node.kind == Z3_OP_STORE && args.size() == 3u );
+  return metaSMT::evaluate( solver, store( args[0], args[1], args[2] ) );
+}
+
+template < typename Solver, typename Arguments >
+typename Solver::result_type convert_array_application( Solver&, const operator_node&, const Arguments&, std::false_type )
+{
+  std::cerr << "[e] convert_array_application: backend does not support arrays\n";
+  assert( false );
+  return typename Solver::result_type();
+}
+
+/*
+ * Shifts and rotates by numerals are pure wiring, i.e., extracts and
+ * concatenations of the argument.  Rotates by a variable amount use a
+ * logarithmic barrel network.
+ */
+template < typename Solver >
+typename Solver::result_type rotate_left_wiring( Solver& solver, const typename Solver::result_type& arg, unsigned width, unsigned n )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic::QF_BV;
+
+  n %= width;
+  if ( n == 0u )
+  {
+    return arg;
+  }
+  const typename Solver::result_type lower = evaluate( solver, extract( width-1u-n, 0u, arg ) );
+  const typename Solver::result_type higher = evaluate( solver, extract( width-1u, width-n, arg ) );
+  return evaluate( solver, concat( lower, higher ) );
+}
+
+template < typename Solver >
+typename Solver::result_type shift_wiring( Solver& solver, Z3_decl_kind kind, const typename Solver::result_type& arg, unsigned width, unsigned n )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic::QF_BV;
+
+  if ( kind == Z3_OP_BASHR )
+  {
+    /* all bits are copies of the sign beyond width - 1 */
+    n = std::min( n, width - 1u );
+  }
+  if ( n == 0u )
+  {
+    return arg;
+  }
+  if ( n >= width )
+  {
+    return evaluate( solver, bvbin( std::string( width, '0' ) ) );
+  }
+
+  switch ( kind )
+  {
+  case Z3_OP_BSHL:
+    return evaluate( solver, concat( extract( width-1u-n, 0u, arg ), bvbin( std::string( n, '0' ) ) ) );
+  case Z3_OP_BLSHR:
+    return evaluate( solver, concat( bvbin( std::string( n, '0' ) ), extract( width-1u, n, arg ) ) );
+  default:
+    assert( kind == Z3_OP_BASHR );
+    return evaluate( solver, sign_extend( n, extract( width-1u, n, arg ) ) );
+  }
+}
+
+template < typename Solver >
+typename Solver::result_type barrel_rotate( Solver& solver, bool left, const typename Solver::result_type& arg,
+                                            const typename Solver::result_type& amount, unsigned width )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic;
+  using namespace metaSMT::logic::QF_BV;
+  using result_type = typename Solver::result_type;
+
+  /* amounts beyond the width wrap around, which the stages below only
+     get right for powers of two */
+  result_type k = amount;
+  if ( ( width & ( width - 1u ) ) != 0u )
+  {
+    k = evaluate( solver, bvurem( amount, bvbin( convert_dec2bin( std::to_string( width ), width ) ) ) );
+  }
+
+  result_type r = arg;
+  for ( unsigned i = 0u; ( 1ull << i ) < width; ++i )
+  {
+    const unsigned n = left ? ( 1u << i ) : width - ( 1u << i );
+    const result_type bit = evaluate( solver, logic::equal( extract( i, i, k ), bvbin( "1" ) ) );
+    r = evaluate( solver, Ite( bit, rotate_left_wiring( solver, r, width, n ), r ) );
+  }
+  return r;
+}
+
+/**
+ * bvsmod as defined by SMT-LIB: the remainder of the absolute values
+ * with the sign fixed up to the one of the divisor (as in simulation).
+ */
+template < typename Solver >
+typename Solver::result_type signed_modulo( Solver& solver, const typename Solver::result_type& a, const typename Solver::result_type& b,
+                                            unsigned width )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic;
+  using namespace metaSMT::logic::QF_BV;
+  using result_type = typename Solver::result_type;
+
+  const result_type a_neg = evaluate( solver, logic::equal( extract( width-1u, width-1u, a ), bvbin( "1" ) ) );
+  const result_type b_neg = evaluate( solver, logic::equal( extract( width-1u, width-1u, b ), bvbin( "1" ) ) );
+  const result_type u = evaluate( solver, bvurem( Ite( a_neg, bvneg( a ), a ), Ite( b_neg, bvneg( b ), b ) ) );
+  const result_type u_neg = evaluate( solver, bvneg( u ) );
+
+  const result_type m = evaluate( solver, Ite( a_neg, Ite( b_neg, u_neg, bvadd( u_neg, b ) ),
+                                                      Ite( b_neg, bvadd( u, b ), u ) ) );
+  return evaluate( solver, Ite( logic::equal( u, bvbin( std::string( width, '0' ) ) ), u, m ) );
+}
+
+/******************************************************************************
+ * operation table                                                            *
+ ******************************************************************************/
+
+namespace operations
+{
+
+using namespace metaSMT::logic;
+using namespace metaSMT::logic::QF_BV;
+using metaSMT::evaluate;
+
+/**
+ * metaSMT operation of a Z3 operator kind.  Every specialization has
+ * the arity (0 for any number of arguments) and apply( solver, node,
+ * args ), which may rely on the arity being checked by the caller.
+ * Kinds without specialization are not supported.
+ */
+template < Z3_decl_kind Kind >
+struct operation;
+
+template < typename Solver, typename Arguments >
+typename Solver::result_type fold_right_and( Solver& solver, const Arguments& args )
+{
+  typename Solver::result_type r = args[args.size()-1u];
+  for ( unsigned i = args.size()-1u; i > 0u; --i )
+  {
+    r = evaluate( solver, And( args[i-1u], r ) );
+  }
+  return r;
+}
+
+template < typename Solver, typename Arguments >
+typename Solver::result_type fold_right_or( Solver& solver, const Arguments& args )
+{
+  typename Solver::result_type r = args[args.size()-1u];
+  for ( unsigned i = args.size()-1u; i > 0u; --i )
+  {
+    r = evaluate( solver, Or( args[i-1u], r ) );
+  }
+  return r;
+}
+
+/*** Boolean operators ***/
+
+template <> struct operation< Z3_OP_EQ >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, metaSMT::logic::equal( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_IFF > : operation< Z3_OP_EQ > {};
+
+template <> struct operation< Z3_OP_DISTINCT >
+{
+  static const unsigned arity = 0u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args )
+  {
+    if ( args.size() == 2u )
+    {
+      return evaluate( s, Not( metaSMT::logic::equal( args[0], args[1] ) ) );
+    }
+    typename S::result_type r = evaluate( s, metaSMT::logic::True );
+    for ( unsigned i = 0u; i < args.size(); ++i )
+    {
+      for ( unsigned j = i+1; j < args.size(); ++j )
+      {
+        r = evaluate( s, And( r, metaSMT::logic::nequal( args[i], args[j] ) ) );
+      }
+    }
+    return r;
+  }
+};
+
+template <> struct operation< Z3_OP_ITE >
+{
+  static const unsigned arity = 3u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, Ite( args[0], args[1], args[2] ) ); }
+};
+
+template <> struct operation< Z3_OP_AND >
+{
+  static const unsigned arity = 0u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return fold_right_and( s, args ); }
+};
+
+template <> struct operation< Z3_OP_OR >
+{
+  static const unsigned arity = 0u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return fold_right_or( s, args ); }
+};
+
+template <> struct operation< Z3_OP_XOR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, Xor( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_NOT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, Not( args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_IMPLIES >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, implies( args[0], args[1] ) ); }
+};
+
+/*** Arithmetic ***/
+
+template <> struct operation< Z3_OP_BNEG >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvneg( args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_BADD >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvadd( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BSUB >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsub( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BMUL >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvmul( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BSDIV >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsdiv( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BUDIV >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvudiv( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BSREM >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsrem( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BSMOD >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args ) { return signed_modulo( s, args[0], args[1], node.width ); }
+};
+
+template <> struct operation< Z3_OP_BUREM >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvurem( args[0], args[1] ) ); }
+};
+
+/*** Comparisons ***/
+
+template <> struct operation< Z3_OP_ULEQ >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvule( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_SLEQ >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsle( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_UGEQ >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvuge( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_SGEQ >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsge( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_ULT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvult( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_SLT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvslt( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_UGT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvugt( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_SGT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvsgt( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BCOMP >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvcomp( args[0], args[1] ) ); }
+};
+
+/*** Bitwise operators ***/
+
+template <> struct operation< Z3_OP_BAND >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvand( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BOR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvor( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BNOT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvnot( args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_BXOR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvxor( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BNAND >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvnand( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BNOR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvnor( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_BXNOR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, bvxnor( args[0], args[1] ) ); }
+};
+
+/*** Concatenation, extraction and extension ***/
+
+template <> struct operation< Z3_OP_CONCAT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node&, const A& args ) { return evaluate( s, concat( args[0], args[1] ) ); }
+};
+
+template <> struct operation< Z3_OP_SIGN_EXT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args ) { return evaluate( s, sign_extend( node.param0, args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_ZERO_EXT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args ) { return evaluate( s, zero_extend( node.param0, args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_EXTRACT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args ) { return evaluate( s, extract( node.param0, node.param1, args[0] ) ); }
+};
+
+template <> struct operation< Z3_OP_REPEAT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    typename S::result_type r = args[0];
+    for ( unsigned i = 1u; i < node.param0; ++i )
+    {
+      r = evaluate( s, concat( r, args[0] ) );
+    }
+    return r;
+  }
+};
+
+/*** Shifts and rotates ***/
+
+template <> struct operation< Z3_OP_BSHL >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return node.constant_amount ? shift_wiring( s, node.kind, args[0], node.width, node.amount ) : evaluate( s, bvshl( args[0], args[1] ) );
+  }
+};
+
+template <> struct operation< Z3_OP_BLSHR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return node.constant_amount ? shift_wiring( s, node.kind, args[0], node.width, node.amount ) : evaluate( s, bvshr( args[0], args[1] ) );
+  }
+};
+
+template <> struct operation< Z3_OP_BASHR >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return node.constant_amount ? shift_wiring( s, node.kind, args[0], node.width, node.amount ) : evaluate( s, bvashr( args[0], args[1] ) );
+  }
+};
+
+template <> struct operation< Z3_OP_ROTATE_LEFT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return rotate_left_wiring( s, args[0], node.width, node.param0 % node.width );
+  }
+};
+
+template <> struct operation< Z3_OP_ROTATE_RIGHT >
+{
+  static const unsigned arity = 1u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return rotate_left_wiring( s, args[0], node.width, node.width - node.param0 % node.width );
+  }
+};
+
+template <> struct operation< Z3_OP_EXT_ROTATE_LEFT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return node.constant_amount ? rotate_left_wiring( s, args[0], node.width, node.amount ) : barrel_rotate( s, true, args[0], args[1], node.width );
+  }
+};
+
+template <> struct operation< Z3_OP_EXT_ROTATE_RIGHT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return node.constant_amount ? rotate_left_wiring( s, args[0], node.width, node.width - node.amount ) : barrel_rotate( s, false, args[0], args[1], node.width );
+  }
+};
+
+/*** Arrays ***/
+
+template <> struct operation< Z3_OP_SELECT >
+{
+  static const unsigned arity = 2u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return convert_array_application( s, node, args, std::integral_constant< bool, array_backend< S >::value >() );
+  }
+};
+
+template <> struct operation< Z3_OP_STORE >
+{
+  static const unsigned arity = 3u;
+  template < typename S, typename A > static typename S::result_type apply( S& s, const operator_node& node, const A& args )
+  {
+    return convert_array_application( s, node, args, std::integral_constant< bool, array_backend< S >::value >() );
+  }
+};
+
+}
+
+/**
+ * Converter and arity of every supported operator kind, indexed by
+ * the family (basic, array, bit-vector) and the offset of the kind in
+ * its family.  The converters are instantiations of
+ * operations::operation for one solver and argument type, such that
+ * each backend gets its own direct calls without a switch.
+ */
+template < typename Solver, typename Arguments >
+class operator_table
+{
+public:
+  using result_type = typename Solver::result_type;
+  typedef result_type (*converter)( Solver&, const operator_node&, const Arguments& );
+
+  struct entry
+  {
+    unsigned arity;     /* 0 for any number of arguments */
+    converter convert;  /* 0 if the kind is not supported */
+  };
+
+  static const entry& find( Z3_decl_kind kind )
+  {
+    static const operator_table table;
+    static const entry unsupported = { 0u, 0 };
+    const unsigned family = family_index( kind ), offset = kind & 0xffu;
+    return family < num_families && offset < family_size ? table.entries[family][offset] : unsupported;
+  }
+
+private:
+  static const unsigned num_families = 3u;
+  static const unsigned family_size = 128u;
+
+  static unsigned family_index( Z3_decl_kind kind )
+  {
+    switch ( kind >> 8u )
+    {
+    case Z3_OP_TRUE >> 8u:  return 0u;
+    case Z3_OP_STORE >> 8u: return 1u;
+    case Z3_OP_BNUM >> 8u:  return 2u;
+    default:                return num_families;
+    }
+  }
+
+  template < Z3_decl_kind Kind >
+  static result_type convert_kind( Solver& solver, const operator_node& node, const Arguments& args )
+  {
+    return operations::operation< Kind >::apply( solver, node, args );
+  }
+
+  template < Z3_decl_kind Kind >
+  void add()
+  {
+    entry& e = entries[family_index( Kind )][Kind & 0xffu];
+    e.arity = operations::operation< Kind >::arity;
+    e.convert = &convert_kind< Kind >;
+  }
+
+  operator_table()
+  {
+    for ( unsigned f = 0u; f < num_families; ++f )
+    {
+      for ( unsigned i = 0u; i < family_size; ++i )
+      {
+        entries[f][i].arity = 0u;
+        entries[f][i].convert = 0;
+      }
+    }
+
+    add< Z3_OP_EQ >(); add< Z3_OP_DISTINCT >(); add< Z3_OP_ITE >(); add< Z3_OP_AND >(); add< Z3_OP_OR >();
+    add< Z3_OP_IFF >(); add< Z3_OP_XOR >(); add< Z3_OP_NOT >(); add< Z3_OP_IMPLIES >();
+
+    add< Z3_OP_BNEG >(); add< Z3_OP_BADD >(); add< Z3_OP_BSUB >(); add< Z3_OP_BMUL >();
+    add< Z3_OP_BSDIV >(); add< Z3_OP_BUDIV >(); add< Z3_OP_BSREM >(); add< Z3_OP_BUREM >(); add< Z3_OP_BSMOD >();
+
+    add< Z3_OP_ULEQ >(); add< Z3_OP_SLEQ >(); add< Z3_OP_UGEQ >(); add< Z3_OP_SGEQ >();
+    add< Z3_OP_ULT >(); add< Z3_OP_SLT >(); add< Z3_OP_UGT >(); add< Z3_OP_SGT >(); add< Z3_OP_BCOMP >();
+
+    add< Z3_OP_BAND >(); add< Z3_OP_BOR >(); add< Z3_OP_BNOT >(); add< Z3_OP_BXOR >();
+    add< Z3_OP_BNAND >(); add< Z3_OP_BNOR >(); add< Z3_OP_BXNOR >();
+
+    add< Z3_OP_CONCAT >(); add< Z3_OP_SIGN_EXT >(); add< Z3_OP_ZERO_EXT >(); add< Z3_OP_EXTRACT >(); add< Z3_OP_REPEAT >();
+
+    add< Z3_OP_BSHL >(); add< Z3_OP_BLSHR >(); add< Z3_OP_BASHR >();
+    add< Z3_OP_ROTATE_LEFT >(); add< Z3_OP_ROTATE_RIGHT >(); add< Z3_OP_EXT_ROTATE_LEFT >(); add< Z3_OP_EXT_ROTATE_RIGHT >();
+
+    add< Z3_OP_SELECT >(); add< Z3_OP_STORE >();
+  }
+
+  entry entries[num_families][family_size];
+};
+
+/**
+ * `args' is either a std::vector of results or argument_refs.
+ */
+template < typename Solver, typename Arguments >
+typename Solver::result_type convert_application( Solver& solver, const operator_node& node, const Arguments& args )
+{
+  assert( !args.empty() && "Expression is not an operator" );
+
+  const typename operator_table< Solver, Arguments >::entry& e = operator_table< Solver, Arguments >::find( node.kind );
+  if ( !e.convert )
+  {
+    std::cerr << "[e] convert_application: does not support operator [ " << std::hex << node.kind << std::dec << "]\n";
+    assert( false );
+    throw std::runtime_error( "unsupported operator" );
+  }
+  assert( e.arity == 0u || args.size() == e.arity );
+  return e.convert( solver, node, args );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
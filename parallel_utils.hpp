@@ -0,0 +1,134 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file parallel_utils.hpp
+ *
+ * @brief minimal work distribution over a fixed number of threads
+ *        and bounded queues between threads
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+/**
+ * Calls f( i ) for i = 0, ..., n-1 on up to `threads` threads.  Work
+ * items are handed out dynamically; no new item is started once
+ * `stop` is set.
+ */
+template < typename F >
+void parallel_for_each( unsigned n, unsigned threads, std::atomic< bool >& stop, F f )
+{
+  std::atomic< unsigned > next( 0u );
+  auto worker = [&]() {
+    for ( ;; )
+    {
+      if ( stop.load() )
+      {
+        return;
+      }
+      const unsigned i = next++;
+      if ( i >= n )
+      {
+        return;
+      }
+      f( i );
+    }
+  };
+
+  threads = std::max( 1u, std::min( threads, n ) );
+  std::vector< std::thread > pool;
+  for ( unsigned t = 1u; t < threads; ++t )
+  {
+    pool.push_back( std::thread( worker ) );
+  }
+  worker();
+  for ( auto& t : pool )
+  {
+    t.join();
+  }
+}
+
+/**
+ * FIFO queue with a fixed capacity between two groups of threads.
+ * push() blocks while the queue is full, pop() blocks while it is
+ * empty and returns false once the queue is closed and drained.
+ */
+template < typename T >
+class bounded_queue
+{
+public:
+  explicit bounded_queue( unsigned capacity )
+    : capacity( std::max( 1u, capacity ) )
+    , closed( false )
+  {}
+
+  void push( T value )
+  {
+    std::unique_lock< std::mutex > lock( mutex );
+    not_full.wait( lock, [this]() { return items.size() < capacity; } );
+    items.push_back( std::move( value ) );
+    not_empty.notify_one();
+  }
+
+  bool pop( T& value )
+  {
+    std::unique_lock< std::mutex > lock( mutex );
+    not_empty.wait( lock, [this]() { return !items.empty() || closed; } );
+    if ( items.empty() )
+    {
+      return false;
+    }
+    value = std::move( items.front() );
+    items.pop_front();
+    not_full.notify_one();
+    return true;
+  }
+
+  /* no more pushes, waiting consumers return once the queue is drained */
+  void close()
+  {
+    std::lock_guard< std::mutex > lock( mutex );
+    closed = true;
+    not_empty.notify_all();
+  }
+
+private:
+  const std::size_t capacity;
+  bool closed;
+  std::deque< T > items;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,196 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perf_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const char *event_names[counter_phase_report::num_events] = { "cycles", "instructions", "cache misses", "branch misses" };
+
+#ifdef __linux__
+const uint64_t event_configs[counter_phase_report::num_events] = {
+  PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+int open_event( uint64_t config )
+{
+  perf_event_attr attr;
+  std::memset( &attr, 0, sizeof( attr ) );
+  attr.size = sizeof( attr );
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;          /* worker threads started later */
+  attr.exclude_kernel = 1;   /* permitted up to perf_event_paranoid 2 */
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast< int >( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) );
+}
+#endif
+
+}
+
+counter_phase_report::counter_phase_report( bool enabled, const std::string& label )
+  : enabled( enabled )
+  , label( label )
+{
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    fds[i] = -1;
+    last[i][0u] = last[i][1u] = last[i][2u] = 0u;
+  }
+  if ( !enabled )
+  {
+    return;
+  }
+
+  int error = ENOSYS;
+#ifdef __linux__
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    fds[i] = open_event( event_configs[i] );
+    if ( fds[i] < 0 )
+    {
+      error = errno;
+    }
+  }
+#endif
+
+  bool any = false;
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    any = any || fds[i] >= 0;
+  }
+  if ( !any )
+  {
+    std::cout << "[i] counters: not available (" << std::strerror( error ) << "), see /proc/sys/kernel/perf_event_paranoid\n";
+    this->enabled = false;
+    return;
+  }
+#ifdef __linux__
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    if ( fds[i] >= 0 )
+    {
+      ioctl( fds[i], PERF_EVENT_IOC_ENABLE, 0 );
+    }
+  }
+#endif
+}
+
+counter_phase_report::~counter_phase_report()
+{
+#ifdef __linux__
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    if ( fds[i] >= 0 )
+    {
+      close( fds[i] );
+    }
+  }
+#endif
+}
+
+void counter_phase_report::phase( const std::string& name )
+{
+  if ( !enabled )
+  {
+    return;
+  }
+
+  uint64_t values[num_events];
+  bool available[num_events], scaled[num_events];
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    available[i] = read( i, values[i], scaled[i] );
+  }
+
+  std::ostringstream os;
+  os << "[i] " << ( label.empty() ? "" : label + ": " ) << std::left << std::setw( 9 ) << ( name + ":" ) << std::right;
+  for ( unsigned i = 0u; i < num_events; ++i )
+  {
+    os << ( i ? ", " : "" );
+    if ( available[i] )
+    {
+      os << ( scaled[i] ? "~" : "" ) << values[i] << ' ' << event_names[i];
+    }
+    else
+    {
+      os << "n/a " << event_names[i];
+    }
+    if ( i == 1u && available[0u] && available[1u] && values[0u] > 0u )
+    {
+      os << " (" << std::fixed << std::setprecision( 2 ) << static_cast< double >( values[1u] ) / values[0u] << " IPC)";
+    }
+  }
+  std::cout << os.str() << '\n';
+}
+
+bool counter_phase_report::read( unsigned event, uint64_t& value, bool& scaled )
+{
+  value = 0u;
+  scaled = false;
+#ifdef __linux__
+  uint64_t data[3];  /* value, time enabled, time running */
+  if ( fds[event] < 0 || ::read( fds[event], data, sizeof( data ) ) != static_cast< ssize_t >( sizeof( data ) ) )
+  {
+    return false;
+  }
+
+  /* the times cannot be reset, hence the phase is the difference to the last reading */
+  uint64_t delta[3];
+  for ( unsigned j = 0u; j < 3u; ++j )
+  {
+    delta[j] = data[j] - last[event][j];
+    last[event][j] = data[j];
+  }
+  if ( delta[2] == 0u )
+  {
+    /* never scheduled, e.g., all counters taken */
+    return false;
+  }
+  value = delta[0];
+  if ( delta[2] < delta[1] )
+  {
+    value = static_cast< uint64_t >( static_cast< double >( delta[0] ) * delta[1] / delta[2] );
+    scaled = true;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
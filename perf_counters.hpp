@@ -0,0 +1,77 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file perf_counters.hpp
+ *
+ * @brief hardware performance counters of consecutive phases
+ *
+ * The counters are opened with perf_event_open for the calling thread
+ * and the threads it creates afterwards, user space only.  They are
+ * only available on Linux, and only if the kernel permits it (see
+ * /proc/sys/kernel/perf_event_paranoid); virtual machines often lack
+ * some of the events.  Missing events are reported as n/a, and the
+ * report is silent apart from one note if no event can be opened.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <cstdint>
+#include <string>
+
+#pragma once
+
+/**
+ * Prints the hardware events of consecutive phases, e.g.,
+ *
+ *   [i] convert: 81234567 cycles, 120345678 instructions (1.48 IPC),
+ *                345678 cache misses, 123456 branch misses
+ *
+ * on one line.  Counts of multiplexed events are scaled to the time
+ * the phase ran and marked with `~'.
+ */
+class counter_phase_report
+{
+public:
+  /* `label', e.g., the instance of a batch run, precedes every line */
+  counter_phase_report( bool enabled, const std::string& label );
+  ~counter_phase_report();
+
+  counter_phase_report( const counter_phase_report& ) = delete;
+  counter_phase_report& operator=( const counter_phase_report& ) = delete;
+
+  /* ends the current phase */
+  void phase( const std::string& name );
+
+  static const unsigned num_events = 4u;
+
+private:
+  /* counts since the last reading */
+  bool read( unsigned event, uint64_t& value, bool& scaled );
+
+  bool enabled;
+  std::string label;
+  int fds[num_events];            /* -1 if the event is not available */
+  uint64_t last[num_events][3u];  /* value, time enabled and time running when last read */
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
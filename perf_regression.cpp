@@ -0,0 +1,572 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perf_regression.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since( const clock_type::time_point& start )
+{
+  return std::chrono::duration< double >( clock_type::now() - start ).count();
+}
+
+double timeval_seconds( const timeval& tv )
+{
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/******************************************************************************
+ * CSV and JSON                                                               *
+ ******************************************************************************/
+
+std::string format_seconds( double seconds )
+{
+  char buf[32];
+  std::snprintf( buf, sizeof( buf ), "%.6f", seconds );
+  return buf;
+}
+
+std::string csv_field( const std::string& s )
+{
+  if ( s.find_first_of( ",\"\n" ) == std::string::npos )
+  {
+    return s;
+  }
+  std::string r = "\"";
+  for ( char c : s )
+  {
+    r += c;
+    if ( c == '"' )
+    {
+      r += c;
+    }
+  }
+  return r + '"';
+}
+
+std::vector< std::string > split_csv_line( const std::string& line )
+{
+  std::vector< std::string > fields( 1u );
+  bool quoted = false;
+  for ( std::size_t i = 0u; i < line.size(); ++i )
+  {
+    const char c = line[i];
+    if ( quoted )
+    {
+      if ( c == '"' && i + 1u < line.size() && line[i + 1u] == '"' )
+      {
+        fields.back() += c;
+        ++i;
+      }
+      else if ( c == '"' )
+      {
+        quoted = false;
+      }
+      else
+      {
+        fields.back() += c;
+      }
+    }
+    else if ( c == '"' )
+    {
+      quoted = true;
+    }
+    else if ( c == ',' )
+    {
+      fields.push_back( std::string() );
+    }
+    else
+    {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+std::string json_string( const std::string& s )
+{
+  std::string r = "\"";
+  for ( char c : s )
+  {
+    if ( c == '"' || c == '\\' )
+    {
+      r += '\\';
+      r += c;
+    }
+    else if ( static_cast< unsigned char >( c ) < 0x20u )
+    {
+      char buf[8];
+      std::snprintf( buf, sizeof( buf ), "\\u%04x", static_cast< unsigned >( c ) );
+      r += buf;
+    }
+    else
+    {
+      r += c;
+    }
+  }
+  return r + '"';
+}
+
+/* samples grouped by backend and instance in the order of their first sample */
+typedef std::pair< std::string, std::string > perf_key;
+
+std::vector< std::pair< perf_key, std::vector< perf_sample > > > group_samples( const std::vector< perf_sample >& samples )
+{
+  std::vector< std::pair< perf_key, std::vector< perf_sample > > > groups;
+  std::map< perf_key, unsigned > index;
+  for ( const auto& s : samples )
+  {
+    const perf_key key( s.backend, s.instance );
+    const auto it = index.insert( std::make_pair( key, groups.size() ) );
+    if ( it.second )
+    {
+      groups.push_back( std::make_pair( key, std::vector< perf_sample >() ) );
+    }
+    groups[it.first->second].second.push_back( s );
+  }
+  return groups;
+}
+
+/******************************************************************************
+ * statistics                                                                 *
+ ******************************************************************************/
+
+double median( std::vector< double > values )
+{
+  if ( values.empty() )
+  {
+    return 0.0;
+  }
+  std::sort( values.begin(), values.end() );
+  const std::size_t n = values.size();
+  return n % 2u == 1u ? values[n / 2u] : 0.5 * ( values[n / 2u - 1u] + values[n / 2u] );
+}
+
+/* exit status of most runs, timeouts count as -1 */
+int typical_code( const std::vector< perf_sample >& samples )
+{
+  std::map< int, unsigned > counts;
+  for ( const auto& s : samples )
+  {
+    ++counts[s.timed_out ? -1 : s.code];
+  }
+  int code = 0;
+  unsigned best = 0u;
+  for ( const auto& c : counts )
+  {
+    if ( c.second > best )
+    {
+      code = c.first;
+      best = c.second;
+    }
+  }
+  return code;
+}
+
+/**
+ * Number of arrangements of m values of one sample and n values of the
+ * other sample (without ties) for every value u of the U statistic.
+ * The largest value either belongs to the second sample and exceeds
+ * all m values of the first sample, or to the first sample:
+ *   f(m, n, u) = f(m, n-1, u-m) + f(m-1, n, u)
+ */
+std::vector< double > u_distribution( unsigned m, unsigned n )
+{
+  /* row[j] holds f(i, j, .) for the current i */
+  std::vector< std::vector< double > > row( n + 1u, std::vector< double >( 1u, 1.0 ) );
+  for ( unsigned i = 1u; i <= m; ++i )
+  {
+    std::vector< std::vector< double > > next( n + 1u );
+    next[0u].assign( 1u, 1.0 );
+    for ( unsigned j = 1u; j <= n; ++j )
+    {
+      next[j].assign( i * j + 1u, 0.0 );
+      for ( unsigned u = 0u; u < next[j - 1u].size(); ++u )
+      {
+        next[j][u + i] += next[j - 1u][u];
+      }
+      for ( unsigned u = 0u; u < row[j].size(); ++u )
+      {
+        next[j][u] += row[j][u];
+      }
+    }
+    row.swap( next );
+  }
+  return row[n];
+}
+
+}
+
+/******************************************************************************
+ * configuration and runs                                                     *
+ ******************************************************************************/
+
+bool read_perf_config( const std::string& filename, perf_config& config )
+{
+  std::ifstream is( filename.c_str() );
+  if ( !is )
+  {
+    std::cerr << "[e] cannot open configuration " << filename << '\n';
+    return false;
+  }
+
+  std::string line;
+  unsigned number = 0u;
+  while ( std::getline( is, line ) )
+  {
+    ++number;
+    std::istringstream tokens( line );
+    std::string first;
+    if ( !( tokens >> first ) || first[0] == '#' )
+    {
+      continue;
+    }
+    if ( first != "backend" )
+    {
+      config.instances.push_back( line.substr( line.find_first_not_of( " \t" ) ) );
+      continue;
+    }
+
+    perf_backend backend;
+    std::string word;
+    tokens >> backend.name;
+    while ( tokens >> word )
+    {
+      backend.command.push_back( word );
+    }
+    if ( backend.command.empty() )
+    {
+      std::cerr << "[e] " << filename << ":" << number << ": expected backend <name> <executable> [options...]\n";
+      return false;
+    }
+    config.backends.push_back( backend );
+  }
+
+  if ( config.backends.empty() || config.instances.empty() )
+  {
+    std::cerr << "[e] " << filename << " configures no backend or no instance\n";
+    return false;
+  }
+  return true;
+}
+
+perf_sample run_perf_sample( const perf_backend& backend, const std::string& instance, unsigned timeout )
+{
+  perf_sample s;
+  s.backend = backend.name;
+  s.instance = instance;
+
+  std::vector< char* > argv;
+  for ( const auto& a : backend.command )
+  {
+    argv.push_back( const_cast< char* >( a.c_str() ) );
+  }
+  argv.push_back( const_cast< char* >( instance.c_str() ) );
+  argv.push_back( 0 );
+
+  std::cout.flush();
+  std::cerr.flush();
+
+  const auto start = clock_type::now();
+  const pid_t pid = fork();
+  if ( pid < 0 )
+  {
+    std::cerr << "[e] cannot fork: " << std::strerror( errno ) << '\n';
+    s.code = -1;
+    return s;
+  }
+
+  if ( pid == 0 )
+  {
+    const int null = open( "/dev/null", O_WRONLY );
+    if ( null >= 0 )
+    {
+      dup2( null, STDOUT_FILENO );
+      dup2( null, STDERR_FILENO );
+    }
+    execvp( argv[0u], &argv[0u] );
+    _exit( 127 );
+  }
+
+  int status = 0;
+  rusage usage;
+  std::memset( &usage, 0, sizeof( usage ) );
+  for ( ;; )
+  {
+    const pid_t r = wait4( pid, &status, ( timeout > 0u && !s.timed_out ) ? WNOHANG : 0, &usage );
+    if ( r == pid )
+    {
+      break;
+    }
+    if ( r < 0 )
+    {
+      if ( errno == EINTR )
+      {
+        continue;
+      }
+      std::cerr << "[e] cannot wait for " << argv[0u] << ": " << std::strerror( errno ) << '\n';
+      s.code = -1;
+      return s;
+    }
+    if ( seconds_since( start ) >= timeout )
+    {
+      kill( pid, SIGKILL );
+      s.timed_out = true;
+    }
+    else
+    {
+      usleep( 1000u );
+    }
+  }
+
+  s.seconds = seconds_since( start );
+  s.cpu_seconds = timeval_seconds( usage.ru_utime ) + timeval_seconds( usage.ru_stime );
+  s.code = WIFSIGNALED( status ) ? 128 + WTERMSIG( status ) : WEXITSTATUS( status );
+  return s;
+}
+
+void write_perf_csv( std::ostream& os, const std::vector< perf_sample >& samples )
+{
+  os << "backend,instance,repetition,seconds,cpu_seconds,code,timed_out\n";
+  for ( const auto& s : samples )
+  {
+    os << csv_field( s.backend ) << ',' << csv_field( s.instance ) << ',' << s.repetition << ','
+       << format_seconds( s.seconds ) << ',' << format_seconds( s.cpu_seconds ) << ',' << s.code << ','
+       << ( s.timed_out ? 1 : 0 ) << '\n';
+  }
+}
+
+bool read_perf_csv( const std::string& filename, std::vector< perf_sample >& samples )
+{
+  std::ifstream is( filename.c_str() );
+  std::string line;
+  if ( !is || !std::getline( is, line ) )
+  {
+    std::cerr << "[e] cannot read baseline " << filename << '\n';
+    return false;
+  }
+
+  unsigned number = 1u;
+  while ( std::getline( is, line ) )
+  {
+    ++number;
+    if ( line.empty() )
+    {
+      continue;
+    }
+    const std::vector< std::string > fields = split_csv_line( line );
+    if ( fields.size() != 7u )
+    {
+      std::cerr << "[e] " << filename << ":" << number << ": expected 7 fields\n";
+      return false;
+    }
+
+    perf_sample s;
+    s.backend = fields[0u];
+    s.instance = fields[1u];
+    s.repetition = std::strtoul( fields[2u].c_str(), 0, 10 );
+    s.seconds = std::strtod( fields[3u].c_str(), 0 );
+    s.cpu_seconds = std::strtod( fields[4u].c_str(), 0 );
+    s.code = std::atoi( fields[5u].c_str() );
+    s.timed_out = fields[6u] == "1";
+    samples.push_back( s );
+  }
+  return true;
+}
+
+void write_perf_json( std::ostream& os, const std::vector< perf_sample >& samples )
+{
+  const auto groups = group_samples( samples );
+  os << "[\n";
+  for ( unsigned g = 0u; g < groups.size(); ++g )
+  {
+    const std::vector< perf_sample >& group = groups[g].second;
+    std::string seconds, cpu_seconds, codes, timeouts;
+    for ( unsigned i = 0u; i < group.size(); ++i )
+    {
+      const char *sep = i == 0u ? "" : ", ";
+      seconds += sep + format_seconds( group[i].seconds );
+      cpu_seconds += sep + format_seconds( group[i].cpu_seconds );
+      codes += sep + std::to_string( group[i].code );
+      timeouts += sep + std::string( group[i].timed_out ? "true" : "false" );
+    }
+    os << "  { \"backend\": " << json_string( groups[g].first.first )
+       << ", \"instance\": " << json_string( groups[g].first.second )
+       << ", \"seconds\": [" << seconds << "], \"cpu_seconds\": [" << cpu_seconds
+       << "], \"codes\": [" << codes << "], \"timed_out\": [" << timeouts << "] }"
+       << ( g + 1u < groups.size() ? ",\n" : "\n" );
+  }
+  os << "]\n";
+}
+
+/******************************************************************************
+ * comparison                                                                 *
+ ******************************************************************************/
+
+double mann_whitney_p_value( const std::vector< double >& faster, const std::vector< double >& slower )
+{
+  const unsigned m = faster.size(), n = slower.size();
+  if ( m == 0u || n == 0u )
+  {
+    return 1.0;
+  }
+
+  /* U counts the pairs in which the value of `slower' is larger, ties count half */
+  double u = 0.0;
+  bool ties = false;
+  for ( double x : faster )
+  {
+    for ( double y : slower )
+    {
+      u += y > x ? 1.0 : ( y == x ? 0.5 : 0.0 );
+      ties = ties || y == x;
+    }
+  }
+
+  std::vector< double > all( faster );
+  all.insert( all.end(), slower.begin(), slower.end() );
+  std::sort( all.begin(), all.end() );
+  for ( unsigned i = 1u; i < all.size(); ++i )
+  {
+    ties = ties || all[i] == all[i - 1u];
+  }
+
+  if ( !ties && m <= 50u && n <= 50u )
+  {
+    const std::vector< double > f = u_distribution( m, n );
+    double tail = 0.0, total = 0.0;
+    for ( unsigned k = 0u; k < f.size(); ++k )
+    {
+      total += f[k];
+      tail += k >= u ? f[k] : 0.0;
+    }
+    return tail / total;
+  }
+
+  /* normal approximation with tie correction and continuity correction */
+  const double size = m + n;
+  double correction = 0.0;
+  for ( unsigned i = 0u; i < all.size(); )
+  {
+    unsigned j = i;
+    while ( j < all.size() && all[j] == all[i] )
+    {
+      ++j;
+    }
+    const double t = j - i;
+    correction += t * t * t - t;
+    i = j;
+  }
+  const double variance = m * n / 12.0 * ( ( size + 1.0 ) - correction / ( size * ( size - 1.0 ) ) );
+  if ( variance <= 0.0 )
+  {
+    return 1.0;
+  }
+  const double z = ( u - 0.5 * m * n - 0.5 ) / std::sqrt( variance );
+  return 0.5 * std::erfc( z / std::sqrt( 2.0 ) );
+}
+
+std::vector< perf_comparison > compare_perf( const std::vector< perf_sample >& baseline, const std::vector< perf_sample >& current,
+                                             const perf_thresholds& thresholds )
+{
+  std::map< perf_key, std::vector< perf_sample > > base;
+  for ( const auto& g : group_samples( baseline ) )
+  {
+    base.insert( g );
+  }
+
+  std::vector< perf_comparison > comparisons;
+  for ( const auto& g : group_samples( current ) )
+  {
+    perf_comparison c;
+    c.backend = g.first.first;
+    c.instance = g.first.second;
+    c.verdict = perf_comparison::unchanged;
+    c.p_value = 1.0;
+
+    std::vector< double > now;
+    for ( const auto& s : g.second )
+    {
+      now.push_back( thresholds.cpu ? s.cpu_seconds : s.seconds );
+    }
+    c.current_median = median( now );
+    c.current_code = typical_code( g.second );
+
+    const auto it = base.find( g.first );
+    if ( it == base.end() )
+    {
+      c.verdict = perf_comparison::no_baseline;
+      c.baseline_median = 0.0;
+      c.baseline_code = 0;
+      comparisons.push_back( c );
+      continue;
+    }
+
+    std::vector< double > before;
+    for ( const auto& s : it->second )
+    {
+      before.push_back( thresholds.cpu ? s.cpu_seconds : s.seconds );
+    }
+    c.baseline_median = median( before );
+    c.baseline_code = typical_code( it->second );
+
+    const double delta = c.current_median - c.baseline_median;
+    const double relative = c.baseline_median > 0.0 ? std::fabs( delta ) / c.baseline_median : std::numeric_limits< double >::infinity();
+    c.p_value = delta >= 0.0 ? mann_whitney_p_value( before, now ) : mann_whitney_p_value( now, before );
+
+    if ( c.baseline_code != c.current_code )
+    {
+      c.verdict = perf_comparison::answer_changed;
+    }
+    else if ( c.p_value < thresholds.alpha && std::fabs( delta ) > thresholds.min_delta && relative > thresholds.slowdown )
+    {
+      c.verdict = delta > 0.0 ? perf_comparison::regression : perf_comparison::improvement;
+    }
+    comparisons.push_back( c );
+  }
+  return comparisons;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
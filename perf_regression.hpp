@@ -0,0 +1,136 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file perf_regression.hpp
+ *
+ * @brief timing runs of the checkers and comparison against a baseline
+ *
+ * smt2_perf_regress runs every instance of a configuration with every
+ * configured checker command several times, one process per run, and
+ * records wall-clock and CPU seconds.  The samples of an instance are
+ * compared with the samples of a baseline run by a one-sided
+ * Mann-Whitney U test, which makes no assumption on the distribution
+ * of the timings.  A difference counts only if it is significant and
+ * exceeds both a relative and an absolute threshold.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#pragma once
+
+struct perf_backend
+{
+  std::string name;
+  std::vector< std::string > command;  /* executable and options */
+};
+
+/**
+ * Lines of the form `backend <name> <executable> [options...]'
+ * configure the checkers, every other line except comments (#) is an
+ * instance.
+ */
+struct perf_config
+{
+  std::vector< perf_backend > backends;
+  std::vector< std::string > instances;
+};
+
+bool read_perf_config( const std::string& filename, perf_config& config );
+
+struct perf_sample
+{
+  perf_sample()
+    : repetition( 0u )
+    , seconds( 0.0 )
+    , cpu_seconds( 0.0 )
+    , code( 0 )
+    , timed_out( false )
+  {}
+
+  std::string backend;
+  std::string instance;
+  unsigned repetition;
+  double seconds;       /* wall clock */
+  double cpu_seconds;   /* user and system time of the process */
+  int code;             /* exit status, 128 + signal if killed */
+  bool timed_out;
+};
+
+/**
+ * Runs the command of `backend' on `instance' with the output
+ * discarded.  A run is killed after `timeout' seconds (0 = none).
+ */
+perf_sample run_perf_sample( const perf_backend& backend, const std::string& instance, unsigned timeout );
+
+void write_perf_csv( std::ostream& os, const std::vector< perf_sample >& samples );
+bool read_perf_csv( const std::string& filename, std::vector< perf_sample >& samples );
+
+/* one object per backend and instance with the samples as arrays */
+void write_perf_json( std::ostream& os, const std::vector< perf_sample >& samples );
+
+/**
+ * p-value of the one-sided Mann-Whitney U test against the hypothesis
+ * that the values of `slower' tend to be larger than the values of
+ * `faster'.  Exact for small samples without ties, otherwise the
+ * normal approximation with tie correction is used.
+ */
+double mann_whitney_p_value( const std::vector< double >& faster, const std::vector< double >& slower );
+
+struct perf_thresholds
+{
+  perf_thresholds()
+    : alpha( 0.01 )
+    , slowdown( 0.05 )
+    , min_delta( 0.05 )
+    , cpu( false )
+  {}
+
+  double alpha;      /* significance level */
+  double slowdown;   /* minimal relative change of the medians */
+  double min_delta;  /* minimal absolute change of the medians in seconds */
+  bool cpu;          /* compare CPU instead of wall-clock seconds */
+};
+
+struct perf_comparison
+{
+  enum verdict_t { unchanged, regression, improvement, answer_changed, no_baseline };
+
+  std::string backend;
+  std::string instance;
+  verdict_t verdict;
+  double baseline_median;
+  double current_median;
+  double p_value;           /* of the test in the direction of the change */
+  int baseline_code;        /* most frequent exit status */
+  int current_code;
+};
+
+/* one comparison per backend and instance of `current', in its order */
+std::vector< perf_comparison > compare_perf( const std::vector< perf_sample >& baseline, const std::vector< perf_sample >& current,
+                                             const perf_thresholds& thresholds );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,319 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file polarity_encoding.hpp
+ *
+ * @brief polarity-aware (Plaisted-Greenbaum) encoding of the Boolean skeleton
+ *
+ * The Boolean skeleton of an instance are the and, or, not, =>, iff
+ * and Boolean ite nodes above the atoms, i.e., the bit-vector
+ * predicates, Boolean variables and constants.  metaSMT defines every
+ * gate by clauses in both directions.  Here, the polarities under
+ * which a gate occurs are propagated from the top-level assertions
+ * down, and only the implications needed for these polarities are
+ * written to the clause sink: a gate g = (and a b) that only occurs
+ * positively gets the clauses (-g a) and (-g b), but not (g -a -b).
+ * Negations become negated literals without a gate.
+ *
+ * Atoms are converted by result_type_generator, i.e., bit-blasted by
+ * metaSMT into the same clause sink.  A gate that is also read by an
+ * atom, e.g., the condition of a bit-vector ite, is converted by
+ * metaSMT as well, because the atom needs both directions.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "cnf.hpp"
+#include "decomposition.hpp"
+#include "z3_expr_visitor.hpp"
+#include "z3_utils.hpp"
+
+#include <z3++.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#pragma once
+
+struct polarity_stats
+{
+  polarity_stats()
+    : gates( 0u )
+    , clauses( 0u )
+    , full_clauses( 0u )
+  {}
+
+  unsigned gates;         /* skeleton gates with a fresh variable */
+  unsigned clauses;       /* clauses of these gates */
+  unsigned full_clauses;  /* clauses of bi-directional definitions */
+};
+
+namespace polarity
+{
+
+const uint8_t positive = 1u;
+const uint8_t negative = 2u;
+const uint8_t both = 3u;
+
+inline uint8_t flip( uint8_t p )
+{
+  return ( ( p & positive ) ? negative : 0u ) | ( ( p & negative ) ? positive : 0u );
+}
+
+/* and, or, not, =>, iff and Boolean ite */
+inline bool is_gate( const z3::expr& e )
+{
+  if ( !e.is_app() || !e.is_bool() )
+  {
+    return false;
+  }
+  switch ( e.decl().decl_kind() )
+  {
+  case Z3_OP_AND:
+  case Z3_OP_OR:
+  case Z3_OP_NOT:
+  case Z3_OP_IMPLIES:
+  case Z3_OP_IFF:
+  case Z3_OP_ITE:
+    return true;
+  case Z3_OP_EQ:
+    return e.num_args() == 2u && e.arg( 0u ).is_bool();
+  default:
+    return false;
+  }
+}
+
+}
+
+inline void print_polarity_stats( const polarity_stats& stats, unsigned total_clauses )
+{
+  std::cout << "[i] polarity: " << stats.gates << " gates, " << stats.clauses << " clauses instead of "
+            << stats.full_clauses << ", " << total_clauses << " clauses in total\n";
+}
+
+/**
+ * Adds the clauses of `instance' to `sink', the recording sink of the
+ * SAT backend of `solver' (see cnf_recording_scope).  The top-level
+ * assertions are added as unit clauses.
+ */
+template < typename Solver >
+polarity_stats assert_polarity_aware( Solver& solver, result_type_generator< Solver >& generator, const z3::expr& instance, clause_sink& sink )
+{
+  using namespace polarity;
+  using metaSMT::SAT::tag::lit_tag;
+
+  polarity_stats stats;
+  const std::vector< z3::expr > order = topological_order( instance );
+
+  /*** Gates read by atoms are converted by metaSMT ***/
+  std::unordered_set< unsigned > shared;
+  for ( const auto& e : order )
+  {
+    if ( e.is_app() && !is_gate( e ) )
+    {
+      for ( unsigned i = 0u; i < e.num_args(); ++i )
+      {
+        if ( e.arg( i ).is_bool() )
+        {
+          shared.insert( z3_expr_id( e.arg( i ) ) );
+        }
+      }
+    }
+  }
+  auto is_encoded_gate = [&]( const z3::expr& e ) {
+    return is_gate( e ) && !shared.count( z3_expr_id( e ) );
+  };
+
+  /*** Propagate polarities, parents first ***/
+  std::vector< z3::expr > assertions;
+  collect_conjuncts( instance, assertions );
+  std::unordered_map< unsigned, uint8_t > polarities;
+  for ( const auto& a : assertions )
+  {
+    polarities[z3_expr_id( a )] |= positive;
+  }
+  for ( unsigned k = order.size(); k > 0u; --k )
+  {
+    const z3::expr& e = order[k - 1u];
+    const auto it = polarities.find( z3_expr_id( e ) );
+    if ( it == polarities.end() || !is_encoded_gate( e ) )
+    {
+      continue;
+    }
+    const uint8_t p = it->second;
+    for ( unsigned i = 0u; i < e.num_args(); ++i )
+    {
+      uint8_t q = p;
+      switch ( e.decl().decl_kind() )
+      {
+      case Z3_OP_NOT:
+        q = flip( p );
+        break;
+      case Z3_OP_IMPLIES:
+        q = i == 0u ? flip( p ) : p;
+        break;
+      case Z3_OP_IFF:
+      case Z3_OP_EQ:
+        q = both;
+        break;
+      case Z3_OP_ITE:
+        q = i == 0u ? both : p;
+        break;
+      default:
+        break;
+      }
+      polarities[z3_expr_id( e.arg( i ) )] |= q;
+    }
+  }
+
+  /*** Encode, children first ***/
+  std::unordered_map< unsigned, int > literals;
+  std::vector< lit_tag > clause;
+  auto lit = [&]( const z3::expr& e ) {
+    return literals.find( z3_expr_id( e ) )->second;
+  };
+  auto add = [&]( std::initializer_list< int > lits ) {
+    clause.clear();
+    for ( const int l : lits )
+    {
+      lit_tag t = { l };
+      clause.push_back( t );
+    }
+    sink.add_clause( clause );
+    ++stats.clauses;
+  };
+
+  for ( const auto& e : order )
+  {
+    const auto it = polarities.find( z3_expr_id( e ) );
+    if ( it == polarities.end() )
+    {
+      continue;
+    }
+    const uint8_t p = it->second;
+
+    if ( !is_encoded_gate( e ) )
+    {
+      literals[z3_expr_id( e )] = bit_literals( generator( e ) ).front();
+      continue;
+    }
+
+    const Z3_decl_kind kind = e.decl().decl_kind();
+    if ( kind == Z3_OP_NOT )
+    {
+      literals[z3_expr_id( e )] = -lit( e.arg( 0u ) );
+      continue;
+    }
+
+    const int g = bit_literals( metaSMT::evaluate( solver, metaSMT::logic::new_variable() ) ).front();
+    literals[z3_expr_id( e )] = g;
+    ++stats.gates;
+
+    switch ( kind )
+    {
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+    case Z3_OP_IMPLIES:
+      {
+        /* or(a, b) is -and(-a, -b) and a => b is or(-a, b), i.e., s * g is the and of the s * args */
+        const int s = kind == Z3_OP_AND ? 1 : -1;
+        std::vector< int > args;
+        for ( unsigned i = 0u; i < e.num_args(); ++i )
+        {
+          args.push_back( s * ( kind == Z3_OP_IMPLIES && i == 0u ? -lit( e.arg( i ) ) : lit( e.arg( i ) ) ) );
+        }
+        const uint8_t q = kind == Z3_OP_AND ? p : flip( p );
+        if ( q & positive )
+        {
+          for ( const int a : args )
+          {
+            add( { -s * g, a } );
+          }
+        }
+        if ( q & negative )
+        {
+          clause.clear();
+          lit_tag t = { s * g };
+          clause.push_back( t );
+          for ( const int a : args )
+          {
+            lit_tag u = { -a };
+            clause.push_back( u );
+          }
+          sink.add_clause( clause );
+          ++stats.clauses;
+        }
+        stats.full_clauses += args.size() + 1u;
+        break;
+      }
+    case Z3_OP_IFF:
+    case Z3_OP_EQ:
+      {
+        const int a = lit( e.arg( 0u ) ), b = lit( e.arg( 1u ) );
+        if ( p & positive )
+        {
+          add( { -g, -a, b } );
+          add( { -g, a, -b } );
+        }
+        if ( p & negative )
+        {
+          add( { g, a, b } );
+          add( { g, -a, -b } );
+        }
+        stats.full_clauses += 4u;
+        break;
+      }
+    case Z3_OP_ITE:
+      {
+        const int c = lit( e.arg( 0u ) ), t = lit( e.arg( 1u ) ), f = lit( e.arg( 2u ) );
+        if ( p & positive )
+        {
+          add( { -g, -c, t } );
+          add( { -g, c, f } );
+        }
+        if ( p & negative )
+        {
+          add( { g, -c, -t } );
+          add( { g, c, -f } );
+        }
+        stats.full_clauses += 4u;
+        break;
+      }
+    default:
+      break;
+    }
+  }
+
+  for ( const auto& a : assertions )
+  {
+    lit_tag t = { lit( a ) };
+    sink.add_unit( t );
+  }
+  return stats;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,643 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preprocess.hpp"
+#include "sweeping.hpp"
+#include "width_reduction.hpp"
+#include "z3_utils.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct definition
+{
+  definition( const z3::expr& variable, const z3::expr& term, unsigned conjunct )
+    : variable( variable )
+    , term( term )
+    , conjunct( conjunct )
+    , accepted( false )
+  {}
+
+  z3::expr variable;
+  z3::expr term;
+  unsigned conjunct;
+  bool accepted;
+};
+
+/******************************************************************************
+ * constants                                                                  *
+ ******************************************************************************/
+
+bool is_bv_constant( const z3::expr& e )
+{
+  return e.is_app() && e.decl().decl_kind() == Z3_OP_BNUM;
+}
+
+bool is_bool_constant( const z3::expr& e )
+{
+  return e.is_app() && ( e.decl().decl_kind() == Z3_OP_TRUE || e.decl().decl_kind() == Z3_OP_FALSE );
+}
+
+bool is_constant( const z3::expr& e )
+{
+  return is_bv_constant( e ) || is_bool_constant( e );
+}
+
+/* true if `a' and `b' are the same constant */
+bool equal_constants( const z3::expr& a, const z3::expr& b )
+{
+  if ( is_bool_constant( a ) )
+  {
+    return a.decl().decl_kind() == b.decl().decl_kind();
+  }
+  return expr_to_bv_value( a ) == expr_to_bv_value( b );
+}
+
+/**
+ * Evaluates the bit-vector operator `e' on the constant arguments
+ * `args'.  Returns false if the operator is not folded.
+ */
+bool fold_constants( const z3::expr& e, const std::vector< z3::expr >& args, z3::expr& result )
+{
+  z3::context& ctx = e.ctx();
+  const Z3_decl_kind kind = e.decl().decl_kind();
+
+  /*** Equality on any sort of constants ***/
+  if ( kind == Z3_OP_EQ || kind == Z3_OP_IFF )
+  {
+    result = ctx.bool_val( equal_constants( args[0u], args[1u] ) );
+    return true;
+  }
+  else if ( kind == Z3_OP_DISTINCT )
+  {
+    bool distinct = true;
+    for ( unsigned i = 0u; i < args.size() && distinct; ++i )
+    {
+      for ( unsigned j = i + 1u; j < args.size() && distinct; ++j )
+      {
+        distinct = !equal_constants( args[i], args[j] );
+      }
+    }
+    result = ctx.bool_val( distinct );
+    return true;
+  }
+
+  if ( !is_bv_constant( args[0u] ) )
+  {
+    return false;
+  }
+
+  std::vector< bv_value > v;
+  v.reserve( args.size() );
+  for ( const auto& a : args )
+  {
+    v.push_back( expr_to_bv_value( a ) );
+  }
+
+  bv_value r;
+  switch ( kind )
+  {
+  case Z3_OP_BADD:
+  case Z3_OP_BMUL:
+  case Z3_OP_BAND:
+  case Z3_OP_BOR:
+  case Z3_OP_BXOR:
+  case Z3_OP_CONCAT:
+    r = v[0u];
+    for ( unsigned i = 1u; i < v.size(); ++i )
+    {
+      switch ( kind )
+      {
+      case Z3_OP_BADD:   r = bv_add( r, v[i] ); break;
+      case Z3_OP_BMUL:   r = bv_mul( r, v[i] ); break;
+      case Z3_OP_BAND:   r = bv_and( r, v[i] ); break;
+      case Z3_OP_BOR:    r = bv_or( r, v[i] ); break;
+      case Z3_OP_BXOR:   r = bv_xor( r, v[i] ); break;
+      default:           r = bv_concat( r, v[i] ); break;
+      }
+    }
+    break;
+  case Z3_OP_BSUB:   r = bv_sub( v[0u], v[1u] ); break;
+  case Z3_OP_BNEG:   r = bv_neg( v[0u] ); break;
+  case Z3_OP_BUDIV:  r = bv_udiv( v[0u], v[1u] ); break;
+  case Z3_OP_BUREM:  r = bv_urem( v[0u], v[1u] ); break;
+  case Z3_OP_BSDIV:  r = bv_sdiv( v[0u], v[1u] ); break;
+  case Z3_OP_BSREM:  r = bv_srem( v[0u], v[1u] ); break;
+  case Z3_OP_BSMOD:  r = bv_smod( v[0u], v[1u] ); break;
+  case Z3_OP_BNOT:   r = bv_not( v[0u] ); break;
+  case Z3_OP_BNAND:  r = bv_not( bv_and( v[0u], v[1u] ) ); break;
+  case Z3_OP_BNOR:   r = bv_not( bv_or( v[0u], v[1u] ) ); break;
+  case Z3_OP_BXNOR:  r = bv_not( bv_xor( v[0u], v[1u] ) ); break;
+  case Z3_OP_BCOMP:  r = bv_value( 1u, v[0u] == v[1u] ? 1u : 0u ); break;
+  case Z3_OP_BSHL:   r = bv_shl( v[0u], bv_shift_amount( v[1u] ) ); break;
+  case Z3_OP_BLSHR:  r = bv_lshr( v[0u], bv_shift_amount( v[1u] ) ); break;
+  case Z3_OP_BASHR:  r = bv_ashr( v[0u], bv_shift_amount( v[1u] ) ); break;
+
+  case Z3_OP_ROTATE_LEFT:
+  case Z3_OP_ROTATE_RIGHT:
+  case Z3_OP_EXT_ROTATE_LEFT:
+  case Z3_OP_EXT_ROTATE_RIGHT:
+    {
+      const unsigned width = v[0u].width();
+      const bool ext = kind == Z3_OP_EXT_ROTATE_LEFT || kind == Z3_OP_EXT_ROTATE_RIGHT;
+      const unsigned amount = ext ? bv_urem( v[1u], bv_value( width, width ) ).word() : decl_int_parameter( e, 0u ) % width;
+      const bool left = kind == Z3_OP_ROTATE_LEFT || kind == Z3_OP_EXT_ROTATE_LEFT;
+      r = bv_rotate_left( v[0u], left ? amount : ( width - amount ) % width );
+    }
+    break;
+
+  case Z3_OP_EXTRACT:    r = bv_extract( v[0u], hi( e ), lo( e ) ); break;
+  case Z3_OP_ZERO_EXT:   r = bv_zero_extend( v[0u], decl_int_parameter( e, 0u ) ); break;
+  case Z3_OP_SIGN_EXT:   r = bv_sign_extend( v[0u], decl_int_parameter( e, 0u ) ); break;
+  case Z3_OP_REPEAT:
+    r = v[0u];
+    for ( unsigned i = 1u; i < decl_int_parameter( e, 0u ); ++i )
+    {
+      r = bv_concat( r, v[0u] );
+    }
+    break;
+
+  case Z3_OP_ULEQ:  result = ctx.bool_val( !bv_ult( v[1u], v[0u] ) ); return true;
+  case Z3_OP_ULT:   result = ctx.bool_val( bv_ult( v[0u], v[1u] ) ); return true;
+  case Z3_OP_UGEQ:  result = ctx.bool_val( !bv_ult( v[0u], v[1u] ) ); return true;
+  case Z3_OP_UGT:   result = ctx.bool_val( bv_ult( v[1u], v[0u] ) ); return true;
+  case Z3_OP_SLEQ:  result = ctx.bool_val( !bv_slt( v[1u], v[0u] ) ); return true;
+  case Z3_OP_SLT:   result = ctx.bool_val( bv_slt( v[0u], v[1u] ) ); return true;
+  case Z3_OP_SGEQ:  result = ctx.bool_val( !bv_slt( v[0u], v[1u] ) ); return true;
+  case Z3_OP_SGT:   result = ctx.bool_val( bv_slt( v[1u], v[0u] ) ); return true;
+
+  default:
+    return false;
+  }
+
+  result = bv_value_to_expr( ctx, r );
+  return true;
+}
+
+/**
+ * Boolean operators with some constant arguments, and ITEs with a
+ * constant condition or equal branches.  Returns false if `e' is not
+ * simplified.
+ */
+bool simplify_boolean( const z3::expr& e, const std::vector< z3::expr >& args, z3::expr& result )
+{
+  z3::context& ctx = e.ctx();
+  switch ( e.decl().decl_kind() )
+  {
+  case Z3_OP_AND:
+  case Z3_OP_OR:
+    {
+      /* the absorbing constant of AND is false, the one of OR is true */
+      const Z3_decl_kind absorbing = e.decl().decl_kind() == Z3_OP_AND ? Z3_OP_FALSE : Z3_OP_TRUE;
+      std::vector< Z3_ast > rest;
+      for ( const auto& a : args )
+      {
+        if ( !is_bool_constant( a ) )
+        {
+          rest.push_back( a );
+        }
+        else if ( a.decl().decl_kind() == absorbing )
+        {
+          result = a;
+          return true;
+        }
+      }
+      if ( rest.size() == args.size() )
+      {
+        return false;
+      }
+      if ( rest.empty() )
+      {
+        result = ctx.bool_val( absorbing != Z3_OP_TRUE );
+      }
+      else if ( rest.size() == 1u )
+      {
+        result = z3::expr( ctx, rest.front() );
+      }
+      else
+      {
+        result = z3::expr( ctx, absorbing == Z3_OP_FALSE ? Z3_mk_and( ctx, rest.size(), &rest[0u] ) : Z3_mk_or( ctx, rest.size(), &rest[0u] ) );
+      }
+      return true;
+    }
+
+  case Z3_OP_NOT:
+    if ( is_bool_constant( args[0u] ) )
+    {
+      result = ctx.bool_val( args[0u].decl().decl_kind() == Z3_OP_FALSE );
+      return true;
+    }
+    return false;
+
+  case Z3_OP_IMPLIES:
+    if ( is_bool_constant( args[0u] ) )
+    {
+      result = args[0u].decl().decl_kind() == Z3_OP_TRUE ? args[1u] : ctx.bool_val( true );
+      return true;
+    }
+    else if ( is_bool_constant( args[1u] ) && args[1u].decl().decl_kind() == Z3_OP_TRUE )
+    {
+      result = args[1u];
+      return true;
+    }
+    return false;
+
+  case Z3_OP_ITE:
+    if ( is_bool_constant( args[0u] ) )
+    {
+      result = args[0u].decl().decl_kind() == Z3_OP_TRUE ? args[1u] : args[2u];
+      return true;
+    }
+    else if ( z3_expr_id( args[1u] ) == z3_expr_id( args[2u] ) )
+    {
+      result = args[1u];
+      return true;
+    }
+    return false;
+
+  case Z3_OP_EQ:
+  case Z3_OP_IFF:
+    if ( z3_expr_id( args[0u] ) == z3_expr_id( args[1u] ) )
+    {
+      result = ctx.bool_val( true );
+      return true;
+    }
+    return false;
+
+  case Z3_OP_XOR:
+    if ( args.size() == 2u && is_bool_constant( args[0u] ) && is_bool_constant( args[1u] ) )
+    {
+      result = ctx.bool_val( args[0u].decl().decl_kind() != args[1u].decl().decl_kind() );
+      return true;
+    }
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+/******************************************************************************
+ * substitution                                                               *
+ ******************************************************************************/
+
+class substitution
+{
+public:
+  substitution( const std::vector< definition >& definitions, preprocess_stats& stats )
+    : stats( stats )
+  {
+    for ( const auto& d : definitions )
+    {
+      if ( d.accepted )
+      {
+        terms.insert( std::make_pair( z3_expr_id( d.variable ), d.term ) );
+      }
+    }
+  }
+
+  /* substitutes and folds bottom-up without recursion */
+  z3::expr operator()( const z3::expr& root )
+  {
+    std::vector< std::pair< z3::expr, bool > > stack( 1u, std::make_pair( root, false ) );
+    while ( !stack.empty() )
+    {
+      const z3::expr n = stack.back().first;
+      if ( memo.find( z3_expr_id( n ) ) != memo.end() )
+      {
+        stack.pop_back();
+        continue;
+      }
+
+      if ( !stack.back().second )
+      {
+        stack.back().second = true;
+        const auto it = terms.find( z3_expr_id( n ) );
+        if ( it != terms.end() )
+        {
+          stack.push_back( std::make_pair( it->second, false ) );
+        }
+        else if ( n.is_app() )
+        {
+          for ( unsigned i = n.num_args(); i > 0u; --i )
+          {
+            stack.push_back( std::make_pair( n.arg( i - 1u ), false ) );
+          }
+        }
+        continue;
+      }
+
+      stack.pop_back();
+      memo.insert( std::make_pair( z3_expr_id( n ), rebuild( n ) ) );
+    }
+    return memo.find( z3_expr_id( root ) )->second;
+  }
+
+private:
+  const z3::expr& rewritten( const z3::expr& e ) const
+  {
+    return memo.find( z3_expr_id( e ) )->second;
+  }
+
+  z3::expr rebuild( const z3::expr& n )
+  {
+    const auto it = terms.find( z3_expr_id( n ) );
+    if ( it != terms.end() )
+    {
+      return rewritten( it->second );
+    }
+    if ( !n.is_app() || n.num_args() == 0u )
+    {
+      return n;
+    }
+
+    std::vector< z3::expr > args;
+    bool changed = false, constant = true;
+    for ( unsigned i = 0u; i < n.num_args(); ++i )
+    {
+      args.push_back( rewritten( n.arg( i ) ) );
+      changed = changed || z3_expr_id( args.back() ) != z3_expr_id( n.arg( i ) );
+      constant = constant && is_constant( args.back() );
+    }
+
+    z3::expr result = n;
+    if ( ( constant && fold_constants( n, args, result ) ) || simplify_boolean( n, args, result ) )
+    {
+      if ( is_constant( result ) )
+      {
+        ++stats.folded;
+      }
+      return result;
+    }
+    if ( !changed )
+    {
+      return n;
+    }
+
+    std::vector< Z3_ast > asts( args.begin(), args.end() );
+    return z3::expr( n.ctx(), Z3_mk_app( n.ctx(), n.decl(), asts.size(), &asts[0u] ) );
+  }
+
+  preprocess_stats& stats;
+  std::unordered_map< unsigned, z3::expr > terms;
+  std::unordered_map< unsigned, z3::expr > memo;
+};
+
+/******************************************************************************
+ * definitions                                                                *
+ ******************************************************************************/
+
+void collect_conjuncts( const z3::expr& instance, std::vector< z3::expr >& conjuncts )
+{
+  std::vector< z3::expr > stack( 1u, instance );
+  while ( !stack.empty() )
+  {
+    const z3::expr n = stack.back();
+    stack.pop_back();
+    if ( n.is_app() && n.decl().decl_kind() == Z3_OP_AND )
+    {
+      for ( unsigned i = n.num_args(); i > 0u; --i )
+      {
+        stack.push_back( n.arg( i - 1u ) );
+      }
+    }
+    else
+    {
+      conjuncts.push_back( n );
+    }
+  }
+}
+
+bool is_definable( const z3::expr& e, const std::unordered_set< unsigned >& defined )
+{
+  return is_variable( e ) && ( e.get_sort().is_bv() || e.get_sort().is_bool() ) && defined.find( z3_expr_id( e ) ) == defined.end();
+}
+
+/* matches x, (not x), (= x t) and (= t x) for a variable x not in `defined' */
+bool match_definition( const z3::expr& c, const std::unordered_set< unsigned >& defined, z3::expr& variable, z3::expr& term )
+{
+  if ( is_definable( c, defined ) )
+  {
+    variable = c;
+    term = c.ctx().bool_val( true );
+    return true;
+  }
+  if ( !c.is_app() )
+  {
+    return false;
+  }
+
+  const Z3_decl_kind kind = c.decl().decl_kind();
+  if ( kind == Z3_OP_NOT && is_definable( c.arg( 0u ), defined ) )
+  {
+    variable = c.arg( 0u );
+    term = c.ctx().bool_val( false );
+    return true;
+  }
+  else if ( ( kind == Z3_OP_EQ || kind == Z3_OP_IFF ) && c.num_args() == 2u )
+  {
+    for ( unsigned side = 0u; side < 2u; ++side )
+    {
+      if ( is_definable( c.arg( side ), defined ) && z3_expr_id( c.arg( side ) ) != z3_expr_id( c.arg( 1u - side ) ) )
+      {
+        variable = c.arg( side );
+        term = c.arg( 1u - side );
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/* the first definition of every variable in the conjuncts */
+std::vector< definition > find_definitions( const std::vector< z3::expr >& conjuncts )
+{
+  std::vector< definition > definitions;
+  std::unordered_set< unsigned > defined;
+  for ( unsigned i = 0u; i < conjuncts.size(); ++i )
+  {
+    z3::expr variable = conjuncts[i], term = conjuncts[i];
+    if ( match_definition( conjuncts[i], defined, variable, term ) )
+    {
+      definitions.push_back( definition( variable, term, i ) );
+      defined.insert( z3_expr_id( variable ) );
+    }
+  }
+  return definitions;
+}
+
+/**
+ * Accepts the definitions that do not depend on themselves, in the
+ * order of their dependencies (Kahn's algorithm).  Definitions on or
+ * behind a cycle remain in the instance as ordinary conjuncts.
+ */
+void accept_acyclic( std::vector< definition >& definitions )
+{
+  std::unordered_map< unsigned, unsigned > index;
+  for ( unsigned i = 0u; i < definitions.size(); ++i )
+  {
+    index.insert( std::make_pair( z3_expr_id( definitions[i].variable ), i ) );
+  }
+
+  std::vector< unsigned > pending( definitions.size(), 0u );
+  std::vector< std::vector< unsigned > > users( definitions.size() );
+  std::vector< unsigned > ready;
+  for ( unsigned i = 0u; i < definitions.size(); ++i )
+  {
+    for ( const auto& v : collect_variables( definitions[i].term ) )
+    {
+      const auto it = index.find( z3_expr_id( v ) );
+      if ( it != index.end() )
+      {
+        users[it->second].push_back( i );
+        ++pending[i];
+      }
+    }
+    if ( pending[i] == 0u )
+    {
+      ready.push_back( i );
+    }
+  }
+
+  while ( !ready.empty() )
+  {
+    const unsigned i = ready.back();
+    ready.pop_back();
+    definitions[i].accepted = true;
+    for ( const auto u : users[i] )
+    {
+      if ( --pending[u] == 0u )
+      {
+        ready.push_back( u );
+      }
+    }
+  }
+}
+
+}
+
+z3::expr preprocess_instance( const z3::expr& instance, preprocess_stats& stats )
+{
+  z3::context& ctx = instance.ctx();
+
+  std::vector< z3::expr > conjuncts;
+  collect_conjuncts( instance, conjuncts );
+
+  std::vector< definition > definitions = find_definitions( conjuncts );
+  accept_acyclic( definitions );
+
+  std::vector< bool > dropped( conjuncts.size(), false );
+  for ( const auto& d : definitions )
+  {
+    if ( d.accepted )
+    {
+      dropped[d.conjunct] = true;
+      ++stats.definitions;
+    }
+  }
+
+  /*** Residual formula ***/
+  substitution substitute( definitions, stats );
+  std::vector< z3::expr > residual;
+  for ( unsigned i = 0u; i < conjuncts.size(); ++i )
+  {
+    if ( dropped[i] )
+    {
+      continue;
+    }
+
+    const z3::expr c = substitute( conjuncts[i] );
+    if ( c.decl().decl_kind() == Z3_OP_FALSE )
+    {
+      return c;
+    }
+    else if ( c.decl().decl_kind() != Z3_OP_TRUE )
+    {
+      residual.push_back( c );
+    }
+  }
+
+  if ( residual.empty() )
+  {
+    return ctx.bool_val( true );
+  }
+  else if ( residual.size() == 1u )
+  {
+    return residual.front();
+  }
+  std::vector< Z3_ast > asts( residual.begin(), residual.end() );
+  return z3::expr( ctx, Z3_mk_and( ctx, asts.size(), &asts[0u] ) );
+}
+
+z3::expr preprocess_instance( const z3::expr& instance, const checker_options& options )
+{
+  z3::expr residual = instance;
+  if ( options.preprocess )
+  {
+    preprocess_stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    residual = preprocess_instance( residual, stats );
+    if ( options.stats )
+    {
+      const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "[i] preprocess: " << stats.definitions << " definitions, " << stats.folded << " folded, "
+                << elapsed.count() << " ms\n";
+    }
+  }
+
+  if ( options.sweep )
+  {
+    sweeping_stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    residual = sweep_equivalences( residual, stats );
+    if ( options.stats )
+    {
+      const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "[i] sweep:   " << stats.candidates << " candidates, " << stats.queries << " queries, "
+                << stats.merged << " merged, " << stats.refuted << " refuted by counterexamples, "
+                << stats.undecided << " undecided, " << stats.skipped << " skipped, " << elapsed.count() << " ms\n";
+    }
+  }
+
+  if ( options.reduce_widths )
+  {
+    width_reduction_stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    residual = reduce_widths( residual, stats );
+    if ( options.stats )
+    {
+      const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+      const double saved = stats.bits_before == 0u ? 0.0 : 100.0 * ( stats.bits_before - stats.bits_after ) / stats.bits_before;
+      std::cout << "[i] widths:  " << stats.bits_before << " bits reduced to " << stats.bits_after << " bits ("
+                << saved << "% fewer), " << elapsed.count() << " ms\n";
+    }
+  }
+  return residual;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
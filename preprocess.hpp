@@ -0,0 +1,67 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file preprocess.hpp
+ *
+ * @brief variable substitution and constant folding before conversion
+ *
+ * Top-level conjuncts (= x t), (= t x), p and (not p) define the
+ * variable x or p.  The first definition of every variable is
+ * substituted through the instance unless it depends on itself, also
+ * through other definitions, and the defining conjunct is dropped.
+ * Operators whose arguments all become constant are folded with
+ * bv_value, Boolean operators also with some constant arguments.
+ * The result is equisatisfiable to the instance, but the models of
+ * the substituted variables are lost.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "checker_options.hpp"
+
+#include <z3++.h>
+
+#pragma once
+
+struct preprocess_stats
+{
+  preprocess_stats()
+    : definitions( 0u )
+    , folded( 0u )
+  {}
+
+  unsigned definitions;  /* substituted variables */
+  unsigned folded;       /* operators replaced by a constant */
+};
+
+z3::expr preprocess_instance( const z3::expr& instance, preprocess_stats& stats );
+
+/**
+ * Applies the passes enabled in `options', i.e., preprocess_instance
+ * with options.preprocess and reduce_widths with
+ * options.reduce_widths.  The statistics are printed with
+ * options.stats.
+ */
+z3::expr preprocess_instance( const z3::expr& instance, const checker_options& options );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -24,37 +24,289 @@
  * @since  1.0
  */
 
+#include "batch_pipeline.hpp"
+#include "batch_runner.hpp"
+#include "checker_options.hpp"
+#include "component_solving.hpp"
+#include "context_pool.hpp"
+#include "cube_and_conquer.hpp"
+#include "dimacs_export.hpp"
+#include "memory_utils.hpp"
+#include "perf_counters.hpp"
+#include "preprocess.hpp"
+#include "simulation.hpp"
+#include "smt2_parser.hpp"
+#include "snapshot.hpp"
+#include "snapshot_converter.hpp"
 #include "z3_expr_visitor.hpp"
 
+#include <chrono>
+#include <memory>
+
 #pragma once
 
+/**
+ * Converts `instance' and prints the conversion statistics if
+ * `print_stats' is set.
+ */
 template < typename Solver >
-int metaSMT_satisfiability_checker_main( int argc, char *argv[] )
+typename Solver::result_type convert_instance( result_type_generator< Solver >& generator, const z3::expr& instance, bool print_stats )
 {
-  if ( argc != 2 )
+  const std::size_t allocations = allocation_count();
+  const auto start = std::chrono::steady_clock::now();
+  typename Solver::result_type r = generator( instance );
+
+  if ( print_stats )
   {
-    std::cerr << "Usage: " << argv[0] << " <filename>\n";
-    return -1;
+    const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+    const conversion_stats& stats = generator.statistics();
+    std::cout << "[i] convert: " << stats.nodes << " nodes, " << stats.memo_hits << " memo hits, "
+              << stats.ite_chains << " ite chains, " << ( allocation_count() - allocations ) << " allocations, "
+              << elapsed.count() << " ms\n";
   }
+  return r;
+}
 
-  const std::string filename = argv[1];
-  // std::cout << "Read SMT-LIB2 benchmark file ''" << filename << "''\n";
+template < typename Solver >
+void print_refinement_stats( const result_type_generator< Solver >& generator, bool print_stats )
+{
+  const nonlinear_abstraction< Solver >& nonlinear = generator.nonlinear_operators();
+  if ( print_stats && !nonlinear.empty() )
+  {
+    std::cout << "[i] cegar:   " << nonlinear.refined() << " of " << nonlinear.abstracted() << " nonlinear operators refined\n";
+  }
+}
+
+/**
+ * Solves the converted root `r'.  With a reused context the root is an
+ * assumption, which only holds for one solve and is added again after
+ * every refinement.  Otherwise the assertion ends a phase of
+ * `counters'.
+ */
+template < typename Solver >
+bool solve_root( Solver& solver_ctx, result_type_generator< Solver >& generator, const typename Solver::result_type& r, bool reused,
+                 counter_phase_report& counters )
+{
+  if ( !reused )
+  {
+    metaSMT::assertion( solver_ctx, r );
+    counters.phase( "assert" );
+    return solve_with_refinement( solver_ctx, generator );
+  }
+
+  for ( ;; )
+  {
+    metaSMT::assumption( solver_ctx, r );
+    if ( !metaSMT::solve( solver_ctx ) )
+    {
+      return false;
+    }
+    if ( !generator.refine() )
+    {
+      return true;
+    }
+  }
+}
+
+/**
+ * Checks the satisfiability of a parsed instance with the modes
+ * selected in `options`.  The conversion, assertion and solving end
+ * phases of `counters`; modes that convert and solve interleaved only
+ * end the solve phase.
+ */
+template < typename Solver >
+bool metaSMT_check_satisfiability( const z3::expr& instance, const checker_options& options, counter_phase_report& counters )
+{
+  bool sat;
+  if ( options.decompose )
+  {
+    /*** Convert and solve each component separately ***/
+    sat = solve_by_components< Solver >( instance, checker_threads( options ) );
+  }
+  else if ( options.cube_and_conquer )
+  {
+    /*** Bit-blast once and solve the cubes in parallel ***/
+    sat = solve_by_cubes< Solver >( instance, checker_threads( options ), options.cube_depth, options.polarity );
+  }
+  else if ( options.polarity )
+  {
+    /*** Bit-blast with the polarity-aware skeleton ***/
+    sat = solve_polarity_aware< Solver >( instance, options.stats );
+  }
+  else
+  {
+    /*** Convert to metaSMT result_type ***/
+    std::unique_ptr< Solver > fresh( options.reuse > 0u ? 0 : new Solver );
+    Solver& solver_ctx = fresh ? *fresh : context_pool< Solver >::acquire( options.reuse, options.stats );
+    result_type_generator< Solver > generator( solver_ctx );
+    generator.abstract_nonlinear( options.cegar );
+    typename Solver::result_type r = convert_instance( generator, instance, options.stats );
+    counters.phase( "convert" );
 
-  /*** Parse SMT-LIB2 instance ***/
-  z3::context ctx;
-  const Z3_ast ast = Z3_parse_smtlib2_file( ctx, filename.c_str(), 0, 0, 0, 0, 0, 0 );
+    /*** Check satisfiability utilizing metaSMT ***/
+    sat = solve_root( solver_ctx, generator, r, options.reuse > 0u, counters );
+    print_refinement_stats( generator, options.stats );
+  }
+  counters.phase( "solve" );
+  return sat;
+}
 
-  /*** Convert to metaSMT result_type ***/
+template < typename Solver >
+bool metaSMT_check_satisfiability( const z3::expr& instance, const checker_options& options )
+{
+  counter_phase_report counters( false, "" );
+  return metaSMT_check_satisfiability< Solver >( instance, options, counters );
+}
+
+/**
+ * Same as the default path of metaSMT_check_satisfiability, but the
+ * memo table of the generator, the Z3 AST and the Z3 context are all
+ * destroyed before the solver runs.  Only the solver context and the
+ * converted root survive the conversion.  `simulated' is set if
+ * --simulate found a model.
+ */
+template < typename Solver >
+bool metaSMT_check_satisfiability_low_memory( const checker_options& options, memory_phase_report& report, bool& simulated )
+{
   Solver solver_ctx;
-  result_type_generator< Solver > generator( solver_ctx );
-  const z3::expr instance( ctx, ast );
-  typename Solver::result_type r = generator( instance );
+  typename Solver::result_type r;
+  {
+    /*** Parse SMT-LIB2 instance or snapshot ***/
+    z3::context ctx;
+    const z3::expr loaded = load_instance( ctx, options.filename );
+    report.phase( "parse" );
+    if ( options.simulate > 0u && find_model_by_simulation( loaded, options ) )
+    {
+      simulated = true;
+      return true;
+    }
+    const z3::expr instance = preprocess_instance( loaded, options );
+
+    /*** Convert to metaSMT result_type ***/
+    {
+      result_type_generator< Solver > generator( solver_ctx );
+      generator.abstract_nonlinear( options.cegar );
+      r = convert_instance( generator, instance, options.stats );
+      if ( generator.needs_refinement() )
+      {
+        /* lemmas are derived from the Z3 terms, nothing can be released */
+        report.phase( "convert" );
+        metaSMT::assertion( solver_ctx, r );
+        const bool sat = solve_with_refinement( solver_ctx, generator );
+        report.phase( "solve" );
+        print_refinement_stats( generator, options.stats );
+        return sat;
+      }
+    }
+    report.phase( "convert" );
+  }
+  release_free_memory();
+  report.phase( "release" );
 
   /*** Check satisfiability utilizing metaSMT ***/
   metaSMT::assertion( solver_ctx, r );
-  const bool metaSMT_sat = metaSMT::solve( solver_ctx );
+  const bool sat = metaSMT::solve( solver_ctx );
+  report.phase( "solve" );
+  return sat;
+}
+
+/**
+ * Checks options.filename, returns 1 if it is satisfiable,
+ * sat_by_simulation if --simulate found a model, 0 if it is
+ * unsatisfiable and -1 on errors.
+ */
+template < typename Solver >
+int metaSMT_check_file( const checker_options& options )
+{
+  const std::string filename = options.filename;
+  // std::cout << "Read SMT-LIB2 benchmark file ''" << filename << "''\n";
+
+  bool metaSMT_sat;
+  bool simulated = false;
+  const bool needs_z3 = options.decompose || options.cube_and_conquer || !options.export_dimacs.empty() || options.polarity;
+  memory_phase_report report( options.low_memory );
+  counter_phase_report counters( options.counters, options.batch ? filename : "" );
+
+  const bool rewrites = options.preprocess || options.reduce_widths || options.simulate > 0u || options.sweep;
+  /* the abstraction and the statistics are part of result_type_generator */
+  const bool needs_generator = options.cegar || options.stats;
+  if ( !needs_z3 && !rewrites && !needs_generator && is_snapshot_file( filename ) )
+  {
+    /*** Convert the snapshot without building a Z3 AST ***/
+    std::unique_ptr< Solver > fresh( options.reuse > 0u ? 0 : new Solver );
+    Solver& solver_ctx = fresh ? *fresh : context_pool< Solver >::acquire( options.reuse, options.stats );
+    typename Solver::result_type r = convert_snapshot( solver_ctx, filename );
+    report.phase( "convert" );
+    counters.phase( "convert" );
+    if ( options.reuse > 0u )
+    {
+      metaSMT::assumption( solver_ctx, r );
+    }
+    else
+    {
+      metaSMT::assertion( solver_ctx, r );
+      counters.phase( "assert" );
+    }
+    metaSMT_sat = metaSMT::solve( solver_ctx );
+    report.phase( "solve" );
+    counters.phase( "solve" );
+  }
+  else if ( options.native_parser )
+  {
+    /*** Stream the assertions into metaSMT without building a Z3 AST ***/
+    Solver solver_ctx;
+    if ( !parse_smt2_qfbv( solver_ctx, filename ) )
+    {
+      return -1;
+    }
+    report.phase( "parse" );
+    counters.phase( "parse" );
+    metaSMT_sat = metaSMT::solve( solver_ctx );
+    report.phase( "solve" );
+    counters.phase( "solve" );
+  }
+  else if ( options.low_memory )
+  {
+    metaSMT_sat = metaSMT_check_satisfiability_low_memory< Solver >( options, report, simulated );
+  }
+  else
+  {
+    /*** Parse SMT-LIB2 instance or snapshot ***/
+    z3::context ctx;
+    const z3::expr loaded = load_instance( ctx, filename );
+    counters.phase( "parse" );
+
+    /*** Try random assignments before the conversion ***/
+    if ( options.simulate > 0u && find_model_by_simulation( loaded, options ) )
+    {
+      return sat_by_simulation;
+    }
+    const z3::expr instance = preprocess_instance( loaded, options );
+    if ( rewrites )
+    {
+      counters.phase( "preprocess" );
+    }
+
+    if ( ( options.cube_and_conquer || !options.export_dimacs.empty() || options.polarity ) && contains_arrays( instance ) )
+    {
+      std::cerr << "[e] --cube-and-conquer, --export-dimacs and --polarity do not support arrays\n";
+      return -1;
+    }
+
+    if ( !options.export_dimacs.empty() )
+    {
+      /*** Export the bit-blasted instance ***/
+      return export_dimacs( instance, options.export_dimacs, options.polarity ) ? 0 : -1;
+    }
 
-  if ( metaSMT_sat )
+    metaSMT_sat = metaSMT_check_satisfiability< Solver >( instance, options, counters );
+  }
+
+  if ( simulated )
+  {
+    return sat_by_simulation;
+  }
+  else if ( metaSMT_sat )
   {
     return 1;
   }
@@ -67,6 +319,125 @@ int metaSMT_satisfiability_checker_main( int argc, char *argv[] )
   return -1;
 }
 
+inline const char *describe_satisfiability( int code )
+{
+  return code == 1 ? "SAT" : ( code == sat_by_simulation ? "SAT (simulation)" : ( code == 0 ? "UNSAT" : "error" ) );
+}
+
+template < typename Solver >
+int metaSMT_satisfiability_checker_main( int argc, char *argv[] )
+{
+  checker_options options;
+  if ( !parse_checker_options( argc, argv, options ) )
+  {
+    print_checker_usage( argv[0] );
+    return -1;
+  }
+
+  if ( options.cube_and_conquer && !sat_backend< Solver >::value )
+  {
+    std::cerr << "[e] --cube-and-conquer requires a SAT-based backend\n";
+    return -1;
+  }
+
+  const bool needs_z3 = options.decompose || options.cube_and_conquer || !options.export_dimacs.empty();
+  if ( options.native_parser && needs_z3 )
+  {
+    std::cerr << "[e] --native-parser cannot be combined with --decompose, --cube-and-conquer or --export-dimacs\n";
+    return -1;
+  }
+  if ( options.low_memory && needs_z3 )
+  {
+    std::cerr << "[e] --low-memory cannot be combined with --decompose, --cube-and-conquer or --export-dimacs\n";
+    return -1;
+  }
+  if ( options.cegar && ( needs_z3 || options.native_parser ) )
+  {
+    std::cerr << "[e] --cegar cannot be combined with --decompose, --cube-and-conquer, --export-dimacs or --native-parser\n";
+    return -1;
+  }
+  if ( options.preprocess && ( !options.export_dimacs.empty() || options.native_parser ) )
+  {
+    /* substituted variables would be missing in the DIMACS map */
+    std::cerr << "[e] --preprocess cannot be combined with --export-dimacs or --native-parser\n";
+    return -1;
+  }
+  if ( options.reduce_widths && options.native_parser )
+  {
+    std::cerr << "[e] --reduce-widths cannot be combined with --native-parser\n";
+    return -1;
+  }
+  if ( options.sweep && ( !options.export_dimacs.empty() || options.native_parser ) )
+  {
+    /* variables may vanish from the DIMACS map as with --preprocess */
+    std::cerr << "[e] --sweep cannot be combined with --export-dimacs or --native-parser\n";
+    return -1;
+  }
+  if ( options.simulate > 0u && ( !options.export_dimacs.empty() || options.native_parser ) )
+  {
+    std::cerr << "[e] --simulate cannot be combined with --export-dimacs or --native-parser\n";
+    return -1;
+  }
+
+  if ( options.pipeline && ( !options.batch || needs_z3 || options.native_parser || options.low_memory || options.timeout > 0u ) )
+  {
+    std::cerr << "[e] --pipeline requires --batch and cannot be combined with --decompose, --cube-and-conquer, --export-dimacs, --native-parser, --low-memory or --timeout\n";
+    return -1;
+  }
+
+  if ( options.polarity && !sat_backend< Solver >::value )
+  {
+    std::cerr << "[e] --polarity requires a SAT-based backend\n";
+    return -1;
+  }
+  if ( options.polarity && ( options.decompose || options.native_parser || options.low_memory || options.cegar || options.pipeline || options.reuse > 0u ) )
+  {
+    /* the skeleton is encoded on the recorded CNF, which is not refined */
+    std::cerr << "[e] --polarity cannot be combined with --decompose, --native-parser, --low-memory, --cegar, --pipeline or --reuse\n";
+    return -1;
+  }
+
+  if ( options.counters && ( options.low_memory || options.pipeline ) )
+  {
+    std::cerr << "[e] --counters cannot be combined with --low-memory or --pipeline\n";
+    return -1;
+  }
+
+  if ( !options.minimize.empty() )
+  {
+    std::cerr << "[e] --minimize is only supported by the consistency checkers\n";
+    return -1;
+  }
+
+  if ( options.reuse > 0u && ( needs_z3 || options.native_parser || options.low_memory || options.pipeline ) )
+  {
+    std::cerr << "[e] --reuse cannot be combined with --decompose, --cube-and-conquer, --export-dimacs, --native-parser, --low-memory or --pipeline\n";
+    return -1;
+  }
+
+  if ( options.batch )
+  {
+    if ( !options.export_dimacs.empty() )
+    {
+      std::cerr << "[e] --batch cannot be combined with --export-dimacs\n";
+      return -1;
+    }
+
+    if ( options.pipeline )
+    {
+      /*** Parse, convert and solve in overlapping stages ***/
+      return run_pipeline< Solver >( options, &describe_satisfiability );
+    }
+
+    /*** Check every listed instance in a worker process ***/
+    return run_batch( options, &metaSMT_check_file< Solver >, options.reuse > 0u ? &prepare_pooled_context< Solver > : &warm_up_backend< Solver >,
+                      &describe_satisfiability );
+  }
+
+  const int code = metaSMT_check_file< Solver >( options );
+  return code == sat_by_simulation ? 1 : code;
+}
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)
@@ -0,0 +1,587 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "simulation.hpp"
+#include "z3_utils.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+
+/******************************************************************************
+ * bit-sliced operators                                                       *
+ ******************************************************************************/
+
+lane_rows rows_constant( const bv_value& v )
+{
+  lane_rows r;
+  for ( unsigned i = 0u; i < v.width(); ++i )
+  {
+    r.push_back( lanes_constant( v.bit( i ) ) );
+  }
+  return r;
+}
+
+lane_rows add_rows( const lane_rows& a, const lane_rows& b, lane_block carry )
+{
+  lane_rows r( a.size() );
+  for ( unsigned i = 0u; i < a.size(); ++i )
+  {
+    const lane_block x = a[i] ^ b[i];
+    r[i] = x ^ carry;
+    carry = ( a[i] & b[i] ) | ( carry & x );
+  }
+  return r;
+}
+
+lane_rows not_rows( const lane_rows& a )
+{
+  lane_rows r( a.size() );
+  for ( unsigned i = 0u; i < a.size(); ++i )
+  {
+    r[i] = ~a[i];
+  }
+  return r;
+}
+
+lane_rows sub_rows( const lane_rows& a, const lane_rows& b )
+{
+  return add_rows( a, not_rows( b ), lanes_constant( true ) );
+}
+
+lane_rows neg_rows( const lane_rows& a )
+{
+  return sub_rows( lane_rows( a.size(), lanes_constant( false ) ), a );
+}
+
+lane_rows mux_rows( const lane_block& c, const lane_rows& t, const lane_rows& e )
+{
+  lane_rows r( t.size() );
+  for ( unsigned i = 0u; i < t.size(); ++i )
+  {
+    r[i] = ( c & t[i] ) | ( ~c & e[i] );
+  }
+  return r;
+}
+
+/* a < b, the borrow of a - b */
+lane_block ult_rows( const lane_rows& a, const lane_rows& b )
+{
+  lane_block borrow = lanes_constant( false );
+  for ( unsigned i = 0u; i < a.size(); ++i )
+  {
+    borrow = ( ~a[i] & b[i] ) | ( ~( a[i] ^ b[i] ) & borrow );
+  }
+  return borrow;
+}
+
+lane_block slt_rows( const lane_rows& a, const lane_rows& b )
+{
+  const lane_block sa = a.back(), sb = b.back();
+  return ( sa & ~sb ) | ( ~( sa ^ sb ) & ult_rows( a, b ) );
+}
+
+lane_block eq_rows( const lane_rows& a, const lane_rows& b )
+{
+  lane_block diff = lanes_constant( false );
+  for ( unsigned i = 0u; i < a.size(); ++i )
+  {
+    diff = diff | ( a[i] ^ b[i] );
+  }
+  return ~diff;
+}
+
+lane_rows mul_rows( const lane_rows& a, const lane_rows& b )
+{
+  const lane_block zero = lanes_constant( false );
+  lane_rows r( a.size(), zero );
+  for ( unsigned i = 0u; i < b.size(); ++i )
+  {
+    lane_rows partial( a.size(), zero );
+    for ( unsigned j = i; j < a.size(); ++j )
+    {
+      partial[j] = a[j - i] & b[i];
+    }
+    r = add_rows( r, partial, zero );
+  }
+  return r;
+}
+
+/* restoring division, a / 0 is all ones and a % 0 is a */
+void udivrem_rows( const lane_rows& a, const lane_rows& b, lane_rows& quotient, lane_rows& remainder )
+{
+  const unsigned w = a.size();
+  const lane_block zero = lanes_constant( false );
+  lane_rows divisor = b;
+  divisor.push_back( zero );
+  lane_rows r( w + 1u, zero );
+  quotient.assign( w, zero );
+  for ( unsigned i = w; i > 0u; --i )
+  {
+    for ( unsigned j = w; j > 0u; --j )
+    {
+      r[j] = r[j - 1u];
+    }
+    r[0u] = a[i - 1u];
+    const lane_block ge = ~ult_rows( r, divisor );
+    r = mux_rows( ge, sub_rows( r, divisor ), r );
+    quotient[i - 1u] = ge;
+  }
+  r.pop_back();
+  remainder.swap( r );
+}
+
+lane_rows abs_rows( const lane_rows& a )
+{
+  return mux_rows( a.back(), neg_rows( a ), a );
+}
+
+/* shl, lshr and ashr by the amount in `amount' */
+lane_rows shift_rows( const lane_rows& a, const lane_rows& amount, Z3_decl_kind kind )
+{
+  const unsigned w = a.size();
+  const lane_block fill = kind == Z3_OP_BASHR ? a.back() : lanes_constant( false );
+  lane_rows r = a;
+  for ( unsigned j = 0u; j < amount.size() && ( 1u << j ) < w; ++j )
+  {
+    const unsigned k = 1u << j;
+    lane_rows s( w, fill );
+    for ( unsigned i = 0u; i < w; ++i )
+    {
+      if ( kind == Z3_OP_BSHL )
+      {
+        s[i] = i >= k ? r[i - k] : lanes_constant( false );
+      }
+      else if ( i + k < w )
+      {
+        s[i] = r[i + k];
+      }
+    }
+    r = mux_rows( amount[j], s, r );
+  }
+
+  /* amounts of at least the width shift out everything */
+  const lane_block over = ~ult_rows( amount, rows_constant( bv_value( amount.size(), w ) ) );
+  return mux_rows( over, lane_rows( w, kind == Z3_OP_BSHL ? lanes_constant( false ) : fill ), r );
+}
+
+lane_rows rotate_rows( const lane_rows& a, unsigned k, bool left )
+{
+  const unsigned w = a.size();
+  k %= w;
+  lane_rows r( w );
+  for ( unsigned i = 0u; i < w; ++i )
+  {
+    r[left ? ( i + k ) % w : i] = a[left ? i : ( i + k ) % w];
+  }
+  return r;
+}
+
+}
+
+/******************************************************************************
+ * bit_simulator                                                              *
+ ******************************************************************************/
+
+bit_simulator::bit_simulator( const z3::expr& root )
+  : order( topological_order( root ) )
+  , values( order.size() )
+  , users( order.size(), 0u )
+  , is_supported( true )
+{
+  for ( unsigned k = 0u; k < order.size(); ++k )
+  {
+    const z3::expr& n = order[k];
+    index.insert( std::make_pair( z3_expr_id( n ), k ) );
+
+    if ( !n.is_app() || !( n.get_sort().is_bv() || n.get_sort().is_bool() ) )
+    {
+      is_supported = false;
+      continue;
+    }
+    if ( is_variable( n ) )
+    {
+      inputs.push_back( n );
+      continue;
+    }
+
+    switch ( n.decl().decl_kind() )
+    {
+    case Z3_OP_UNINTERPRETED:
+    case Z3_OP_SELECT:
+    case Z3_OP_STORE:
+    case Z3_OP_BSDIV0:
+    case Z3_OP_BUDIV0:
+    case Z3_OP_BSREM0:
+    case Z3_OP_BUREM0:
+    case Z3_OP_BSMOD0:
+      is_supported = false;
+      break;
+    default:
+      break;
+    }
+
+    for ( unsigned i = 0u; i < n.num_args(); ++i )
+    {
+      ++users[index.find( z3_expr_id( n.arg( i ) ) )->second];
+    }
+  }
+}
+
+void bit_simulator::assign_random( std::mt19937_64& rng, unsigned round )
+{
+  /* lane 0 all zeros, lane 1 all ones, lanes 2 to 15 small values */
+  const uint64_t zeros = 0x1u, ones = 0x2u, small = 0xfffcu;
+  for ( const auto& v : inputs )
+  {
+    const unsigned w = v.get_sort().is_bv() ? v.get_sort().bv_size() : 1u;
+    lane_rows& rows = values[index.find( z3_expr_id( v ) )->second];
+    rows.resize( w );
+    for ( unsigned i = 0u; i < w; ++i )
+    {
+      for ( unsigned j = 0u; j < simulation_words; ++j )
+      {
+        rows[i].words[j] = rng();
+      }
+      if ( round == 0u )
+      {
+        rows[i].words[0u] = ( rows[i].words[0u] & ~zeros ) | ones;
+        if ( i >= 2u )
+        {
+          rows[i].words[0u] &= ~small;
+        }
+      }
+    }
+  }
+}
+
+void bit_simulator::run( bool keep )
+{
+  assert( is_supported );
+  std::vector< unsigned > pending = users;
+  for ( unsigned k = 0u; k < order.size(); ++k )
+  {
+    const z3::expr& n = order[k];
+    if ( is_variable( n ) )
+    {
+      continue;
+    }
+    values[k] = evaluate( n );
+
+    if ( keep )
+    {
+      continue;
+    }
+    for ( unsigned i = 0u; i < n.num_args(); ++i )
+    {
+      const unsigned j = index.find( z3_expr_id( n.arg( i ) ) )->second;
+      if ( --pending[j] == 0u && !is_variable( order[j] ) )
+      {
+        lane_rows().swap( values[j] );
+      }
+    }
+  }
+}
+
+const lane_rows& bit_simulator::value( const z3::expr& e ) const
+{
+  return values[index.find( z3_expr_id( e ) )->second];
+}
+
+std::string bit_simulator::lane_value( const z3::expr& e, unsigned i ) const
+{
+  const lane_rows& rows = value( e );
+  if ( e.get_sort().is_bool() )
+  {
+    return lane( rows.front(), i ) ? "true" : "false";
+  }
+
+  std::string bits( "#b" );
+  for ( unsigned b = rows.size(); b > 0u; --b )
+  {
+    bits += lane( rows[b - 1u], i ) ? '1' : '0';
+  }
+  return bits;
+}
+
+lane_rows bit_simulator::evaluate( const z3::expr& e ) const
+{
+  std::vector< const lane_rows* > args;
+  for ( unsigned i = 0u; i < e.num_args(); ++i )
+  {
+    args.push_back( &value( e.arg( i ) ) );
+  }
+
+  const lane_block zero = lanes_constant( false );
+  const Z3_decl_kind kind = e.decl().decl_kind();
+  switch ( kind )
+  {
+  /*** Constants ***/
+  case Z3_OP_TRUE:
+  case Z3_OP_FALSE:
+    return lane_rows( 1u, lanes_constant( kind == Z3_OP_TRUE ) );
+  case Z3_OP_BNUM:
+    return rows_constant( expr_to_bv_value( e ) );
+
+  /*** Boolean ***/
+  case Z3_OP_AND:
+  case Z3_OP_OR:
+  case Z3_OP_XOR:
+    {
+      lane_block r = ( *args[0u] )[0u];
+      for ( unsigned i = 1u; i < args.size(); ++i )
+      {
+        const lane_block& b = ( *args[i] )[0u];
+        r = kind == Z3_OP_AND ? r & b : ( kind == Z3_OP_OR ? r | b : r ^ b );
+      }
+      return lane_rows( 1u, r );
+    }
+  case Z3_OP_NOT:
+    return lane_rows( 1u, ~( *args[0u] )[0u] );
+  case Z3_OP_IMPLIES:
+    return lane_rows( 1u, ~( *args[0u] )[0u] | ( *args[1u] )[0u] );
+  case Z3_OP_IFF:
+  case Z3_OP_EQ:
+    return lane_rows( 1u, eq_rows( *args[0u], *args[1u] ) );
+  case Z3_OP_DISTINCT:
+    {
+      lane_block r = lanes_constant( true );
+      for ( unsigned i = 0u; i < args.size(); ++i )
+      {
+        for ( unsigned j = i + 1u; j < args.size(); ++j )
+        {
+          r = r & ~eq_rows( *args[i], *args[j] );
+        }
+      }
+      return lane_rows( 1u, r );
+    }
+  case Z3_OP_ITE:
+    return mux_rows( ( *args[0u] )[0u], *args[1u], *args[2u] );
+
+  /*** Comparisons ***/
+  case Z3_OP_ULT:   return lane_rows( 1u, ult_rows( *args[0u], *args[1u] ) );
+  case Z3_OP_UGT:   return lane_rows( 1u, ult_rows( *args[1u], *args[0u] ) );
+  case Z3_OP_ULEQ:  return lane_rows( 1u, ~ult_rows( *args[1u], *args[0u] ) );
+  case Z3_OP_UGEQ:  return lane_rows( 1u, ~ult_rows( *args[0u], *args[1u] ) );
+  case Z3_OP_SLT:   return lane_rows( 1u, slt_rows( *args[0u], *args[1u] ) );
+  case Z3_OP_SGT:   return lane_rows( 1u, slt_rows( *args[1u], *args[0u] ) );
+  case Z3_OP_SLEQ:  return lane_rows( 1u, ~slt_rows( *args[1u], *args[0u] ) );
+  case Z3_OP_SGEQ:  return lane_rows( 1u, ~slt_rows( *args[0u], *args[1u] ) );
+
+  /*** Bitwise ***/
+  case Z3_OP_BAND:
+  case Z3_OP_BOR:
+  case Z3_OP_BXOR:
+  case Z3_OP_BNAND:
+  case Z3_OP_BNOR:
+  case Z3_OP_BXNOR:
+    {
+      lane_rows r = *args[0u];
+      for ( unsigned i = 1u; i < args.size(); ++i )
+      {
+        for ( unsigned b = 0u; b < r.size(); ++b )
+        {
+          const lane_block& y = ( *args[i] )[b];
+          switch ( kind )
+          {
+          case Z3_OP_BAND: case Z3_OP_BNAND:  r[b] = r[b] & y; break;
+          case Z3_OP_BOR:  case Z3_OP_BNOR:   r[b] = r[b] | y; break;
+          default:                            r[b] = r[b] ^ y; break;
+          }
+        }
+      }
+      return kind == Z3_OP_BNAND || kind == Z3_OP_BNOR || kind == Z3_OP_BXNOR ? not_rows( r ) : r;
+    }
+  case Z3_OP_BNOT:
+    return not_rows( *args[0u] );
+  case Z3_OP_BCOMP:
+    return lane_rows( 1u, eq_rows( *args[0u], *args[1u] ) );
+  case Z3_OP_BREDAND:
+  case Z3_OP_BREDOR:
+    {
+      lane_block r = ( *args[0u] )[0u];
+      for ( const auto& b : *args[0u] )
+      {
+        r = kind == Z3_OP_BREDAND ? r & b : r | b;
+      }
+      return lane_rows( 1u, r );
+    }
+
+  /*** Arithmetic ***/
+  case Z3_OP_BADD:
+  case Z3_OP_BMUL:
+    {
+      lane_rows r = *args[0u];
+      for ( unsigned i = 1u; i < args.size(); ++i )
+      {
+        r = kind == Z3_OP_BADD ? add_rows( r, *args[i], zero ) : mul_rows( r, *args[i] );
+      }
+      return r;
+    }
+  case Z3_OP_BSUB:
+    return sub_rows( *args[0u], *args[1u] );
+  case Z3_OP_BNEG:
+    return neg_rows( *args[0u] );
+  case Z3_OP_BUDIV:
+  case Z3_OP_BUREM:
+    {
+      lane_rows q, r;
+      udivrem_rows( *args[0u], *args[1u], q, r );
+      return kind == Z3_OP_BUDIV ? q : r;
+    }
+  case Z3_OP_BSDIV:
+  case Z3_OP_BSREM:
+  case Z3_OP_BSMOD:
+    {
+      const lane_rows& a = *args[0u];
+      const lane_rows& b = *args[1u];
+      lane_rows q, r;
+      udivrem_rows( abs_rows( a ), abs_rows( b ), q, r );
+      if ( kind == Z3_OP_BSDIV )
+      {
+        return mux_rows( a.back() ^ b.back(), neg_rows( q ), q );
+      }
+      else if ( kind == Z3_OP_BSREM )
+      {
+        return mux_rows( a.back(), neg_rows( r ), r );
+      }
+
+      /* smod takes the sign of the divisor */
+      const lane_block r_zero = eq_rows( r, lane_rows( r.size(), zero ) );
+      const lane_rows r_neg = neg_rows( r );
+      lane_rows m = mux_rows( a.back(), mux_rows( b.back(), r_neg, add_rows( r_neg, b, zero ) ),
+                              mux_rows( b.back(), add_rows( r, b, zero ), r ) );
+      return mux_rows( r_zero, r, m );
+    }
+
+  /*** Shifts and rotations ***/
+  case Z3_OP_BSHL:
+  case Z3_OP_BLSHR:
+  case Z3_OP_BASHR:
+    return shift_rows( *args[0u], *args[1u], kind );
+  case Z3_OP_ROTATE_LEFT:
+  case Z3_OP_ROTATE_RIGHT:
+    return rotate_rows( *args[0u], decl_int_parameter( e, 0u ), kind == Z3_OP_ROTATE_LEFT );
+  case Z3_OP_EXT_ROTATE_LEFT:
+  case Z3_OP_EXT_ROTATE_RIGHT:
+    {
+      const unsigned w = args[0u]->size();
+      lane_rows q, amount;
+      udivrem_rows( *args[1u], rows_constant( bv_value( w, w ) ), q, amount );
+      lane_rows r = *args[0u];
+      for ( unsigned j = 0u; ( 1u << j ) < w; ++j )
+      {
+        r = mux_rows( amount[j], rotate_rows( r, 1u << j, kind == Z3_OP_EXT_ROTATE_LEFT ), r );
+      }
+      return r;
+    }
+
+  /*** Structure ***/
+  case Z3_OP_CONCAT:
+    {
+      lane_rows r;
+      for ( unsigned i = args.size(); i > 0u; --i )
+      {
+        r.insert( r.end(), args[i - 1u]->begin(), args[i - 1u]->end() );
+      }
+      return r;
+    }
+  case Z3_OP_EXTRACT:
+    return lane_rows( args[0u]->begin() + lo( e ), args[0u]->begin() + hi( e ) + 1u );
+  case Z3_OP_ZERO_EXT:
+  case Z3_OP_SIGN_EXT:
+    {
+      lane_rows r = *args[0u];
+      r.resize( r.size() + decl_int_parameter( e, 0u ), kind == Z3_OP_SIGN_EXT ? r.back() : zero );
+      return r;
+    }
+  case Z3_OP_REPEAT:
+    {
+      lane_rows r;
+      for ( unsigned i = 0u; i < decl_int_parameter( e, 0u ); ++i )
+      {
+        r.insert( r.end(), args[0u]->begin(), args[0u]->end() );
+      }
+      return r;
+    }
+
+  default:
+    std::cerr << "[e] cannot simulate " << e.decl().name() << '\n';
+    assert( false );
+    return lane_rows();
+  }
+}
+
+/******************************************************************************
+ * model search                                                               *
+ ******************************************************************************/
+
+bool find_model_by_simulation( const z3::expr& instance, unsigned rounds, simulation_stats& stats,
+                               std::vector< std::pair< std::string, std::string > >& model )
+{
+  const auto start = std::chrono::steady_clock::now();
+  bit_simulator simulator( instance );
+  bool found = false;
+  if ( simulator.supported() )
+  {
+    std::mt19937_64 rng( 1u );
+    for ( unsigned round = 0u; round < rounds && !found; ++round )
+    {
+      simulator.assign_random( rng, round );
+      simulator.run( false );
+      stats.assignments += simulation_lanes;
+
+      const unsigned i = first_lane( simulator.value( instance ).front() );
+      if ( i < simulation_lanes )
+      {
+        for ( const auto& v : simulator.variables() )
+        {
+          model.push_back( std::make_pair( v.decl().name().str(), simulator.lane_value( v, i ) ) );
+        }
+        found = true;
+      }
+    }
+  }
+  stats.seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  return found;
+}
+
+bool find_model_by_simulation( const z3::expr& instance, const checker_options& options )
+{
+  simulation_stats stats;
+  std::vector< std::pair< std::string, std::string > > model;
+  const bool found = find_model_by_simulation( instance, options.simulate, stats, model );
+  if ( options.stats )
+  {
+    std::cout << "[i] simulate: " << ( found ? "SAT" : "undecided" ) << " after " << stats.assignments << " assignments, "
+              << ( stats.seconds * 1000.0 ) << " ms\n";
+  }
+  for ( const auto& m : model )
+  {
+    std::cout << "[i] model: " << m.first << " = " << m.second << '\n';
+  }
+  return found;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,212 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file simulation.hpp
+ *
+ * @brief bit-parallel simulation of the Z3 DAG
+ *
+ * Values are bit-sliced: bit i of a term is a lane_block that holds
+ * bit i of the term in simulation_lanes assignments at once, one
+ * assignment per bit position.  The operators of convert_operator are
+ * evaluated with word operations on the blocks, e.g., addition as a
+ * ripple-carry adder; the loops over the words of a block are
+ * vectorized by the compiler.  Arrays and uninterpreted functions are
+ * not simulated.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "checker_options.hpp"
+
+#include <z3++.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+/* 64-bit words per block, simulation_lanes assignments per run */
+const unsigned simulation_words = 4u;
+const unsigned simulation_lanes = 64u * simulation_words;
+
+struct lane_block
+{
+  uint64_t words[simulation_words];
+};
+
+inline lane_block lanes_constant( bool value )
+{
+  lane_block r;
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    r.words[i] = value ? ~uint64_t( 0u ) : uint64_t( 0u );
+  }
+  return r;
+}
+
+inline lane_block operator&( const lane_block& a, const lane_block& b )
+{
+  lane_block r;
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    r.words[i] = a.words[i] & b.words[i];
+  }
+  return r;
+}
+
+inline lane_block operator|( const lane_block& a, const lane_block& b )
+{
+  lane_block r;
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    r.words[i] = a.words[i] | b.words[i];
+  }
+  return r;
+}
+
+inline lane_block operator^( const lane_block& a, const lane_block& b )
+{
+  lane_block r;
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    r.words[i] = a.words[i] ^ b.words[i];
+  }
+  return r;
+}
+
+inline lane_block operator~( const lane_block& a )
+{
+  lane_block r;
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    r.words[i] = ~a.words[i];
+  }
+  return r;
+}
+
+inline bool operator==( const lane_block& a, const lane_block& b )
+{
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    if ( a.words[i] != b.words[i] )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* index of the first set lane, simulation_lanes if there is none */
+inline unsigned first_lane( const lane_block& a )
+{
+  for ( unsigned i = 0u; i < simulation_words; ++i )
+  {
+    if ( a.words[i] != 0u )
+    {
+      return 64u * i + __builtin_ctzll( a.words[i] );
+    }
+  }
+  return simulation_lanes;
+}
+
+inline bool lane( const lane_block& a, unsigned i )
+{
+  return ( a.words[i / 64u] >> ( i % 64u ) ) & 1u;
+}
+
+/* bit i of a term at index i, Boolean terms have one block */
+typedef std::vector< lane_block > lane_rows;
+
+class bit_simulator
+{
+public:
+  explicit bit_simulator( const z3::expr& root );
+
+  /* false if the DAG contains terms that cannot be simulated */
+  bool supported() const { return is_supported; }
+
+  /**
+   * Draws the values of the variables.  In round 0 some lanes are
+   * all zeros, all ones and small values, the others are random.
+   */
+  void assign_random( std::mt19937_64& rng, unsigned round );
+
+  /**
+   * Evaluates the DAG.  Unless `keep' is set, the values of inner
+   * terms are released after their last use and only the root and the
+   * variables can be read afterwards.
+   */
+  void run( bool keep );
+
+  const lane_rows& value( const z3::expr& e ) const;
+  const std::vector< z3::expr >& terms() const { return order; }
+  const std::vector< z3::expr >& variables() const { return inputs; }
+
+  /* value of `e' in lane `i' as #b... or true/false */
+  std::string lane_value( const z3::expr& e, unsigned i ) const;
+
+private:
+  lane_rows evaluate( const z3::expr& e ) const;
+
+  std::vector< z3::expr > order;       /* children before parents */
+  std::vector< z3::expr > inputs;
+  std::unordered_map< unsigned, unsigned > index;
+  std::vector< lane_rows > values;
+  std::vector< unsigned > users;
+  bool is_supported;
+};
+
+/* exit code of metaSMT_check_file for instances satisfied by --simulate */
+const int sat_by_simulation = 2;
+
+struct simulation_stats
+{
+  simulation_stats()
+    : assignments( 0u )
+    , seconds( 0.0 )
+  {}
+
+  unsigned assignments;
+  double seconds;
+};
+
+/**
+ * Simulates `rounds' blocks of random assignments.  Returns true and
+ * the satisfying assignment of every variable as (name, value) if
+ * some lane satisfies `instance'.
+ */
+bool find_model_by_simulation( const z3::expr& instance, unsigned rounds, simulation_stats& stats,
+                               std::vector< std::pair< std::string, std::string > >& model );
+
+/**
+ * Runs find_model_by_simulation with options.simulate rounds and
+ * prints the model if one is found.  The statistics are printed with
+ * options.stats.
+ */
+bool find_model_by_simulation( const z3::expr& instance, const checker_options& options );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
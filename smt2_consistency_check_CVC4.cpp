@@ -15,11 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_CVC4
+#include "backends.hpp"
 #include "consistency_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/CVC4.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::solver::CVC4 >;
+using Solver = backends::CVC4;
 
 int main( int argc, char *argv[] )
 {
@@ -15,11 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_SMT2
+#include "backends.hpp"
 #include "consistency_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/SMT2.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::solver::SMT2 >;
+using Solver = backends::SMT2;
 
 int main( int argc, char *argv[] )
 {
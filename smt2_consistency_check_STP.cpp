@@ -15,11 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_STP
+#include "backends.hpp"
 #include "consistency_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/STP.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::solver::STP >;
+using Solver = backends::STP;
 
 int main( int argc, char *argv[] )
 {
@@ -15,11 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_Z3
+#include "backends.hpp"
 #include "consistency_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/Z3_Backend.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::solver::Z3_Backend >;
+using Solver = backends::Z3;
 
 int main( int argc, char *argv[] )
 {
@@ -0,0 +1,238 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend_registry.hpp"
+#include "batch_runner.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+
+const int unknown = -1;
+const int error = -2;
+
+const char *answer_name( int answer )
+{
+  return answer == 1 ? "SAT" : ( answer == 0 ? "UNSAT" : ( answer == error ? "ERROR" : "UNKNOWN" ) );
+}
+
+/**
+ * Answers of the reference solve (index 0) and of every backend for
+ * one instance, 1 = SAT, 0 = UNSAT.  An exception while parsing fails
+ * all answers, an exception of one solve only its answer; `messages'
+ * receives the reasons, one per answer.
+ */
+std::vector< int > check_all( const std::string& filename, const std::vector< backend_entry >& entries, unsigned threads,
+                              std::vector< double >& seconds, std::vector< std::string >& messages )
+{
+  std::vector< int > answers( entries.size() + 1u, unknown );
+  messages.assign( answers.size(), std::string() );
+
+  /*** Parse SMT-LIB2 instance or snapshot ***/
+  z3::context ctx;
+  z3::expr instance( ctx );
+  try
+  {
+    instance = load_instance( ctx, filename );
+
+    /*** Reference answer of Z3 ***/
+    z3::solver z3( ctx );
+    z3.add( instance );
+    const auto z3_sat = z3.check();
+    answers[0u] = z3_sat == z3::sat ? 1 : ( z3_sat == z3::unsat ? 0 : unknown );
+  }
+  catch ( const z3::exception& e )
+  {
+    answers.assign( answers.size(), error );
+    messages[0u] = e.msg();
+    return answers;
+  }
+  catch ( const std::exception& e )
+  {
+    answers.assign( answers.size(), error );
+    messages[0u] = e.what();
+    return answers;
+  }
+
+  /*** Convert and solve with every backend ***/
+  /* backends with global state solve one after the other */
+  std::mutex global_state;
+  std::atomic< bool > stop( false );
+  parallel_for_each( entries.size(), threads, stop, [&]( unsigned i ) {
+      std::unique_lock< std::mutex > lock( global_state, std::defer_lock );
+      if ( !entries[i].reentrant )
+      {
+        lock.lock();
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      try
+      {
+        answers[i + 1u] = entries[i].solve( instance ) ? 1 : 0;
+      }
+      catch ( const z3::exception& e )
+      {
+        answers[i + 1u] = error;
+        messages[i + 1u] = e.msg();
+      }
+      catch ( const std::exception& e )
+      {
+        answers[i + 1u] = error;
+        messages[i + 1u] = e.what();
+      }
+      seconds[i] += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    } );
+  return answers;
+}
+
+void print_matrix( const std::vector< std::string >& names, const std::vector< std::vector< unsigned > >& disagreements )
+{
+  unsigned width = 0u;
+  for ( const auto& n : names )
+  {
+    width = std::max< unsigned >( width, n.size() );
+  }
+
+  std::cout << "[i] disagreements (number of instances)\n" << std::setw( width + 2u ) << "";
+  for ( const auto& n : names )
+  {
+    std::cout << ' ' << std::setw( width ) << n;
+  }
+  std::cout << '\n';
+  for ( unsigned i = 0u; i < names.size(); ++i )
+  {
+    std::cout << "  " << std::left << std::setw( width ) << names[i] << std::right;
+    for ( unsigned j = 0u; j < names.size(); ++j )
+    {
+      std::cout << ' ' << std::setw( width ) << disagreements[i][j];
+    }
+    std::cout << '\n';
+  }
+}
+
+}
+
+/*
+ * Checks an instance, or with --batch every listed instance, against
+ * all backends linked into the executable.  The instance is parsed and
+ * solved by Z3 once; the backends convert the same Z3 AST.
+ */
+int main( int argc, char *argv[] )
+{
+  checker_options options;
+  if ( !parse_checker_options( argc, argv, options ) )
+  {
+    print_checker_usage( argv[0] );
+    return -1;
+  }
+
+  if ( options.decompose || options.cube_and_conquer || !options.export_dimacs.empty() || options.native_parser || options.low_memory || options.cegar || options.preprocess || options.reduce_widths || options.simulate > 0u || options.sweep || options.pipeline || options.reuse > 0u || !options.minimize.empty() || options.polarity || options.counters )
+  {
+    std::cerr << "[e] smt2_consistency_check_all only supports --threads, --batch and --stats\n";
+    return -1;
+  }
+
+  std::vector< std::string > instances;
+  if ( options.batch )
+  {
+    if ( !read_instance_list( options.filename, instances ) )
+    {
+      return -1;
+    }
+  }
+  else
+  {
+    instances.push_back( options.filename );
+  }
+
+  const std::vector< backend_entry > entries = available_backends();
+  std::vector< std::string > names( 1u, "reference" );
+  for ( const auto& e : entries )
+  {
+    names.push_back( e.name );
+  }
+
+  std::vector< std::vector< unsigned > > disagreements( names.size(), std::vector< unsigned >( names.size(), 0u ) );
+  std::vector< double > seconds( entries.size(), 0.0 );
+  unsigned inconsistent = 0u, failed = 0u;
+  for ( const auto& filename : instances )
+  {
+    std::vector< std::string > messages;
+    const std::vector< int > answers = check_all( filename, entries, checker_threads( options ), seconds, messages );
+
+    bool consistent = true, errors = false;
+    for ( unsigned i = 0u; i < answers.size(); ++i )
+    {
+      errors = errors || answers[i] == error;
+      for ( unsigned j = 0u; j < answers.size(); ++j )
+      {
+        if ( answers[i] >= 0 && answers[j] >= 0 && answers[i] != answers[j] )
+        {
+          ++disagreements[i][j];
+          consistent = false;
+        }
+      }
+    }
+
+    inconsistent += !consistent;
+    failed += errors;
+    if ( !consistent || errors )
+    {
+      std::cout << "[e] " << filename << ':';
+      for ( unsigned i = 0u; i < answers.size(); ++i )
+      {
+        std::cout << ' ' << names[i] << '=' << answer_name( answers[i] );
+      }
+      std::cout << '\n';
+      for ( unsigned i = 0u; i < messages.size(); ++i )
+      {
+        if ( !messages[i].empty() )
+        {
+          std::cout << "[e]   " << names[i] << ": " << messages[i] << '\n';
+        }
+      }
+    }
+  }
+
+  if ( options.stats )
+  {
+    for ( unsigned i = 0u; i < entries.size(); ++i )
+    {
+      std::cout << "[i] " << entries[i].name << ": " << seconds[i] << " s\n";
+    }
+  }
+
+  if ( inconsistent > 0u || instances.size() > 1u )
+  {
+    print_matrix( names, disagreements );
+  }
+  if ( failed > 0u )
+  {
+    std::cout << "[e] " << failed << " of " << instances.size() << " instances failed\n";
+  }
+  return inconsistent == 0u && failed == 0u ? 0 : -1;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
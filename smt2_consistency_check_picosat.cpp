@@ -15,13 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_picosat
+#include "backends.hpp"
 #include "consistency_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/SAT_Clause.hpp>
-#include <metaSMT/backend/PicoSAT.hpp>
-#include <metaSMT/BitBlast.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::BitBlast< metaSMT::SAT_Clause < metaSMT::solver::PicoSAT > > >;
+using Solver = backends::picosat;
 
 int main( int argc, char *argv[] )
 {
@@ -0,0 +1,59 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance_features.hpp"
+#include "snapshot.hpp"
+
+#include <iostream>
+
+/*
+ * Writes the features of every instance as one CSV line to stdout.
+ * Instances that cannot be parsed are reported and skipped.
+ */
+int main( int argc, char *argv[] )
+{
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " <filename>...\n";
+    return -1;
+  }
+
+  write_features_header( std::cout );
+
+  int result = 0;
+  for ( int i = 1; i < argc; ++i )
+  {
+    try
+    {
+      z3::context ctx;
+      const z3::expr instance = load_instance( ctx, argv[i] );
+      write_features( std::cout, argv[i], extract_features( instance ) );
+    }
+    catch ( const z3::exception& e )
+    {
+      std::cerr << "[e] " << argv[i] << ": " << e.msg() << '\n';
+      result = -1;
+    }
+  }
+  return result;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,246 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt2_lexer.hpp"
+
+#include <cctype>
+#include <sstream>
+
+namespace
+{
+
+std::string error_message( unsigned line, const std::string& what )
+{
+  std::ostringstream ss;
+  ss << "line " << line << ": " << what;
+  return ss.str();
+}
+
+bool is_symbol_char( int c )
+{
+  return std::isalnum( c ) || std::string( "~!@$%^&*_-+=<>.?/" ).find( static_cast< char >( c ) ) != std::string::npos;
+}
+
+}
+
+smt2_parse_error::smt2_parse_error( unsigned line, const std::string& what )
+  : std::runtime_error( error_message( line, what ) )
+{}
+
+smt2_lexer::smt2_lexer( std::istream& is )
+  : buf( is.rdbuf() )
+  , current_line( 1u )
+  , has_peeked( false )
+{}
+
+smt2_token smt2_lexer::next()
+{
+  if ( has_peeked )
+  {
+    has_peeked = false;
+    return peeked;
+  }
+
+  while ( !replays.empty() )
+  {
+    replay_source& r = replays.back();
+    if ( r.pos < r.tokens->size() )
+    {
+      return ( *r.tokens )[r.pos++];
+    }
+    replays.pop_back();
+  }
+  return read();
+}
+
+const smt2_token& smt2_lexer::peek()
+{
+  if ( !has_peeked )
+  {
+    peeked = next();
+    has_peeked = true;
+  }
+  return peeked;
+}
+
+std::vector< smt2_token > smt2_lexer::read_sexpr()
+{
+  std::vector< smt2_token > tokens;
+  int depth = 0;
+  do
+  {
+    tokens.push_back( next() );
+    switch ( tokens.back().kind )
+    {
+    case smt2_token::lparen: ++depth; break;
+    case smt2_token::rparen: --depth; break;
+    case smt2_token::end: throw smt2_parse_error( current_line, "unexpected end of input" );
+    default: break;
+    }
+  } while ( depth > 0 );
+
+  if ( depth < 0 )
+  {
+    throw smt2_parse_error( current_line, "unbalanced parentheses" );
+  }
+  return tokens;
+}
+
+void smt2_lexer::replay( const std::vector< smt2_token >& tokens )
+{
+  if ( has_peeked )
+  {
+    throw smt2_parse_error( current_line, "replay after peek" );
+  }
+  replay_source r;
+  r.tokens = &tokens;
+  r.pos = 0u;
+  replays.push_back( r );
+}
+
+smt2_token smt2_lexer::read()
+{
+  typedef std::char_traits< char > traits;
+
+  /*** skip white space and comments ***/
+  int c = buf->sbumpc();
+  for ( ;; )
+  {
+    if ( c == '\n' )
+    {
+      ++current_line;
+    }
+    if ( c == ';' )
+    {
+      while ( c != traits::eof() && c != '\n' )
+      {
+        c = buf->sbumpc();
+      }
+      continue;
+    }
+    if ( c == traits::eof() || !std::isspace( c ) )
+    {
+      break;
+    }
+    c = buf->sbumpc();
+  }
+
+  smt2_token t;
+  t.line = current_line;
+  if ( c == traits::eof() )
+  {
+    t.kind = smt2_token::end;
+    return t;
+  }
+
+  switch ( c )
+  {
+  case '(':
+    t.kind = smt2_token::lparen;
+    return t;
+  case ')':
+    t.kind = smt2_token::rparen;
+    return t;
+  case '|':
+    t.kind = smt2_token::symbol;
+    for ( c = buf->sbumpc(); c != '|'; c = buf->sbumpc() )
+    {
+      if ( c == traits::eof() )
+      {
+        throw smt2_parse_error( t.line, "unterminated quoted symbol" );
+      }
+      current_line += ( c == '\n' );
+      t.text.push_back( static_cast< char >( c ) );
+    }
+    return t;
+  case '"':
+    t.kind = smt2_token::string;
+    for ( ;; )
+    {
+      c = buf->sbumpc();
+      if ( c == traits::eof() )
+      {
+        throw smt2_parse_error( t.line, "unterminated string literal" );
+      }
+      if ( c == '"' )
+      {
+        /* "" is an escaped quote */
+        if ( buf->sgetc() != '"' )
+        {
+          break;
+        }
+        c = buf->sbumpc();
+      }
+      current_line += ( c == '\n' );
+      t.text.push_back( static_cast< char >( c ) );
+    }
+    return t;
+  case '#':
+    c = buf->sbumpc();
+    if ( c == 'b' )
+    {
+      t.kind = smt2_token::binary;
+    }
+    else if ( c == 'x' )
+    {
+      t.kind = smt2_token::hexadecimal;
+    }
+    else
+    {
+      throw smt2_parse_error( t.line, "invalid literal" );
+    }
+    while ( std::isxdigit( buf->sgetc() ) )
+    {
+      t.text.push_back( static_cast< char >( buf->sbumpc() ) );
+    }
+    return t;
+  default:
+    break;
+  }
+
+  if ( c == ':' )
+  {
+    t.kind = smt2_token::keyword;
+    t.text.push_back( ':' );
+  }
+  else if ( std::isdigit( c ) )
+  {
+    t.kind = smt2_token::numeral;
+    t.text.push_back( static_cast< char >( c ) );
+  }
+  else if ( is_symbol_char( c ) )
+  {
+    t.kind = smt2_token::symbol;
+    t.text.push_back( static_cast< char >( c ) );
+  }
+  else
+  {
+    throw smt2_parse_error( t.line, std::string( "unexpected character '" ) + static_cast< char >( c ) + "'" );
+  }
+
+  while ( is_symbol_char( buf->sgetc() ) )
+  {
+    t.text.push_back( static_cast< char >( buf->sbumpc() ) );
+  }
+  return t;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,97 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file smt2_lexer.hpp
+ *
+ * @brief streaming tokenizer for SMT-LIB2
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#pragma once
+
+class smt2_parse_error : public std::runtime_error
+{
+public:
+  smt2_parse_error( unsigned line, const std::string& what );
+};
+
+struct smt2_token
+{
+  enum kind_type
+  {
+    lparen, rparen, symbol, numeral, binary, hexadecimal, string, keyword, end
+  };
+
+  smt2_token()
+    : kind( end )
+    , line( 0u )
+  {}
+
+  kind_type kind;
+  std::string text;   /* without #b, #x, quotes and bars */
+  unsigned line;
+};
+
+/**
+ * Reads tokens one at a time from a stream, i.e., the input is never
+ * held in memory as a whole.  Tokens recorded with replay() are
+ * returned before further input is read, which is used to expand
+ * macros defined by define-fun.
+ */
+class smt2_lexer
+{
+public:
+  explicit smt2_lexer( std::istream& is );
+
+  smt2_token next();
+  const smt2_token& peek();
+
+  /* returns the tokens of the next complete s-expression */
+  std::vector< smt2_token > read_sexpr();
+
+  void replay( const std::vector< smt2_token >& tokens );
+  unsigned line() const { return current_line; }
+
+private:
+  smt2_token read();
+
+  std::streambuf *buf;
+  unsigned current_line;
+  bool has_peeked;
+  smt2_token peeked;
+
+  struct replay_source
+  {
+    const std::vector< smt2_token > *tokens;
+    std::size_t pos;
+  };
+  std::vector< replay_source > replays;
+};
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,876 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file smt2_parser.hpp
+ *
+ * @brief streaming QF_BV parser that emits metaSMT terms directly
+ *
+ * The parser reads one command at a time and asserts every assertion
+ * in the solver context as soon as it is read, hence neither the
+ * input nor a Z3 AST is ever held in memory.  Supported are
+ * declare-fun and declare-const (Bool and bit-vector sorts),
+ * define-fun (with and without parameters), assert, let, `!' with
+ * :named and the QF_BV operators of convert_application().  Only a
+ * single check-sat is supported, push and pop are rejected.
+ *
+ * Terms are parsed with an explicit stack such that deeply nested
+ * let chains do not overflow the call stack.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "conversion_utils.hpp"
+#include "operator_conversion.hpp"
+#include "smt2_lexer.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma once
+
+template < typename Solver >
+class smt2_qfbv_parser
+{
+public:
+  using result_type = typename Solver::result_type;
+
+  smt2_qfbv_parser( Solver& solver, std::istream& is )
+    : solver( solver )
+    , lex( is )
+    , macro_level( 0u )
+    , num_assertions( 0u )
+  {}
+
+  /**
+   * Reads all commands and asserts the assertions.  Throws an
+   * smt2_parse_error on malformed or unsupported input.
+   */
+  void parse()
+  {
+    unsigned num_check_sat = 0u;
+    for ( ;; )
+    {
+      const smt2_token t = lex.next();
+      if ( t.kind == smt2_token::end )
+      {
+        break;
+      }
+      if ( t.kind != smt2_token::lparen )
+      {
+        throw smt2_parse_error( t.line, "expected command" );
+      }
+
+      const std::string command = expect_symbol();
+      if ( command == "declare-fun" || command == "declare-const" )
+      {
+        const std::string name = expect_symbol();
+        if ( command == "declare-fun" )
+        {
+          expect( smt2_token::lparen, "(" );
+          if ( lex.next().kind != smt2_token::rparen )
+          {
+            throw smt2_parse_error( lex.line(), "uninterpreted functions are not supported" );
+          }
+        }
+        const unsigned width = parse_sort();
+        expect( smt2_token::rparen, ")" );
+        declare( name, width );
+      }
+      else if ( command == "define-fun" )
+      {
+        define_fun();
+      }
+      else if ( command == "assert" )
+      {
+        const term r = parse_term();
+        expect( smt2_token::rparen, ")" );
+        if ( r.width != 0u )
+        {
+          throw smt2_parse_error( lex.line(), "assertion is not Boolean" );
+        }
+        metaSMT::assertion( solver, r.value );
+        ++num_assertions;
+      }
+      else if ( command == "check-sat" )
+      {
+        if ( ++num_check_sat > 1u )
+        {
+          throw smt2_parse_error( t.line, "multiple check-sat commands are not supported" );
+        }
+        expect( smt2_token::rparen, ")" );
+      }
+      else if ( command == "push" || command == "pop" )
+      {
+        throw smt2_parse_error( t.line, command + " is not supported" );
+      }
+      else
+      {
+        /* set-logic, set-info, set-option, get-*, exit, ... */
+        skip_rest();
+      }
+    }
+  }
+
+  unsigned assertions() const { return num_assertions; }
+
+private:
+  struct term
+  {
+    result_type value;
+    unsigned width;     /* 0 for Bool */
+    std::string bits;   /* value of bit-vector literals, empty otherwise */
+  };
+
+  struct macro
+  {
+    std::vector< std::pair< std::string, unsigned > > parameters;
+    std::vector< smt2_token > body;
+    unsigned width;
+  };
+
+  struct binding
+  {
+    term value;
+    unsigned level;
+  };
+
+  struct frame
+  {
+    enum kind_type { application, let_binding, let_body, annotation, macro_body };
+
+    kind_type kind;
+    unsigned line;
+    std::string name;
+    std::vector< unsigned > indices;
+    std::vector< term > args;
+    std::vector< std::string > names; /* bound by let or macro expansion */
+  };
+
+  /*** tokens ***/
+
+  smt2_token expect( smt2_token::kind_type kind, const char *what )
+  {
+    const smt2_token t = lex.next();
+    if ( t.kind != kind )
+    {
+      throw smt2_parse_error( t.line, std::string( "expected " ) + what );
+    }
+    return t;
+  }
+
+  std::string expect_symbol()
+  {
+    return expect( smt2_token::symbol, "symbol" ).text;
+  }
+
+  unsigned expect_numeral()
+  {
+    return static_cast< unsigned >( std::stoul( expect( smt2_token::numeral, "numeral" ).text ) );
+  }
+
+  /* skips the remainder of the current s-expression */
+  void skip_rest()
+  {
+    unsigned depth = 1u;
+    while ( depth > 0u )
+    {
+      const smt2_token t = lex.next();
+      switch ( t.kind )
+      {
+      case smt2_token::lparen: ++depth; break;
+      case smt2_token::rparen: --depth; break;
+      case smt2_token::end: throw smt2_parse_error( t.line, "unexpected end of input" );
+      default: break;
+      }
+    }
+  }
+
+  /* returns the width of a bit-vector sort or 0 for Bool */
+  unsigned parse_sort()
+  {
+    const smt2_token t = lex.next();
+    if ( t.kind == smt2_token::symbol && t.text == "Bool" )
+    {
+      return 0u;
+    }
+    if ( t.kind == smt2_token::lparen && expect_symbol() == "_" && expect_symbol() == "BitVec" )
+    {
+      const unsigned width = expect_numeral();
+      expect( smt2_token::rparen, ")" );
+      if ( width > 0u )
+      {
+        return width;
+      }
+    }
+    throw smt2_parse_error( t.line, "unsupported sort" );
+  }
+
+  /*** symbols ***/
+
+  void declare( const std::string& name, unsigned width )
+  {
+    using namespace metaSMT::logic;
+    using namespace metaSMT::logic::QF_BV;
+
+    term v;
+    v.width = width;
+    if ( width == 0u )
+    {
+      v.value = metaSMT::evaluate( solver, new_variable() );
+    }
+    else
+    {
+      v.value = metaSMT::evaluate( solver, new_bitvector( width ) );
+    }
+    globals[name] = v;
+  }
+
+  void define_fun()
+  {
+    const std::string name = expect_symbol();
+
+    macro m;
+    expect( smt2_token::lparen, "(" );
+    for ( smt2_token t = lex.next(); t.kind != smt2_token::rparen; t = lex.next() )
+    {
+      if ( t.kind != smt2_token::lparen )
+      {
+        throw smt2_parse_error( t.line, "expected sorted variable" );
+      }
+      const std::string parameter = expect_symbol();
+      m.parameters.push_back( std::make_pair( parameter, parse_sort() ) );
+      expect( smt2_token::rparen, ")" );
+    }
+    m.width = parse_sort();
+
+    if ( m.parameters.empty() )
+    {
+      /* constants are converted once and shared by all uses */
+      const term body = parse_term();
+      check_width( body, m.width, name );
+      globals[name] = body;
+    }
+    else
+    {
+      m.body = lex.read_sexpr();
+      macros[name] = m;
+    }
+    expect( smt2_token::rparen, ")" );
+  }
+
+  void bind( const std::string& name, const term& value )
+  {
+    binding b;
+    b.value = value;
+    b.level = macro_level;
+    scoped[name].push_back( b );
+  }
+
+  void unbind( const std::vector< std::string >& names )
+  {
+    for ( const auto& name : names )
+    {
+      const auto it = scoped.find( name );
+      it->second.pop_back();
+      if ( it->second.empty() )
+      {
+        scoped.erase( it );
+      }
+    }
+  }
+
+  /*
+   * Let-bound names and macro parameters are only visible at the
+   * macro level they were bound at, i.e., a macro body does not see
+   * the let bindings around its call.
+   */
+  term lookup( const smt2_token& t ) const
+  {
+    const auto s = scoped.find( t.text );
+    if ( s != scoped.end() && s->second.back().level == macro_level )
+    {
+      return s->second.back().value;
+    }
+    const auto g = globals.find( t.text );
+    if ( g != globals.end() )
+    {
+      return g->second;
+    }
+    if ( t.text == "true" || t.text == "false" )
+    {
+      term r;
+      r.width = 0u;
+      r.value = ( t.text == "true" ) ? metaSMT::evaluate( solver, metaSMT::logic::True ) : metaSMT::evaluate( solver, metaSMT::logic::False );
+      return r;
+    }
+    if ( macros.find( t.text ) != macros.end() )
+    {
+      throw smt2_parse_error( t.line, "function " + t.text + " used without arguments" );
+    }
+    throw smt2_parse_error( t.line, "unknown symbol " + t.text );
+  }
+
+  term bv_literal( const std::string& bits )
+  {
+    term r;
+    r.width = bits.size();
+    r.value = metaSMT::evaluate( solver, metaSMT::logic::QF_BV::bvbin( bits ) );
+    r.bits = bits;
+    return r;
+  }
+
+  term atom( const smt2_token& t )
+  {
+    switch ( t.kind )
+    {
+    case smt2_token::symbol:
+      return lookup( t );
+    case smt2_token::binary:
+      if ( !t.text.empty() && t.text.find_first_not_of( "01" ) == std::string::npos )
+      {
+        return bv_literal( t.text );
+      }
+      break;
+    case smt2_token::hexadecimal:
+      if ( !t.text.empty() )
+      {
+        return bv_literal( convert_hex2bin( t.text ) );
+      }
+      break;
+    default:
+      break;
+    }
+    throw smt2_parse_error( t.line, "unexpected token in term" );
+  }
+
+  void check_width( const term& t, unsigned width, const std::string& context ) const
+  {
+    if ( t.width != width )
+    {
+      throw smt2_parse_error( lex.line(), "sort mismatch in " + context );
+    }
+  }
+
+  /*** terms ***/
+
+  term parse_term()
+  {
+    std::vector< frame > stack;
+    term result;
+
+    for ( ;; )
+    {
+      /*** read until a complete term is available ***/
+      const smt2_token t = lex.next();
+      if ( t.kind == smt2_token::rparen && !stack.empty() && stack.back().kind == frame::application )
+      {
+        if ( !close_application( stack, result ) )
+        {
+          continue;
+        }
+      }
+      else if ( t.kind == smt2_token::lparen )
+      {
+        if ( !open_term( stack, result ) )
+        {
+          continue;
+        }
+      }
+      else
+      {
+        result = atom( t );
+      }
+
+      /*** hand the term to the enclosing frames ***/
+      for ( ;; )
+      {
+        if ( stack.empty() )
+        {
+          return result;
+        }
+
+        frame& f = stack.back();
+        if ( f.kind == frame::application )
+        {
+          f.args.push_back( result );
+          break;
+        }
+        else if ( f.kind == frame::let_binding )
+        {
+          f.args.push_back( result );
+          expect( smt2_token::rparen, ")" );
+          next_let_binding( f );
+          break;
+        }
+        else if ( f.kind == frame::let_body )
+        {
+          expect( smt2_token::rparen, ")" );
+          unbind( f.names );
+        }
+        else if ( f.kind == frame::annotation )
+        {
+          read_attributes( result );
+        }
+        else /* macro_body */
+        {
+          unbind( f.names );
+          --macro_level;
+        }
+        stack.pop_back();
+      }
+    }
+  }
+
+  /*
+   * Called after `('.  Returns true if a complete term was read,
+   * otherwise a frame was pushed.
+   */
+  bool open_term( std::vector< frame >& stack, term& result )
+  {
+    frame f;
+    f.kind = frame::application;
+
+    const smt2_token t = lex.next();
+    f.line = t.line;
+    if ( t.kind == smt2_token::lparen )
+    {
+      /* indexed operator, e.g., ((_ extract 7 0) x) */
+      if ( expect_symbol() != "_" )
+      {
+        throw smt2_parse_error( t.line, "expected indexed operator" );
+      }
+      f.name = expect_symbol();
+      for ( smt2_token i = lex.next(); i.kind != smt2_token::rparen; i = lex.next() )
+      {
+        if ( i.kind != smt2_token::numeral )
+        {
+          throw smt2_parse_error( i.line, "expected numeral" );
+        }
+        f.indices.push_back( static_cast< unsigned >( std::stoul( i.text ) ) );
+      }
+    }
+    else if ( t.kind != smt2_token::symbol )
+    {
+      throw smt2_parse_error( t.line, "expected operator" );
+    }
+    else if ( t.text == "_" )
+    {
+      /* (_ bvN w) */
+      const std::string value = expect_symbol();
+      const unsigned width = expect_numeral();
+      expect( smt2_token::rparen, ")" );
+      if ( value.size() < 3u || value.compare( 0u, 2u, "bv" ) != 0 || value.find_first_not_of( "0123456789", 2u ) != std::string::npos || width == 0u )
+      {
+        throw smt2_parse_error( t.line, "unsupported indexed constant " + value );
+      }
+      result = bv_literal( convert_dec2bin( value.substr( 2u ), width ) );
+      return true;
+    }
+    else if ( t.text == "let" )
+    {
+      expect( smt2_token::lparen, "(" );
+      f.kind = frame::let_binding;
+      stack.push_back( f );
+      next_let_binding( stack.back() );
+      return false;
+    }
+    else if ( t.text == "!" )
+    {
+      f.kind = frame::annotation;
+    }
+    else
+    {
+      f.name = t.text;
+    }
+
+    stack.push_back( f );
+    return false;
+  }
+
+  /*
+   * Reads the name of the next binding, or the end of the binding
+   * list in which case all names are bound at once (let binds in
+   * parallel) and the body follows.
+   */
+  void next_let_binding( frame& f )
+  {
+    const smt2_token t = lex.next();
+    if ( t.kind == smt2_token::lparen )
+    {
+      f.names.push_back( expect_symbol() );
+    }
+    else if ( t.kind == smt2_token::rparen )
+    {
+      for ( unsigned i = 0u; i < f.names.size(); ++i )
+      {
+        bind( f.names[i], f.args[i] );
+      }
+      f.args.clear();
+      f.kind = frame::let_body;
+    }
+    else
+    {
+      throw smt2_parse_error( t.line, "expected let binding" );
+    }
+  }
+
+  void read_attributes( const term& annotated )
+  {
+    for ( smt2_token t = lex.next(); t.kind != smt2_token::rparen; t = lex.next() )
+    {
+      if ( t.kind != smt2_token::keyword )
+      {
+        throw smt2_parse_error( t.line, "expected attribute" );
+      }
+      if ( t.text == ":named" )
+      {
+        globals[expect_symbol()] = annotated;
+      }
+      else if ( lex.peek().kind != smt2_token::keyword && lex.peek().kind != smt2_token::rparen )
+      {
+        lex.read_sexpr();
+      }
+    }
+  }
+
+  /*
+   * Called after the closing `)' of an application.  Returns true if
+   * the application was converted, false if a macro was expanded and
+   * its body has to be read.
+   */
+  bool close_application( std::vector< frame >& stack, term& result )
+  {
+    frame& f = stack.back();
+
+    const auto m = macros.find( f.name );
+    if ( m != macros.end() && f.indices.empty() )
+    {
+      const macro& def = m->second;
+      if ( def.parameters.size() != f.args.size() )
+      {
+        throw smt2_parse_error( f.line, "wrong number of arguments for " + f.name );
+      }
+
+      ++macro_level;
+      for ( unsigned i = 0u; i < f.args.size(); ++i )
+      {
+        check_width( f.args[i], def.parameters[i].second, f.name );
+        bind( def.parameters[i].first, f.args[i] );
+        f.names.push_back( def.parameters[i].first );
+      }
+      f.args.clear();
+      f.kind = frame::macro_body;
+      lex.replay( def.body );
+      return false;
+    }
+
+    result = apply( f );
+    stack.pop_back();
+    return true;
+  }
+
+  term apply( const frame& f )
+  {
+    using namespace metaSMT::logic;
+
+    static const std::map< std::string, Z3_decl_kind > operators = {
+      { "=", Z3_OP_EQ }, { "distinct", Z3_OP_DISTINCT }, { "ite", Z3_OP_ITE },
+      { "and", Z3_OP_AND }, { "or", Z3_OP_OR }, { "xor", Z3_OP_XOR },
+      { "not", Z3_OP_NOT }, { "=>", Z3_OP_IMPLIES },
+      { "bvneg", Z3_OP_BNEG }, { "bvadd", Z3_OP_BADD }, { "bvsub", Z3_OP_BSUB },
+      { "bvmul", Z3_OP_BMUL }, { "bvudiv", Z3_OP_BUDIV }, { "bvurem", Z3_OP_BUREM },
+      { "bvsdiv", Z3_OP_BSDIV }, { "bvsrem", Z3_OP_BSREM }, { "bvsmod", Z3_OP_BSMOD },
+      { "bvshl", Z3_OP_BSHL }, { "bvlshr", Z3_OP_BLSHR }, { "bvashr", Z3_OP_BASHR },
+      { "bvnot", Z3_OP_BNOT }, { "bvand", Z3_OP_BAND }, { "bvor", Z3_OP_BOR },
+      { "bvxor", Z3_OP_BXOR }, { "bvnand", Z3_OP_BNAND }, { "bvnor", Z3_OP_BNOR },
+      { "bvxnor", Z3_OP_BXNOR }, { "bvcomp", Z3_OP_BCOMP }, { "concat", Z3_OP_CONCAT },
+      { "bvule", Z3_OP_ULEQ }, { "bvult", Z3_OP_ULT }, { "bvuge", Z3_OP_UGEQ },
+      { "bvugt", Z3_OP_UGT }, { "bvsle", Z3_OP_SLEQ }, { "bvslt", Z3_OP_SLT },
+      { "bvsge", Z3_OP_SGEQ }, { "bvsgt", Z3_OP_SGT },
+      { "extract", Z3_OP_EXTRACT }, { "zero_extend", Z3_OP_ZERO_EXT },
+      { "sign_extend", Z3_OP_SIGN_EXT }, { "repeat", Z3_OP_REPEAT },
+      { "rotate_left", Z3_OP_ROTATE_LEFT }, { "rotate_right", Z3_OP_ROTATE_RIGHT }
+    };
+
+    const auto it = operators.find( f.name );
+    if ( it == operators.end() )
+    {
+      throw smt2_parse_error( f.line, "unsupported operator " + f.name );
+    }
+
+    operator_node node;
+    node.kind = it->second;
+    node.param0 = f.indices.size() > 0u ? f.indices[0u] : 0u;
+    node.param1 = f.indices.size() > 1u ? f.indices[1u] : 0u;
+    check_arity( f, node.kind );
+
+    const std::vector< term >& args = f.args;
+    switch ( node.kind )
+    {
+    case Z3_OP_EQ:
+      {
+        /* chainable: (= a b c) is (and (= a b) (= b c)) */
+        node.width = 0u;
+        std::vector< result_type > pairs;
+        for ( unsigned i = 1u; i < args.size(); ++i )
+        {
+          check_width( args[i], args[0u].width, f.name );
+          pairs.push_back( convert( node, args[i-1u], args[i] ) );
+        }
+        if ( pairs.size() == 1u )
+        {
+          return make_term( pairs.front(), 0u );
+        }
+        node.kind = Z3_OP_AND;
+        return make_term( convert_application( solver, node, pairs ), 0u );
+      }
+    case Z3_OP_IMPLIES:
+      {
+        /* right associative */
+        node.width = 0u;
+        term r = args.back();
+        for ( unsigned i = args.size() - 1u; i-- > 0u; )
+        {
+          r = make_term( convert( node, args[i], r ), 0u );
+        }
+        return r;
+      }
+    case Z3_OP_XOR:
+    case Z3_OP_BADD:
+    case Z3_OP_BMUL:
+    case Z3_OP_BAND:
+    case Z3_OP_BOR:
+    case Z3_OP_BXOR:
+    case Z3_OP_CONCAT:
+      {
+        /* left associative */
+        term r = args.front();
+        for ( unsigned i = 1u; i < args.size(); ++i )
+        {
+          if ( node.kind != Z3_OP_CONCAT )
+          {
+            check_width( args[i], r.width, f.name );
+          }
+          node.width = ( node.kind == Z3_OP_CONCAT ) ? r.width + args[i].width : r.width;
+          r = make_term( convert( node, r, args[i] ), node.width );
+        }
+        return r;
+      }
+    default:
+      break;
+    }
+
+    node.width = result_width( f, node );
+    if ( has_amount_argument( node.kind ) && !args[1u].bits.empty() )
+    {
+      set_constant_amount( node, args[1u].bits );
+    }
+    argument_refs< result_type > values;
+    values.reserve( args.size() );
+    for ( const auto& a : args )
+    {
+      values.push_back( a.value );
+    }
+    return make_term( convert_application( solver, node, values ), node.width );
+  }
+
+  void check_arity( const frame& f, Z3_decl_kind kind ) const
+  {
+    unsigned num_args = 2u;
+    unsigned num_indices = 0u;
+    bool nary = false;
+    switch ( kind )
+    {
+    case Z3_OP_NOT:
+    case Z3_OP_BNEG:
+    case Z3_OP_BNOT:
+      num_args = 1u;
+      break;
+    case Z3_OP_EXTRACT:
+      num_args = 1u;
+      num_indices = 2u;
+      break;
+    case Z3_OP_ZERO_EXT:
+    case Z3_OP_SIGN_EXT:
+    case Z3_OP_REPEAT:
+    case Z3_OP_ROTATE_LEFT:
+    case Z3_OP_ROTATE_RIGHT:
+      num_args = 1u;
+      num_indices = 1u;
+      break;
+    case Z3_OP_ITE:
+      num_args = 3u;
+      break;
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+      num_args = 1u;
+      nary = true;
+      break;
+    case Z3_OP_EQ:
+    case Z3_OP_DISTINCT:
+    case Z3_OP_IMPLIES:
+    case Z3_OP_XOR:
+    case Z3_OP_BADD:
+    case Z3_OP_BMUL:
+    case Z3_OP_BAND:
+    case Z3_OP_BOR:
+    case Z3_OP_BXOR:
+    case Z3_OP_CONCAT:
+      nary = true;
+      break;
+    default:
+      break;
+    }
+
+    if ( f.indices.size() != num_indices || f.args.size() < num_args || ( !nary && f.args.size() != num_args ) )
+    {
+      throw smt2_parse_error( f.line, "wrong number of arguments or indices for " + f.name );
+    }
+  }
+
+  unsigned result_width( const frame& f, const operator_node& node ) const
+  {
+    const std::vector< term >& args = f.args;
+    switch ( node.kind )
+    {
+    case Z3_OP_DISTINCT:
+      for ( const auto& a : args )
+      {
+        check_width( a, args[0u].width, f.name );
+      }
+      return 0u;
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+    case Z3_OP_NOT:
+      for ( const auto& a : args )
+      {
+        check_width( a, 0u, f.name );
+      }
+      return 0u;
+    case Z3_OP_ITE:
+      check_width( args[0u], 0u, f.name );
+      check_width( args[2u], args[1u].width, f.name );
+      return args[1u].width;
+    case Z3_OP_ULEQ:
+    case Z3_OP_ULT:
+    case Z3_OP_UGEQ:
+    case Z3_OP_UGT:
+    case Z3_OP_SLEQ:
+    case Z3_OP_SLT:
+    case Z3_OP_SGEQ:
+    case Z3_OP_SGT:
+      check_width( args[1u], args[0u].width, f.name );
+      return 0u;
+    case Z3_OP_BCOMP:
+      check_width( args[1u], args[0u].width, f.name );
+      return 1u;
+    case Z3_OP_EXTRACT:
+      if ( node.param0 < node.param1 || node.param0 >= args[0u].width )
+      {
+        throw smt2_parse_error( f.line, "invalid extract indices" );
+      }
+      return node.param0 - node.param1 + 1u;
+    case Z3_OP_ZERO_EXT:
+    case Z3_OP_SIGN_EXT:
+      return args[0u].width + node.param0;
+    case Z3_OP_REPEAT:
+      if ( node.param0 == 0u )
+      {
+        throw smt2_parse_error( f.line, "invalid repeat count" );
+      }
+      return args[0u].width * node.param0;
+    case Z3_OP_ROTATE_LEFT:
+    case Z3_OP_ROTATE_RIGHT:
+      return args[0u].width;
+    default:
+      /* unary and binary bit-vector operators */
+      if ( args[0u].width == 0u )
+      {
+        throw smt2_parse_error( f.line, "expected bit-vector argument for " + f.name );
+      }
+      for ( const auto& a : args )
+      {
+        check_width( a, args[0u].width, f.name );
+      }
+      return args[0u].width;
+    }
+  }
+
+  result_type convert( const operator_node& node, const term& lhs, const term& rhs )
+  {
+    argument_refs< result_type > values;
+    values.push_back( lhs.value );
+    values.push_back( rhs.value );
+    return convert_application( solver, node, values );
+  }
+
+  static term make_term( const result_type& value, unsigned width )
+  {
+    term r;
+    r.value = value;
+    r.width = width;
+    return r;
+  }
+
+  Solver& solver;
+  smt2_lexer lex;
+
+  std::unordered_map< std::string, term > globals;
+  std::unordered_map< std::string, std::vector< binding > > scoped;
+  std::unordered_map< std::string, macro > macros;
+  unsigned macro_level;
+  unsigned num_assertions;
+};
+
+/**
+ * Parses `filename' with smt2_qfbv_parser and asserts its assertions
+ * in `solver'.  Returns false and prints the error on failure.
+ */
+template < typename Solver >
+bool parse_smt2_qfbv( Solver& solver, const std::string& filename )
+{
+  std::ifstream is( filename.c_str() );
+  if ( !is )
+  {
+    std::cerr << "[e] cannot open " << filename << '\n';
+    return false;
+  }
+
+  try
+  {
+    smt2_qfbv_parser< Solver > parser( solver, is );
+    parser.parse();
+  }
+  catch ( const smt2_parse_error& e )
+  {
+    std::cerr << "[e] " << filename << ": " << e.what() << '\n';
+    return false;
+  }
+  return true;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
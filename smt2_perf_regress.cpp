@@ -0,0 +1,300 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perf_regression.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+struct perf_options
+{
+  perf_options()
+    : repetitions( 5u )
+    , warm_up( 1u )
+    , timeout( 0u )
+  {}
+
+  std::string config;
+  unsigned repetitions;
+  unsigned warm_up;
+  unsigned timeout;
+  std::string csv;
+  std::string json;
+  std::string baseline;
+  perf_thresholds thresholds;
+};
+
+bool parse_number( const std::string& s, double& value )
+{
+  if ( s.empty() )
+  {
+    return false;
+  }
+  char *end = 0;
+  value = std::strtod( s.c_str(), &end );
+  return *end == '\0' && value >= 0.0;
+}
+
+bool parse_number( const std::string& s, unsigned& value )
+{
+  double v;
+  if ( !parse_number( s, v ) || v != static_cast< unsigned >( v ) )
+  {
+    return false;
+  }
+  value = static_cast< unsigned >( v );
+  return true;
+}
+
+template < typename T >
+bool parse_value( int argc, char *argv[], int& i, T& value )
+{
+  const std::string arg = argv[i];
+  if ( i+1 >= argc || !parse_number( argv[++i], value ) )
+  {
+    std::cerr << "[e] " << arg << " expects a number\n";
+    return false;
+  }
+  return true;
+}
+
+bool parse_perf_options( int argc, char *argv[], perf_options& options )
+{
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string arg = argv[i];
+    double percent;
+    if ( arg == "--repetitions" )
+    {
+      if ( !parse_value( argc, argv, i, options.repetitions ) )
+      {
+        return false;
+      }
+    }
+    else if ( arg == "--warm-up" )
+    {
+      if ( !parse_value( argc, argv, i, options.warm_up ) )
+      {
+        return false;
+      }
+    }
+    else if ( arg == "--timeout" )
+    {
+      if ( !parse_value( argc, argv, i, options.timeout ) )
+      {
+        return false;
+      }
+    }
+    else if ( arg == "--alpha" )
+    {
+      if ( !parse_value( argc, argv, i, options.thresholds.alpha ) )
+      {
+        return false;
+      }
+    }
+    else if ( arg == "--slowdown" )
+    {
+      if ( !parse_value( argc, argv, i, percent ) )
+      {
+        return false;
+      }
+      options.thresholds.slowdown = percent / 100.0;
+    }
+    else if ( arg == "--min-delta" )
+    {
+      if ( !parse_value( argc, argv, i, options.thresholds.min_delta ) )
+      {
+        return false;
+      }
+    }
+    else if ( arg == "--cpu" )
+    {
+      options.thresholds.cpu = true;
+    }
+    else if ( ( arg == "--csv" || arg == "--json" || arg == "--baseline" ) && i+1 < argc )
+    {
+      ( arg == "--csv" ? options.csv : ( arg == "--json" ? options.json : options.baseline ) ) = argv[++i];
+    }
+    else if ( arg.size() > 1u && arg[0] == '-' )
+    {
+      std::cerr << "[e] unknown option " << arg << '\n';
+      return false;
+    }
+    else if ( options.config.empty() )
+    {
+      options.config = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !options.config.empty() && options.repetitions > 0u;
+}
+
+void print_perf_usage( const char *program )
+{
+  std::cerr << "Usage: " << program << " [options] <config>\n"
+            << "Options:\n"
+            << "  --repetitions <n>  measured runs per backend and instance (default: 5)\n"
+            << "  --warm-up <n>      unmeasured runs before the first repetition (default: 1)\n"
+            << "  --timeout <s>      kill a run after <s> seconds\n"
+            << "  --csv <file>       write the samples as CSV, usable as --baseline\n"
+            << "  --json <file>      write the samples as JSON\n"
+            << "  --baseline <file>  compare with the samples of an earlier --csv run\n"
+            << "  --cpu              compare CPU instead of wall-clock seconds\n"
+            << "  --alpha <p>        significance level of the U test (default: 0.01)\n"
+            << "  --slowdown <pct>   minimal relative change of the medians (default: 5)\n"
+            << "  --min-delta <s>    minimal absolute change of the medians (default: 0.05)\n";
+}
+
+bool write_file( const std::string& filename, const std::vector< perf_sample >& samples, bool json )
+{
+  std::ofstream os( filename.c_str() );
+  if ( !os )
+  {
+    std::cerr << "[e] cannot write " << filename << '\n';
+    return false;
+  }
+  if ( json )
+  {
+    write_perf_json( os, samples );
+  }
+  else
+  {
+    write_perf_csv( os, samples );
+  }
+  return true;
+}
+
+std::string describe_code( int code )
+{
+  return code == -1 ? "timeout" : "exit status " + std::to_string( code );
+}
+
+}
+
+/*
+ * Runs every configured backend on every instance, writes the samples
+ * and reports the significant changes against a baseline.  Returns 0
+ * unless a run could not be started, a regression was found or an
+ * answer changed.
+ */
+int main( int argc, char *argv[] )
+{
+  perf_options options;
+  perf_config config;
+  if ( !parse_perf_options( argc, argv, options ) )
+  {
+    print_perf_usage( argv[0] );
+    return -1;
+  }
+  if ( !read_perf_config( options.config, config ) )
+  {
+    return -1;
+  }
+
+  std::vector< perf_sample > baseline;
+  if ( !options.baseline.empty() && !read_perf_csv( options.baseline, baseline ) )
+  {
+    return -1;
+  }
+
+  /*** Warm up file caches and the dynamic loader ***/
+  for ( unsigned r = 0u; r < options.warm_up; ++r )
+  {
+    for ( const auto& b : config.backends )
+    {
+      for ( const auto& instance : config.instances )
+      {
+        run_perf_sample( b, instance, options.timeout );
+      }
+    }
+  }
+
+  /*** Repetitions in the outer loop spread drift over all instances ***/
+  std::vector< perf_sample > samples;
+  for ( unsigned r = 0u; r < options.repetitions; ++r )
+  {
+    std::cout << "[i] repetition " << ( r + 1u ) << " of " << options.repetitions << '\n';
+    for ( const auto& b : config.backends )
+    {
+      for ( const auto& instance : config.instances )
+      {
+        samples.push_back( run_perf_sample( b, instance, options.timeout ) );
+        samples.back().repetition = r;
+        if ( samples.back().code == -1 || samples.back().code == 127 )
+        {
+          std::cerr << "[e] cannot run " << b.command.front() << '\n';
+          return -1;
+        }
+      }
+    }
+  }
+
+  if ( ( !options.csv.empty() && !write_file( options.csv, samples, false ) ) ||
+       ( !options.json.empty() && !write_file( options.json, samples, true ) ) )
+  {
+    return -1;
+  }
+
+  /*** Per-instance report ***/
+  unsigned regressions = 0u, improvements = 0u, changed = 0u;
+  for ( const auto& c : compare_perf( baseline, samples, options.thresholds ) )
+  {
+    const std::string name = c.backend + " " + c.instance;
+    switch ( c.verdict )
+    {
+    case perf_comparison::no_baseline:
+      std::cout << "[i] " << name << ": " << c.current_median << " s, " << describe_code( c.current_code ) << '\n';
+      break;
+    case perf_comparison::answer_changed:
+      std::cout << "[e] " << name << ": " << describe_code( c.baseline_code ) << " -> " << describe_code( c.current_code ) << '\n';
+      ++changed;
+      break;
+    default:
+    {
+      const double percent = c.baseline_median > 0.0 ? 100.0 * ( c.current_median - c.baseline_median ) / c.baseline_median : 0.0;
+      std::cout << ( c.verdict == perf_comparison::regression ? "[e] " : "[i] " ) << name << ": "
+                << c.baseline_median << " s -> " << c.current_median << " s (" << ( percent >= 0.0 ? "+" : "" ) << percent
+                << "%, p = " << c.p_value << ")"
+                << ( c.verdict == perf_comparison::regression ? ", regression" : ( c.verdict == perf_comparison::improvement ? ", improvement" : "" ) )
+                << '\n';
+      regressions += ( c.verdict == perf_comparison::regression );
+      improvements += ( c.verdict == perf_comparison::improvement );
+      break;
+    }
+    }
+  }
+
+  if ( !baseline.empty() )
+  {
+    std::cout << "[i] perf: " << regressions << " regressions, " << improvements << " improvements, "
+              << changed << " changed answers\n";
+  }
+  return regressions + changed == 0u ? 0 : -1;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -15,11 +15,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define SMT2EVAL_HAVE_Boolector
+#include "backends.hpp"
 #include "sat_check.hpp"
-#include <metaSMT/DirectSolver_Context.hpp>
-#include <metaSMT/backend/Boolector.hpp>
 
-using Solver = metaSMT::DirectSolver_Context< metaSMT::solver::Boolector >;
+using Solver = backends::Boolector;
 
 int main( int argc, char *argv[] )
 {
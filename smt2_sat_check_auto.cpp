@@ -0,0 +1,106 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend_model.hpp"
+#include "backend_registry.hpp"
+#include "instance_features.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+std::string model_filename( const checker_options& options )
+{
+  if ( !options.model.empty() )
+  {
+    return options.model;
+  }
+  const char *env = std::getenv( "SMT2EVAL_AUTO_MODEL" );
+  return env ? env : "smt2eval_auto.model";
+}
+
+}
+
+int main( int argc, char *argv[] )
+{
+  checker_options options;
+  if ( !parse_checker_options( argc, argv, options ) )
+  {
+    print_checker_usage( argv[0] );
+    return -1;
+  }
+
+  if ( options.cube_and_conquer || !options.export_dimacs.empty() || options.native_parser || options.low_memory || options.batch || options.pipeline || !options.minimize.empty() || options.polarity || options.counters )
+  {
+    std::cerr << "[e] smt2_sat_check_auto does not support --cube-and-conquer, --export-dimacs, --native-parser, --low-memory, --batch, --pipeline, --minimize, --polarity or --counters\n";
+    return -1;
+  }
+
+  /* without a model file every instance goes to Z3 */
+  const std::string filename = model_filename( options );
+  const bool have_model = std::ifstream( filename.c_str() ).good();
+  backend_model model;
+  if ( !have_model )
+  {
+    std::cerr << "[i] no backend model " << filename << ", using Z3\n";
+  }
+  else if ( !model.load( filename ) )
+  {
+    return -1;
+  }
+
+  /*** Parse SMT-LIB2 instance or snapshot ***/
+  z3::context ctx;
+  const z3::expr instance = load_instance( ctx, options.filename );
+  if ( options.simulate > 0u && find_model_by_simulation( instance, options ) )
+  {
+    return 1;
+  }
+
+  /*** Select the backend with the highest score, Z3 by default ***/
+  const std::vector< backend_entry > entries = available_backends();
+  std::vector< std::string > candidates;
+  for ( const auto& e : entries )
+  {
+    candidates.push_back( e.name );
+  }
+  const std::string selected = have_model ? model.select( extract_features( instance ), candidates ) : std::string();
+
+  const backend_entry *backend = &entries.front();
+  for ( const auto& e : entries )
+  {
+    if ( e.name == selected )
+    {
+      backend = &e;
+    }
+  }
+  if ( options.stats )
+  {
+    std::cout << "[i] backend: " << backend->name << '\n';
+  }
+
+  return backend->check( instance, options ) ? 1 : 0;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,86 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "snapshot.hpp"
+#include "z3_utils.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+
+double elapsed_ms( const std::chrono::steady_clock::time_point& start )
+{
+  return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+}
+
+}
+
+int main( int argc, char *argv[] )
+{
+  if ( argc != 3 )
+  {
+    std::cerr << "Usage: " << argv[0] << " <filename> <snapshot>\n";
+    return -1;
+  }
+
+  const std::string filename = argv[1];
+  const std::string snapshot = argv[2];
+
+  z3::context ctx;
+  auto start = std::chrono::steady_clock::now();
+  const z3::expr instance = load_instance( ctx, filename );
+  std::cout << "[i] parse:  " << elapsed_ms( start ) << " ms\n";
+
+  start = std::chrono::steady_clock::now();
+  if ( !write_snapshot( instance, snapshot ) )
+  {
+    std::cerr << "[e] cannot write snapshot " << snapshot << '\n';
+    return -1;
+  }
+  std::cout << "[i] write:  " << elapsed_ms( start ) << " ms\n";
+
+  {
+    z3::context fresh;
+    start = std::chrono::steady_clock::now();
+    read_snapshot( fresh, snapshot );
+    std::cout << "[i] reload: " << elapsed_ms( start ) << " ms\n";
+  }
+
+  /* Z3 shares structurally equal terms, hence reloading into the same
+     context reproduces the very same AST unless an operator had to be
+     rebuilt from other operators (e.g. bvcomp) */
+  const z3::expr reloaded = read_snapshot( ctx, snapshot );
+  if ( z3_expr_id( reloaded ) != z3_expr_id( instance ) )
+  {
+    z3::solver s( ctx );
+    s.add( instance != reloaded );
+    if ( s.check() != z3::unsat )
+    {
+      std::cerr << "[e] reloaded snapshot differs from the instance\n";
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,462 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "snapshot.hpp"
+#include "conversion_utils.hpp"
+#include "z3_utils.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+const char snapshot_magic[8] = { 'S', 'M', 'T', '2', 'S', 'N', 'A', 'P' };
+const uint32_t snapshot_version = 1u;
+
+unsigned sort_width( const z3::sort& s )
+{
+  return s.is_bool() ? 0u : s.bv_size();
+}
+
+z3::sort width_sort( z3::context& ctx, unsigned width )
+{
+  return width == 0u ? ctx.bool_sort() : ctx.bv_sort( width );
+}
+
+/**
+ * Z3 accepts n-ary applications of associative operators, the C API
+ * only offers binary constructors for most of them.  For operators
+ * over a single sort, the declaration of a binary application is
+ * reused to rebuild the n-ary term as it was parsed, all others are
+ * folded to the left.
+ */
+typedef Z3_ast (*binary_mk)( Z3_context, Z3_ast, Z3_ast );
+
+bool is_flat_associative( Z3_decl_kind kind )
+{
+  return kind == Z3_OP_BADD || kind == Z3_OP_BMUL || kind == Z3_OP_BAND || kind == Z3_OP_BOR || kind == Z3_OP_BXOR;
+}
+
+Z3_ast make_nary( z3::context& ctx, Z3_decl_kind kind, binary_mk mk, const std::vector< Z3_ast >& args )
+{
+  if ( args.size() > 2u && is_flat_associative( kind ) )
+  {
+    const z3::expr binary( ctx, mk( ctx, args[0], args[1] ) );
+    return Z3_mk_app( ctx, Z3_get_app_decl( ctx, Z3_to_app( ctx, binary ) ), args.size(), &args[0] );
+  }
+
+  Z3_ast r = args[0];
+  for ( unsigned i = 1u; i < args.size(); ++i )
+  {
+    r = mk( ctx, r, args[i] );
+  }
+  return r;
+}
+
+binary_mk binary_constructor( Z3_decl_kind kind )
+{
+  switch ( kind )
+  {
+  case Z3_OP_EQ:      return Z3_mk_eq;
+  case Z3_OP_IFF:     return Z3_mk_iff;
+  case Z3_OP_XOR:     return Z3_mk_xor;
+  case Z3_OP_IMPLIES: return Z3_mk_implies;
+  case Z3_OP_BADD:    return Z3_mk_bvadd;
+  case Z3_OP_BSUB:    return Z3_mk_bvsub;
+  case Z3_OP_BMUL:    return Z3_mk_bvmul;
+  case Z3_OP_BSDIV:   return Z3_mk_bvsdiv;
+  case Z3_OP_BUDIV:   return Z3_mk_bvudiv;
+  case Z3_OP_BSREM:   return Z3_mk_bvsrem;
+  case Z3_OP_BUREM:   return Z3_mk_bvurem;
+  case Z3_OP_BSMOD:   return Z3_mk_bvsmod;
+  case Z3_OP_ULEQ:    return Z3_mk_bvule;
+  case Z3_OP_SLEQ:    return Z3_mk_bvsle;
+  case Z3_OP_UGEQ:    return Z3_mk_bvuge;
+  case Z3_OP_SGEQ:    return Z3_mk_bvsge;
+  case Z3_OP_ULT:     return Z3_mk_bvult;
+  case Z3_OP_SLT:     return Z3_mk_bvslt;
+  case Z3_OP_UGT:     return Z3_mk_bvugt;
+  case Z3_OP_SGT:     return Z3_mk_bvsgt;
+  case Z3_OP_BAND:    return Z3_mk_bvand;
+  case Z3_OP_BOR:     return Z3_mk_bvor;
+  case Z3_OP_BXOR:    return Z3_mk_bvxor;
+  case Z3_OP_BNAND:   return Z3_mk_bvnand;
+  case Z3_OP_BNOR:    return Z3_mk_bvnor;
+  case Z3_OP_BXNOR:   return Z3_mk_bvxnor;
+  case Z3_OP_CONCAT:  return Z3_mk_concat;
+  case Z3_OP_BSHL:    return Z3_mk_bvshl;
+  case Z3_OP_BLSHR:   return Z3_mk_bvlshr;
+  case Z3_OP_BASHR:   return Z3_mk_bvashr;
+  case Z3_OP_EXT_ROTATE_LEFT:  return Z3_mk_ext_rotate_left;
+  case Z3_OP_EXT_ROTATE_RIGHT: return Z3_mk_ext_rotate_right;
+  default: return 0;
+  }
+}
+
+/* whether make_node can build `kind' from `num_args' arguments */
+bool valid_arity( Z3_decl_kind kind, uint32_t num_args )
+{
+  if ( binary_constructor( kind ) )
+  {
+    return num_args >= 2u;
+  }
+
+  switch ( kind )
+  {
+  case Z3_OP_TRUE:
+  case Z3_OP_FALSE:
+  case Z3_OP_BNUM:
+  case Z3_OP_UNINTERPRETED:
+    return num_args == 0u;
+  case Z3_OP_AND:
+  case Z3_OP_OR:
+    return num_args >= 1u;
+  case Z3_OP_DISTINCT:
+    return num_args >= 2u;
+  case Z3_OP_ITE:
+    return num_args == 3u;
+  case Z3_OP_BCOMP:
+    return num_args == 2u;
+  case Z3_OP_NOT:
+  case Z3_OP_BNEG:
+  case Z3_OP_BNOT:
+  case Z3_OP_BREDOR:
+  case Z3_OP_BREDAND:
+  case Z3_OP_SIGN_EXT:
+  case Z3_OP_ZERO_EXT:
+  case Z3_OP_REPEAT:
+  case Z3_OP_EXTRACT:
+  case Z3_OP_ROTATE_LEFT:
+  case Z3_OP_ROTATE_RIGHT:
+    return num_args == 1u;
+  default:
+    return false;
+  }
+}
+
+Z3_ast make_numeral( z3::context& ctx, const std::string& bits )
+{
+  const z3::sort s = ctx.bv_sort( bits.size() );
+  if ( bits.size() <= 64u )
+  {
+    uint64_t v = 0u;
+    for ( const char b : bits )
+    {
+      v = ( v << 1u ) | ( b == '1' ? 1u : 0u );
+    }
+    return Z3_mk_unsigned_int64( ctx, v, s );
+  }
+  return Z3_mk_numeral( ctx, convert_bin2dec( bits ).c_str(), s );
+}
+
+Z3_ast make_node( z3::context& ctx, const snapshot_view& view, const snapshot_node& n, const std::vector< Z3_ast >& args )
+{
+  const Z3_decl_kind kind = static_cast< Z3_decl_kind >( n.kind );
+
+  if ( const binary_mk mk = binary_constructor( kind ) )
+  {
+    return make_nary( ctx, kind, mk, args );
+  }
+
+  switch ( kind )
+  {
+  case Z3_OP_TRUE:        return Z3_mk_true( ctx );
+  case Z3_OP_FALSE:       return Z3_mk_false( ctx );
+  case Z3_OP_BNUM:        return make_numeral( ctx, view.pool_string( n ) );
+  case Z3_OP_UNINTERPRETED:
+    {
+      const std::string name = view.pool_string( n );
+      return Z3_mk_const( ctx, Z3_mk_string_symbol( ctx, name.c_str() ), width_sort( ctx, n.width ) );
+    }
+  case Z3_OP_DISTINCT:    return Z3_mk_distinct( ctx, args.size(), &args[0] );
+  case Z3_OP_AND:         return Z3_mk_and( ctx, args.size(), &args[0] );
+  case Z3_OP_OR:          return Z3_mk_or( ctx, args.size(), &args[0] );
+  case Z3_OP_ITE:         return Z3_mk_ite( ctx, args[0], args[1], args[2] );
+  case Z3_OP_NOT:         return Z3_mk_not( ctx, args[0] );
+  case Z3_OP_BNEG:        return Z3_mk_bvneg( ctx, args[0] );
+  case Z3_OP_BNOT:        return Z3_mk_bvnot( ctx, args[0] );
+  case Z3_OP_BREDOR:      return Z3_mk_bvredor( ctx, args[0] );
+  case Z3_OP_BREDAND:     return Z3_mk_bvredand( ctx, args[0] );
+  case Z3_OP_SIGN_EXT:    return Z3_mk_sign_ext( ctx, n.param0, args[0] );
+  case Z3_OP_ZERO_EXT:    return Z3_mk_zero_ext( ctx, n.param0, args[0] );
+  case Z3_OP_REPEAT:      return Z3_mk_repeat( ctx, n.param0, args[0] );
+  case Z3_OP_EXTRACT:     return Z3_mk_extract( ctx, n.param0, n.param1, args[0] );
+  case Z3_OP_ROTATE_LEFT:  return Z3_mk_rotate_left( ctx, n.param0, args[0] );
+  case Z3_OP_ROTATE_RIGHT: return Z3_mk_rotate_right( ctx, n.param0, args[0] );
+  case Z3_OP_BCOMP:
+    {
+      /* intermediate terms need a reference until they are used */
+      const z3::expr eq( ctx, Z3_mk_eq( ctx, args[0], args[1] ) );
+      return Z3_mk_ite( ctx, eq, ctx.bv_val( 1, 1u ), ctx.bv_val( 0, 1u ) );
+    }
+  default:
+    break;
+  }
+
+  std::cerr << "[e] read_snapshot: does not support operator [ " << std::hex << kind << std::dec << "]\n";
+  throw z3::exception( "unsupported operator in snapshot" );
+}
+
+/**
+ * Plain ASTs with a reference each; cheaper than z3::expr_vector.
+ */
+struct ast_references : public std::vector< Z3_ast >
+{
+  explicit ast_references( z3::context& ctx )
+    : ctx( ctx )
+  {}
+
+  ~ast_references()
+  {
+    for ( const Z3_ast a : *this )
+    {
+      Z3_dec_ref( ctx, a );
+    }
+  }
+
+  void push_back( Z3_ast a )
+  {
+    Z3_inc_ref( ctx, a );
+    std::vector< Z3_ast >::push_back( a );
+  }
+
+  z3::context& ctx;
+};
+
+}
+
+bool is_snapshot_file( const std::string& filename )
+{
+  std::ifstream is( filename.c_str(), std::ios::binary );
+  char magic[8];
+  return is.read( magic, sizeof( magic ) ) && std::memcmp( magic, snapshot_magic, sizeof( magic ) ) == 0;
+}
+
+bool write_snapshot( const z3::expr& instance, const std::string& filename )
+{
+  std::vector< snapshot_node > nodes;
+  std::vector< uint32_t > args;
+  std::string pool;
+  std::unordered_map< unsigned, uint32_t > index;
+
+  /*** post-order traversal, arguments are written before their parents ***/
+  std::vector< std::pair< z3::expr, bool > > stack( 1u, std::make_pair( instance, false ) );
+  while ( !stack.empty() )
+  {
+    const z3::expr e = stack.back().first;
+    const bool expanded = stack.back().second;
+    stack.pop_back();
+
+    const unsigned id = z3_expr_id( e );
+    if ( index.find( id ) != index.end() )
+    {
+      continue;
+    }
+    if ( !e.is_app() )
+    {
+      std::cerr << "[e] write_snapshot: quantifiers and bound variables are not supported\n";
+      return false;
+    }
+    if ( !e.get_sort().is_bool() && !e.get_sort().is_bv() )
+    {
+      std::cerr << "[e] write_snapshot: only Boolean and bit-vector sorts are supported\n";
+      return false;
+    }
+    if ( !expanded && e.num_args() > 0u )
+    {
+      stack.push_back( std::make_pair( e, true ) );
+      for ( unsigned i = e.num_args(); i > 0u; --i )
+      {
+        stack.push_back( std::make_pair( e.arg( i-1u ), false ) );
+      }
+      continue;
+    }
+
+    const z3::func_decl decl = e.decl();
+    snapshot_node n;
+    n.kind = decl.decl_kind();
+    n.width = sort_width( e.get_sort() );
+    n.param0 = n.param1 = 0u;
+    n.first_arg = args.size();
+    n.num_args = e.num_args();
+
+    if ( n.kind == Z3_OP_BNUM || n.kind == Z3_OP_UNINTERPRETED )
+    {
+      if ( n.num_args > 0u )
+      {
+        std::cerr << "[e] write_snapshot: uninterpreted functions are not supported\n";
+        return false;
+      }
+      const std::string s = ( n.kind == Z3_OP_BNUM ) ? expr_to_bin( e ) : decl.name().str();
+      n.param0 = pool.size();
+      n.param1 = s.size();
+      pool += s;
+    }
+    else if ( decl_num_parameters( e ) > 0u )
+    {
+      n.param0 = decl_int_parameter( e, 0u );
+      if ( decl_num_parameters( e ) > 1u )
+      {
+        n.param1 = decl_int_parameter( e, 1u );
+      }
+    }
+
+    for ( unsigned i = 0u; i < e.num_args(); ++i )
+    {
+      args.push_back( index[ z3_expr_id( e.arg( i ) ) ] );
+    }
+    index.insert( std::make_pair( id, static_cast< uint32_t >( nodes.size() ) ) );
+    nodes.push_back( n );
+  }
+
+  pool.resize( ( pool.size() + 3u ) & ~3u, '\0' );
+
+  snapshot_header h;
+  std::memcpy( h.magic, snapshot_magic, sizeof( h.magic ) );
+  h.version = snapshot_version;
+  h.num_nodes = nodes.size();
+  h.num_args = args.size();
+  h.pool_size = pool.size();
+  h.root = index[ z3_expr_id( instance ) ];
+  h.reserved = 0u;
+
+  std::ofstream os( filename.c_str(), std::ios::binary );
+  os.write( reinterpret_cast< const char* >( &h ), sizeof( h ) );
+  os.write( reinterpret_cast< const char* >( nodes.data() ), nodes.size() * sizeof( snapshot_node ) );
+  os.write( reinterpret_cast< const char* >( args.data() ), args.size() * sizeof( uint32_t ) );
+  os.write( pool.data(), pool.size() );
+  return os.good();
+}
+
+snapshot_view::snapshot_view( const std::string& filename )
+  : data( 0 )
+  , size( 0u )
+{
+  const int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+  {
+    throw z3::exception( "cannot read snapshot" );
+  }
+  struct stat st;
+  if ( fstat( fd, &st ) == 0 && static_cast< std::size_t >( st.st_size ) >= sizeof( snapshot_header ) )
+  {
+    void *p = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( p != MAP_FAILED )
+    {
+      data = p;
+      size = st.st_size;
+    }
+  }
+  close( fd );
+  if ( !data )
+  {
+    throw z3::exception( "cannot read snapshot" );
+  }
+
+  /* the header is only read once the file is known to hold one, the
+     tables only once their sizes match the file */
+  const char *base = static_cast< const char* >( data );
+  h = reinterpret_cast< const snapshot_header* >( base );
+  bool valid = size >= sizeof( snapshot_header ) && std::memcmp( h->magic, snapshot_magic, sizeof( h->magic ) ) == 0 &&
+               h->version == snapshot_version;
+  if ( valid )
+  {
+    const std::size_t expected = sizeof( snapshot_header ) + std::size_t( h->num_nodes ) * sizeof( snapshot_node ) +
+                                 std::size_t( h->num_args ) * sizeof( uint32_t ) + h->pool_size;
+    valid = expected == size && h->root < h->num_nodes;
+  }
+  if ( valid )
+  {
+    nodes = reinterpret_cast< const snapshot_node* >( base + sizeof( snapshot_header ) );
+    args = reinterpret_cast< const uint32_t* >( nodes + h->num_nodes );
+    pool = reinterpret_cast< const char* >( args + h->num_args );
+  }
+
+  /* arguments refer to earlier nodes only, hence nodes can be
+     processed in file order */
+  for ( uint32_t i = 0u; valid && i < h->num_nodes; ++i )
+  {
+    const snapshot_node& n = nodes[i];
+    valid = std::size_t( n.first_arg ) + n.num_args <= h->num_args && valid_arity( static_cast< Z3_decl_kind >( n.kind ), n.num_args );
+    for ( uint32_t j = 0u; valid && j < n.num_args; ++j )
+    {
+      valid = args[n.first_arg + j] < i;
+    }
+    if ( valid && ( n.kind == Z3_OP_BNUM || n.kind == Z3_OP_UNINTERPRETED ) )
+    {
+      valid = std::size_t( n.param0 ) + n.param1 <= h->pool_size;
+    }
+  }
+  if ( !valid )
+  {
+    munmap( data, size );
+    throw z3::exception( "invalid snapshot" );
+  }
+}
+
+snapshot_view::~snapshot_view()
+{
+  munmap( data, size );
+}
+
+z3::expr read_snapshot( z3::context& ctx, const std::string& filename )
+{
+  const snapshot_view view( filename );
+  const snapshot_header& h = view.header();
+
+  /* every node keeps a reference until the root is built */
+  ast_references asts( ctx );
+  asts.reserve( h.num_nodes );
+  std::vector< Z3_ast > node_args;
+  for ( uint32_t i = 0u; i < h.num_nodes; ++i )
+  {
+    const snapshot_node& n = view.node( i );
+    node_args.clear();
+    for ( uint32_t j = 0u; j < n.num_args; ++j )
+    {
+      node_args.push_back( asts[ view.arg( n, j ) ] );
+    }
+    asts.push_back( make_node( ctx, view, n, node_args ) );
+  }
+
+  return z3::expr( ctx, asts[ h.root ] );
+}
+
+z3::expr load_instance( z3::context& ctx, const std::string& filename )
+{
+  if ( is_snapshot_file( filename ) )
+  {
+    return read_snapshot( ctx, filename );
+  }
+  const Z3_ast ast = Z3_parse_smtlib2_file( ctx, filename.c_str(), 0, 0, 0, 0, 0, 0 );
+  return z3::expr( ctx, ast );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
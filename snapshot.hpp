@@ -0,0 +1,109 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snapshot.hpp
+ *
+ * @brief compact binary snapshot of parsed SMT-LIB2 instances
+ *
+ * A snapshot stores the DAG of a parsed instance in topological order
+ * (host byte order, 4-byte aligned):
+ *
+ *   snapshot_header
+ *   snapshot_node[num_nodes]
+ *   uint32_t args[num_args]     argument indices into the node table
+ *   char pool[pool_size]        numerals and variable names
+ *
+ * Numerals (as binary strings, most significant bit first) and
+ * variable names reference the pool by offset (param0) and length
+ * (param1).  Width 0 denotes the Boolean sort.  The file is used in
+ * place after mmap, no parsing is needed to reload it.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <z3++.h>
+
+#include <cstdint>
+#include <string>
+
+#pragma once
+
+struct snapshot_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t num_nodes;
+  uint32_t num_args;
+  uint32_t pool_size;
+  uint32_t root;
+  uint32_t reserved;
+};
+
+struct snapshot_node
+{
+  uint32_t kind;      /* Z3_decl_kind */
+  uint32_t width;
+  uint32_t param0;
+  uint32_t param1;
+  uint32_t first_arg;
+  uint32_t num_args;
+};
+
+/**
+ * Validated read-only view of a memory mapped snapshot.  The
+ * constructor throws a z3::exception if the file is not a snapshot
+ * or is inconsistent.
+ */
+class snapshot_view
+{
+public:
+  explicit snapshot_view( const std::string& filename );
+  ~snapshot_view();
+
+  snapshot_view( const snapshot_view& ) = delete;
+  snapshot_view& operator=( const snapshot_view& ) = delete;
+
+  const snapshot_header& header() const { return *h; }
+  const snapshot_node& node( uint32_t i ) const { return nodes[i]; }
+  uint32_t arg( const snapshot_node& n, uint32_t j ) const { return args[n.first_arg + j]; }
+  std::string pool_string( const snapshot_node& n ) const { return std::string( pool + n.param0, n.param1 ); }
+
+private:
+  void *data;
+  std::size_t size;
+  const snapshot_header *h;
+  const snapshot_node *nodes;
+  const uint32_t *args;
+  const char *pool;
+};
+
+bool is_snapshot_file( const std::string& filename );
+bool write_snapshot( const z3::expr& instance, const std::string& filename );
+z3::expr read_snapshot( z3::context& ctx, const std::string& filename );
+
+/**
+ * Reads an instance either from a snapshot or from an SMT-LIB2 file.
+ */
+z3::expr load_instance( z3::context& ctx, const std::string& filename );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
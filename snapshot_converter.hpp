@@ -0,0 +1,109 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snapshot_converter.hpp
+ *
+ * @brief convert a snapshot to metaSMT without building a Z3 AST
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include "operator_conversion.hpp"
+#include "snapshot.hpp"
+
+#include <vector>
+
+#pragma once
+
+/**
+ * Nodes are stored in topological order, hence a single pass over the
+ * node table converts the whole instance.  Variables are created
+ * exactly as result_type_generator creates them.
+ */
+template < typename Solver >
+typename Solver::result_type convert_snapshot( Solver& solver, const std::string& filename )
+{
+  using namespace metaSMT;
+  using namespace metaSMT::logic;
+  using namespace metaSMT::logic::QF_BV;
+  using result_type = typename Solver::result_type;
+
+  const snapshot_view view( filename );
+  const snapshot_header& h = view.header();
+
+  std::vector< result_type > results;
+  results.reserve( h.root + 1u );
+  argument_refs< result_type > args;
+  for ( uint32_t i = 0u; i <= h.root; ++i )
+  {
+    const snapshot_node& n = view.node( i );
+    switch ( n.kind )
+    {
+    case Z3_OP_TRUE:
+      results.push_back( evaluate( solver, True ) );
+      break;
+    case Z3_OP_FALSE:
+      results.push_back( evaluate( solver, False ) );
+      break;
+    case Z3_OP_BNUM:
+      results.push_back( evaluate( solver, bvbin( view.pool_string( n ) ) ) );
+      break;
+    case Z3_OP_UNINTERPRETED:
+      if ( n.width == 0u )
+      {
+        results.push_back( evaluate( solver, new_variable() ) );
+      }
+      else
+      {
+        results.push_back( evaluate( solver, new_bitvector( n.width ) ) );
+      }
+      break;
+    default:
+      {
+        args.clear();
+        for ( uint32_t j = 0u; j < n.num_args; ++j )
+        {
+          args.push_back( results[ view.arg( n, j ) ] );
+        }
+        operator_node node;
+        node.kind = static_cast< Z3_decl_kind >( n.kind );
+        node.width = n.width;
+        node.param0 = n.param0;
+        node.param1 = n.param1;
+        if ( has_amount_argument( node.kind ) && n.num_args == 2u )
+        {
+          const snapshot_node& amount = view.node( view.arg( n, 1u ) );
+          if ( amount.kind == Z3_OP_BNUM )
+          {
+            set_constant_amount( node, view.pool_string( amount ) );
+          }
+        }
+        results.push_back( convert_application( solver, node, args ) );
+      }
+      break;
+    }
+  }
+  return results[ h.root ];
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -0,0 +1,285 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sweeping.hpp"
+#include "simulation.hpp"
+#include "z3_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+inline uint64_t mix( uint64_t h, uint64_t v )
+{
+  h ^= v + 0x9e3779b97f4a7c15ull + ( h << 6u ) + ( h >> 2u );
+  return h;
+}
+
+/* groups of at least two terms with equal sort and simulated values, children before parents */
+std::vector< std::vector< unsigned > > candidate_classes( bit_simulator& simulator )
+{
+  const std::vector< z3::expr >& terms = simulator.terms();
+  std::vector< uint64_t > signatures( terms.size() );
+  for ( unsigned i = 0u; i < terms.size(); ++i )
+  {
+    signatures[i] = mix( terms[i].get_sort().sort_kind(), terms[i].is_bv() ? terms[i].get_sort().bv_size() : 1u );
+  }
+
+  std::mt19937_64 rng( 1u );
+  for ( unsigned round = 0u; round < sweeping_rounds; ++round )
+  {
+    simulator.assign_random( rng, round );
+    simulator.run( true );
+    for ( unsigned i = 0u; i < terms.size(); ++i )
+    {
+      for ( const auto& row : simulator.value( terms[i] ) )
+      {
+        for ( unsigned w = 0u; w < simulation_words; ++w )
+        {
+          signatures[i] = mix( signatures[i], row.words[w] );
+        }
+      }
+    }
+  }
+
+  std::unordered_map< uint64_t, unsigned > class_of;
+  std::vector< std::vector< unsigned > > classes;
+  for ( unsigned i = 0u; i < terms.size(); ++i )
+  {
+    const auto it = class_of.insert( std::make_pair( signatures[i], classes.size() ) );
+    if ( it.second )
+    {
+      classes.push_back( std::vector< unsigned >() );
+    }
+    classes[it.first->second].push_back( i );
+  }
+
+  std::vector< std::vector< unsigned > > candidates;
+  for ( auto& c : classes )
+  {
+    if ( c.size() > 1u )
+    {
+      candidates.push_back( std::vector< unsigned >() );
+      candidates.back().swap( c );
+    }
+  }
+  return candidates;
+}
+
+/* rebuilds the DAG with every term replaced by its representative */
+z3::expr merge_terms( const std::vector< z3::expr >& terms, const std::vector< unsigned >& representative )
+{
+  std::unordered_map< unsigned, z3::expr > memo;
+  for ( unsigned i = 0u; i < terms.size(); ++i )
+  {
+    const z3::expr& n = terms[i];
+    if ( representative[i] != i )
+    {
+      /* representatives precede their terms in topological order */
+      memo.insert( std::make_pair( z3_expr_id( n ), memo.find( z3_expr_id( terms[representative[i]] ) )->second ) );
+      continue;
+    }
+    if ( !n.is_app() || n.num_args() == 0u )
+    {
+      memo.insert( std::make_pair( z3_expr_id( n ), n ) );
+      continue;
+    }
+
+    std::vector< z3::expr > args;
+    bool changed = false;
+    for ( unsigned j = 0u; j < n.num_args(); ++j )
+    {
+      args.push_back( memo.find( z3_expr_id( n.arg( j ) ) )->second );
+      changed = changed || z3_expr_id( args.back() ) != z3_expr_id( n.arg( j ) );
+    }
+
+    if ( !changed )
+    {
+      memo.insert( std::make_pair( z3_expr_id( n ), n ) );
+      continue;
+    }
+    std::vector< Z3_ast > asts( args.begin(), args.end() );
+    memo.insert( std::make_pair( z3_expr_id( n ), z3::expr( n.ctx(), Z3_mk_app( n.ctx(), n.decl(), asts.size(), &asts[0u] ) ) ) );
+  }
+  return memo.find( z3_expr_id( terms.back() ) )->second;
+}
+
+}
+
+z3::expr sweep_equivalences( const z3::expr& instance, sweeping_stats& stats )
+{
+  bit_simulator simulator( instance );
+  if ( !simulator.supported() )
+  {
+    return instance;
+  }
+
+  const std::vector< z3::expr >& terms = simulator.terms();
+  const std::vector< std::vector< unsigned > > classes = candidate_classes( simulator );
+
+  z3::context& ctx = instance.ctx();
+  z3::solver solver( ctx );
+  z3::params params( ctx );
+  params.set( "timeout", sweeping_query_ms );
+  solver.set( params );
+
+  std::vector< unsigned > representative( terms.size() );
+  for ( unsigned i = 0u; i < terms.size(); ++i )
+  {
+    representative[i] = i;
+  }
+  std::vector< unsigned > tries( terms.size(), 0u );
+
+  /* a group starts with its `num_representatives' representatives,
+     followed by the terms still to be checked, in topological order */
+  struct group
+  {
+    std::vector< unsigned > terms;
+    unsigned num_representatives;
+  };
+  std::vector< group > work;
+  for ( auto it = classes.rbegin(); it != classes.rend(); ++it )
+  {
+    stats.candidates += it->size();
+    const unsigned n = std::min< unsigned >( it->size(), sweeping_max_class );
+    stats.skipped += it->size() - n;
+    group g = { std::vector< unsigned >( it->begin(), it->begin() + n ), 1u };
+    work.push_back( g );
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto exhausted = [&]() {
+    return stats.queries >= sweeping_max_queries ||
+           std::chrono::steady_clock::now() - start >= std::chrono::milliseconds( sweeping_budget_ms );
+  };
+
+  while ( !work.empty() )
+  {
+    const group g = work.back();
+    work.pop_back();
+
+    std::vector< unsigned > representatives( g.terms.begin(), g.terms.begin() + g.num_representatives );
+    bool split = false;
+    for ( unsigned k = g.num_representatives; k < g.terms.size() && !split; ++k )
+    {
+      const unsigned t = g.terms[k];
+      if ( exhausted() )
+      {
+        stats.skipped += g.terms.size() - k;
+        break;
+      }
+
+      for ( const unsigned r : representatives )
+      {
+        if ( tries[t] == sweeping_max_tries )
+        {
+          break;
+        }
+
+        ++tries[t];
+        ++stats.queries;
+        solver.push();
+        solver.add( terms[t] != terms[r] );
+        const z3::check_result result = solver.check();
+        if ( result == z3::unsat )
+        {
+          solver.pop();
+          representative[t] = r;
+          ++stats.merged;
+          break;
+        }
+        else if ( result == z3::sat )
+        {
+          /* split the group by the values under the counterexample;
+             the parts are checked on their own */
+          z3::model model = solver.get_model();
+          solver.pop();
+          const unsigned value = z3_expr_id( model.eval( terms[r], true ) );
+          std::vector< unsigned > values( g.terms.size() );
+          for ( unsigned l = 0u; l < g.terms.size(); ++l )
+          {
+            values[l] = z3_expr_id( model.eval( terms[g.terms[l]], true ) );
+            stats.refuted += l > k && values[l] != value;
+          }
+
+          std::vector< group > parts;
+          std::unordered_map< unsigned, unsigned > part_of;
+          auto add = [&]( unsigned l, bool is_representative ) {
+            const auto it = part_of.insert( std::make_pair( values[l], parts.size() ) );
+            if ( it.second )
+            {
+              group part = { std::vector< unsigned >(), 0u };
+              parts.push_back( part );
+            }
+            group& part = parts[it.first->second];
+            part.terms.push_back( g.terms[l] );
+            part.num_representatives += is_representative;
+          };
+          for ( unsigned l = 0u; l < k; ++l )
+          {
+            if ( representative[g.terms[l]] == g.terms[l] )
+            {
+              add( l, true );
+            }
+          }
+          for ( unsigned l = k; l < g.terms.size(); ++l )
+          {
+            add( l, false );
+          }
+          for ( auto& part : parts )
+          {
+            if ( part.num_representatives == 0u )
+            {
+              part.num_representatives = 1u;
+            }
+            if ( part.terms.size() > part.num_representatives )
+            {
+              work.push_back( part );
+            }
+          }
+          split = true;
+          break;
+        }
+        else
+        {
+          ++stats.undecided;
+        }
+        solver.pop();
+      }
+
+      if ( !split && representative[t] == t )
+      {
+        representatives.push_back( t );
+      }
+    }
+  }
+
+  return stats.merged == 0u ? instance : merge_terms( terms, representative );
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
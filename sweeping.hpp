@@ -0,0 +1,82 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sweeping.hpp
+ *
+ * @brief merging of functionally equivalent terms (SAT sweeping)
+ *
+ * The terms of the instance are simulated on random assignments (see
+ * simulation.hpp) and grouped by sort and simulated values.  Every
+ * term of a group is compared with the earlier representatives of the
+ * group by a small incremental query (distinct t r) restricted to the
+ * cones of both terms.  Proven equivalent terms are replaced by their
+ * representative.  A counterexample splits the group by the values of
+ * its terms under the counterexample, and the parts are checked on
+ * their own.  The queries of one instance are limited in number and in
+ * total time; terms left over are counted as skipped.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <z3++.h>
+
+#pragma once
+
+struct sweeping_stats
+{
+  sweeping_stats()
+    : candidates( 0u )
+    , queries( 0u )
+    , merged( 0u )
+    , refuted( 0u )
+    , undecided( 0u )
+    , skipped( 0u )
+  {}
+
+  unsigned candidates;  /* terms in groups of two or more */
+  unsigned queries;     /* equivalence queries */
+  unsigned merged;      /* terms replaced by an equivalent term */
+  unsigned refuted;     /* candidate pairs separated by counterexamples */
+  unsigned undecided;   /* queries that hit the time limit */
+  unsigned skipped;     /* candidates not checked because of the limits below */
+};
+
+/* simulation rounds for the signatures and time limit per query */
+const unsigned sweeping_rounds = 4u;
+const unsigned sweeping_query_ms = 200u;
+
+/* at most this many representatives are tried for every term */
+const unsigned sweeping_max_tries = 3u;
+
+/* limits of one instance: queries, total time and terms per group */
+const unsigned sweeping_max_queries = 2000u;
+const unsigned sweeping_budget_ms = 10000u;
+const unsigned sweeping_max_class = 256u;
+
+/**
+ * Returns `instance' with equivalent terms merged.  Instances that
+ * cannot be simulated are returned unchanged.
+ */
+z3::expr sweep_equivalences( const z3::expr& instance, sweeping_stats& stats );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
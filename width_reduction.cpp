@@ -0,0 +1,667 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "width_reduction.hpp"
+#include "z3_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct term_info
+{
+  term_info()
+    : zeros( 0u )
+    , signs( 0u )
+    , demand( 0u )
+    , compare( 0u )
+  {}
+
+  unsigned zeros;    /* known leading zero bits */
+  unsigned signs;    /* redundant sign bits, the top signs+1 bits are equal */
+  unsigned demand;   /* demanded low bits, 1 for needed non-bit-vector terms */
+  unsigned compare;  /* width of a narrowed comparison, 0 if not narrowed */
+};
+
+unsigned width_of( const z3::expr& e )
+{
+  return e.get_sort().is_bv() ? e.get_sort().bv_size() : 0u;
+}
+
+unsigned long total_bits( const z3::expr& root )
+{
+  unsigned long bits = 0u;
+  for ( const auto& n : topological_order( root ) )
+  {
+    bits += width_of( n );
+  }
+  return bits;
+}
+
+bool is_kind( const z3::expr& e, Z3_decl_kind kind )
+{
+  return e.is_app() && e.decl().decl_kind() == kind;
+}
+
+/* shl, lshr and ashr by a constant amount */
+bool has_constant_amount( const z3::expr& e )
+{
+  return e.num_args() == 2u && is_kind( e.arg( 1u ), Z3_OP_BNUM );
+}
+
+unsigned constant_amount( const z3::expr& e )
+{
+  return bv_shift_amount( expr_to_bv_value( e.arg( 1u ) ) );
+}
+
+/* operators whose low bits only depend on the low bits of the operands */
+bool is_low_closed( Z3_decl_kind kind )
+{
+  switch ( kind )
+  {
+  case Z3_OP_BADD:
+  case Z3_OP_BSUB:
+  case Z3_OP_BMUL:
+  case Z3_OP_BNEG:
+  case Z3_OP_BAND:
+  case Z3_OP_BOR:
+  case Z3_OP_BXOR:
+  case Z3_OP_BNOT:
+  case Z3_OP_BNAND:
+  case Z3_OP_BNOR:
+  case Z3_OP_BXNOR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/******************************************************************************
+ * term construction                                                          *
+ ******************************************************************************/
+
+z3::expr make_unary( Z3_decl_kind kind, const z3::expr& a )
+{
+  z3::context& ctx = a.ctx();
+  return z3::expr( ctx, kind == Z3_OP_BNEG ? Z3_mk_bvneg( ctx, a ) : Z3_mk_bvnot( ctx, a ) );
+}
+
+z3::expr make_binary( Z3_decl_kind kind, const z3::expr& a, const z3::expr& b )
+{
+  z3::context& ctx = a.ctx();
+  Z3_ast r = 0;
+  switch ( kind )
+  {
+  case Z3_OP_BADD:   r = Z3_mk_bvadd( ctx, a, b ); break;
+  case Z3_OP_BSUB:   r = Z3_mk_bvsub( ctx, a, b ); break;
+  case Z3_OP_BMUL:   r = Z3_mk_bvmul( ctx, a, b ); break;
+  case Z3_OP_BAND:   r = Z3_mk_bvand( ctx, a, b ); break;
+  case Z3_OP_BOR:    r = Z3_mk_bvor( ctx, a, b ); break;
+  case Z3_OP_BXOR:   r = Z3_mk_bvxor( ctx, a, b ); break;
+  case Z3_OP_BNAND:  r = Z3_mk_bvnand( ctx, a, b ); break;
+  case Z3_OP_BNOR:   r = Z3_mk_bvnor( ctx, a, b ); break;
+  case Z3_OP_BXNOR:  r = Z3_mk_bvxnor( ctx, a, b ); break;
+  case Z3_OP_EQ:     r = Z3_mk_eq( ctx, a, b ); break;
+  case Z3_OP_ULEQ:   r = Z3_mk_bvule( ctx, a, b ); break;
+  case Z3_OP_ULT:    r = Z3_mk_bvult( ctx, a, b ); break;
+  case Z3_OP_UGEQ:   r = Z3_mk_bvuge( ctx, a, b ); break;
+  case Z3_OP_UGT:    r = Z3_mk_bvugt( ctx, a, b ); break;
+  case Z3_OP_SLEQ:   r = Z3_mk_bvsle( ctx, a, b ); break;
+  case Z3_OP_SLT:    r = Z3_mk_bvslt( ctx, a, b ); break;
+  case Z3_OP_SGEQ:   r = Z3_mk_bvsge( ctx, a, b ); break;
+  case Z3_OP_SGT:    r = Z3_mk_bvsgt( ctx, a, b ); break;
+  case Z3_OP_DISTINCT:
+    {
+      Z3_ast args[] = { a, b };
+      r = Z3_mk_distinct( ctx, 2u, args );
+    }
+    break;
+  default:
+    assert( false && "unexpected operator" );
+  }
+  return z3::expr( ctx, r );
+}
+
+z3::expr make_extend( Z3_decl_kind kind, const z3::expr& a, unsigned n )
+{
+  z3::context& ctx = a.ctx();
+  return z3::expr( ctx, kind == Z3_OP_ZERO_EXT ? Z3_mk_zero_ext( ctx, n, a ) : Z3_mk_sign_ext( ctx, n, a ) );
+}
+
+z3::expr make_extract( const z3::expr& a, unsigned hi, unsigned lo )
+{
+  return z3::expr( a.ctx(), Z3_mk_extract( a.ctx(), hi, lo, a ) );
+}
+
+z3::expr make_concat( const z3::expr& hi, const z3::expr& lo )
+{
+  return z3::expr( hi.ctx(), Z3_mk_concat( hi.ctx(), hi, lo ) );
+}
+
+/* the low k bits of `e', looking through extensions and concatenations */
+z3::expr truncate( const z3::expr& e, unsigned k )
+{
+  const unsigned w = width_of( e );
+  assert( k > 0u && k <= w );
+  if ( k == w )
+  {
+    return e;
+  }
+
+  switch ( e.decl().decl_kind() )
+  {
+  case Z3_OP_BNUM:
+    return bv_value_to_expr( e.ctx(), bv_extract( expr_to_bv_value( e ), k - 1u, 0u ) );
+
+  case Z3_OP_ZERO_EXT:
+  case Z3_OP_SIGN_EXT:
+    {
+      const z3::expr x = e.arg( 0u );
+      const unsigned wx = width_of( x );
+      return k <= wx ? truncate( x, k ) : make_extend( e.decl().decl_kind(), x, k - wx );
+    }
+
+  case Z3_OP_CONCAT:
+    if ( e.num_args() == 2u && k <= width_of( e.arg( 1u ) ) )
+    {
+      return truncate( e.arg( 1u ), k );
+    }
+    break;
+
+  case Z3_OP_EXTRACT:
+    return make_extract( e.arg( 0u ), lo( e ) + k - 1u, lo( e ) );
+
+  default:
+    break;
+  }
+  return make_extract( e, k - 1u, 0u );
+}
+
+/* bits hi..lo of `e' */
+z3::expr slice( const z3::expr& e, unsigned hi, unsigned lo )
+{
+  if ( lo == 0u )
+  {
+    return truncate( e, hi + 1u );
+  }
+  else if ( is_kind( e, Z3_OP_EXTRACT ) )
+  {
+    return make_extract( e.arg( 0u ), ::lo( e ) + hi, ::lo( e ) + lo );
+  }
+  return make_extract( e, hi, lo );
+}
+
+/******************************************************************************
+ * width reduction                                                            *
+ ******************************************************************************/
+
+class width_reducer
+{
+public:
+  explicit width_reducer( const z3::expr& root )
+    : root( root )
+    , order( topological_order( root ) )
+  {}
+
+  z3::expr operator()()
+  {
+    for ( const auto& n : order )
+    {
+      bound_leading_bits( n );
+    }
+
+    demand( root, std::max( 1u, width_of( root ) ) );
+    for ( unsigned i = order.size(); i > 0u; --i )
+    {
+      propagate_demand( order[i - 1u] );
+    }
+
+    for ( const auto& n : order )
+    {
+      if ( info( n ).demand > 0u )
+      {
+        low.insert( std::make_pair( z3_expr_id( n ), rebuild( n ) ) );
+      }
+    }
+    return low.find( z3_expr_id( root ) )->second;
+  }
+
+private:
+  term_info& info( const z3::expr& e )
+  {
+    return infos[z3_expr_id( e )];
+  }
+
+  void demand( const z3::expr& e, unsigned bits )
+  {
+    term_info& t = info( e );
+    t.demand = std::max( t.demand, bits );
+  }
+
+  /* the rebuilt low k bits of `e' */
+  z3::expr fit( const z3::expr& e, unsigned k ) const
+  {
+    const auto it = low.find( z3_expr_id( e ) );
+    assert( it != low.end() );
+    return width_of( e ) == 0u ? it->second : truncate( it->second, k );
+  }
+
+  /*** Forward: leading zeros and sign bits ***/
+  void bound_leading_bits( const z3::expr& n )
+  {
+    const unsigned w = width_of( n );
+    if ( w == 0u || !n.is_app() )
+    {
+      return;
+    }
+
+    unsigned zeros = 0u, signs = 0u;
+    const Z3_decl_kind kind = n.decl().decl_kind();
+    switch ( kind )
+    {
+    case Z3_OP_BNUM:
+      {
+        const bv_value v = expr_to_bv_value( n );
+        while ( zeros < w && !v.bit( w - 1u - zeros ) )
+        {
+          ++zeros;
+        }
+        while ( signs + 1u < w && v.bit( w - 2u - signs ) == v.msb() )
+        {
+          ++signs;
+        }
+      }
+      break;
+
+    case Z3_OP_ZERO_EXT:
+      zeros = info( n.arg( 0u ) ).zeros + decl_int_parameter( n, 0u );
+      break;
+
+    case Z3_OP_SIGN_EXT:
+      {
+        const term_info& x = info( n.arg( 0u ) );
+        zeros = x.zeros > 0u ? x.zeros + decl_int_parameter( n, 0u ) : 0u;
+        signs = x.signs + decl_int_parameter( n, 0u );
+      }
+      break;
+
+    case Z3_OP_CONCAT:
+      for ( unsigned i = 0u; i < n.num_args(); ++i )
+      {
+        zeros += info( n.arg( i ) ).zeros;
+        if ( info( n.arg( i ) ).zeros < width_of( n.arg( i ) ) )
+        {
+          break;
+        }
+      }
+      signs = info( n.arg( 0u ) ).signs;
+      break;
+
+    case Z3_OP_EXTRACT:
+      {
+        const term_info& x = info( n.arg( 0u ) );
+        const unsigned cut = width_of( n.arg( 0u ) ) - 1u - hi( n );
+        zeros = x.zeros > cut ? x.zeros - cut : 0u;
+        signs = x.signs > cut ? x.signs - cut : 0u;
+      }
+      break;
+
+    case Z3_OP_BAND:
+    case Z3_OP_BOR:
+    case Z3_OP_BXOR:
+    case Z3_OP_ITE:
+      {
+        const unsigned first = kind == Z3_OP_ITE ? 1u : 0u;
+        zeros = info( n.arg( first ) ).zeros;
+        signs = info( n.arg( first ) ).signs;
+        for ( unsigned i = first + 1u; i < n.num_args(); ++i )
+        {
+          zeros = kind == Z3_OP_BAND ? std::max( zeros, info( n.arg( i ) ).zeros ) : std::min( zeros, info( n.arg( i ) ).zeros );
+          signs = std::min( signs, info( n.arg( i ) ).signs );
+        }
+      }
+      break;
+
+    case Z3_OP_BNOT:
+      signs = info( n.arg( 0u ) ).signs;
+      break;
+
+    case Z3_OP_BNEG:
+      signs = info( n.arg( 0u ) ).signs > 0u ? info( n.arg( 0u ) ).signs - 1u : 0u;
+      break;
+
+    case Z3_OP_BADD:
+    case Z3_OP_BSUB:
+      /* one carry bit */
+      if ( n.num_args() == 2u )
+      {
+        const unsigned z = std::min( info( n.arg( 0u ) ).zeros, info( n.arg( 1u ) ).zeros );
+        const unsigned s = std::min( info( n.arg( 0u ) ).signs, info( n.arg( 1u ) ).signs );
+        zeros = kind == Z3_OP_BADD && z > 0u ? z - 1u : 0u;
+        signs = s > 0u ? s - 1u : 0u;
+      }
+      break;
+
+    case Z3_OP_BMUL:
+      if ( n.num_args() == 2u )
+      {
+        const unsigned z = info( n.arg( 0u ) ).zeros + info( n.arg( 1u ) ).zeros;
+        zeros = z > w ? z - w : 0u;
+      }
+      break;
+
+    case Z3_OP_BUREM:
+      /* the remainder is at most the dividend */
+      zeros = info( n.arg( 0u ) ).zeros;
+      break;
+
+    case Z3_OP_BLSHR:
+      if ( has_constant_amount( n ) )
+      {
+        zeros = info( n.arg( 0u ) ).zeros + constant_amount( n );
+      }
+      break;
+
+    case Z3_OP_BASHR:
+      if ( has_constant_amount( n ) )
+      {
+        const term_info& x = info( n.arg( 0u ) );
+        zeros = x.zeros > 0u ? x.zeros + constant_amount( n ) : 0u;
+        signs = x.signs + constant_amount( n );
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    if ( zeros > 0u )
+    {
+      signs = std::max( signs, zeros - 1u );
+    }
+    term_info& t = info( n );
+    t.zeros = std::min( zeros, w );
+    t.signs = std::min( signs, w - 1u );
+  }
+
+  /* width of the comparison `n' of two bit-vectors, 0 if it is not narrowed */
+  unsigned narrowed_comparison( const z3::expr& n )
+  {
+    if ( !n.is_app() || n.num_args() != 2u || width_of( n.arg( 0u ) ) == 0u )
+    {
+      return 0u;
+    }
+
+    const unsigned w = width_of( n.arg( 0u ) );
+    const unsigned zeros = std::min( info( n.arg( 0u ) ).zeros, info( n.arg( 1u ) ).zeros );
+    const unsigned signs = std::min( info( n.arg( 0u ) ).signs, info( n.arg( 1u ) ).signs );
+    unsigned cut = 0u;
+    switch ( n.decl().decl_kind() )
+    {
+    case Z3_OP_EQ:
+    case Z3_OP_DISTINCT:
+      cut = std::max( zeros, signs );
+      break;
+    case Z3_OP_ULEQ:
+    case Z3_OP_ULT:
+    case Z3_OP_UGEQ:
+    case Z3_OP_UGT:
+      cut = zeros;
+      break;
+    case Z3_OP_SLEQ:
+    case Z3_OP_SLT:
+    case Z3_OP_SGEQ:
+    case Z3_OP_SGT:
+      cut = signs;
+      break;
+    default:
+      break;
+    }
+    return cut == 0u ? 0u : w - std::min( cut, w - 1u );
+  }
+
+  /*** Backward: demanded low bits ***/
+  void propagate_demand( const z3::expr& n )
+  {
+    const unsigned d = info( n ).demand;
+    if ( d == 0u || !n.is_app() )
+    {
+      return;
+    }
+
+    const Z3_decl_kind kind = n.decl().decl_kind();
+    if ( width_of( n ) == 0u )
+    {
+      const unsigned k = narrowed_comparison( n );
+      info( n ).compare = k;
+      for ( unsigned i = 0u; i < n.num_args(); ++i )
+      {
+        demand( n.arg( i ), k > 0u ? k : std::max( 1u, width_of( n.arg( i ) ) ) );
+      }
+      return;
+    }
+
+    if ( is_low_closed( kind ) )
+    {
+      for ( unsigned i = 0u; i < n.num_args(); ++i )
+      {
+        demand( n.arg( i ), d );
+      }
+      return;
+    }
+
+    switch ( kind )
+    {
+    case Z3_OP_ITE:
+      demand( n.arg( 0u ), 1u );
+      demand( n.arg( 1u ), d );
+      demand( n.arg( 2u ), d );
+      break;
+
+    case Z3_OP_CONCAT:
+      {
+        unsigned offset = 0u;
+        for ( unsigned i = n.num_args(); i > 0u && offset < d; --i )
+        {
+          const unsigned wi = width_of( n.arg( i - 1u ) );
+          demand( n.arg( i - 1u ), std::min( wi, d - offset ) );
+          offset += wi;
+        }
+      }
+      break;
+
+    case Z3_OP_ZERO_EXT:
+    case Z3_OP_SIGN_EXT:
+      demand( n.arg( 0u ), std::min( d, width_of( n.arg( 0u ) ) ) );
+      break;
+
+    case Z3_OP_EXTRACT:
+      demand( n.arg( 0u ), lo( n ) + d );
+      break;
+
+    case Z3_OP_BSHL:
+      if ( has_constant_amount( n ) )
+      {
+        if ( d > constant_amount( n ) )
+        {
+          demand( n.arg( 0u ), d - constant_amount( n ) );
+        }
+        break;
+      }
+      /* fall through */
+
+    default:
+      for ( unsigned i = 0u; i < n.num_args(); ++i )
+      {
+        demand( n.arg( i ), std::max( 1u, width_of( n.arg( i ) ) ) );
+      }
+      break;
+    }
+  }
+
+  /*** Rebuild at the demanded width ***/
+  z3::expr rebuild_generic( const z3::expr& n ) const
+  {
+    if ( !n.is_app() || n.num_args() == 0u )
+    {
+      return n;
+    }
+
+    std::vector< z3::expr > args;
+    bool changed = false;
+    for ( unsigned i = 0u; i < n.num_args(); ++i )
+    {
+      args.push_back( fit( n.arg( i ), width_of( n.arg( i ) ) ) );
+      changed = changed || z3_expr_id( args.back() ) != z3_expr_id( n.arg( i ) );
+    }
+    if ( !changed )
+    {
+      return n;
+    }
+
+    std::vector< Z3_ast > asts( args.begin(), args.end() );
+    return z3::expr( n.ctx(), Z3_mk_app( n.ctx(), n.decl(), asts.size(), &asts[0u] ) );
+  }
+
+  z3::expr rebuild( const z3::expr& n )
+  {
+    const unsigned w = width_of( n );
+    const term_info& t = info( n );
+    if ( w == 0u )
+    {
+      if ( t.compare > 0u )
+      {
+        return make_binary( n.decl().decl_kind(), fit( n.arg( 0u ), t.compare ), fit( n.arg( 1u ), t.compare ) );
+      }
+      return rebuild_generic( n );
+    }
+
+    const unsigned d = t.demand;
+    if ( !n.is_app() )
+    {
+      return d == w ? n : make_extract( n, d - 1u, 0u );
+    }
+
+    const Z3_decl_kind kind = n.decl().decl_kind();
+    if ( is_low_closed( kind ) && d < w )
+    {
+      if ( n.num_args() == 1u )
+      {
+        return make_unary( kind, fit( n.arg( 0u ), d ) );
+      }
+      z3::expr r = fit( n.arg( 0u ), d );
+      for ( unsigned i = 1u; i < n.num_args(); ++i )
+      {
+        r = make_binary( kind, r, fit( n.arg( i ), d ) );
+      }
+      return r;
+    }
+
+    switch ( kind )
+    {
+    case Z3_OP_ITE:
+      if ( d < w )
+      {
+        return z3::expr( n.ctx(), Z3_mk_ite( n.ctx(), fit( n.arg( 0u ), 1u ), fit( n.arg( 1u ), d ), fit( n.arg( 2u ), d ) ) );
+      }
+      break;
+
+    case Z3_OP_CONCAT:
+      if ( d < w )
+      {
+        /* parts from the least significant one */
+        std::vector< z3::expr > parts;
+        unsigned offset = 0u;
+        for ( unsigned i = n.num_args(); i > 0u && offset < d; --i )
+        {
+          const unsigned wi = width_of( n.arg( i - 1u ) );
+          parts.push_back( fit( n.arg( i - 1u ), std::min( wi, d - offset ) ) );
+          offset += wi;
+        }
+        z3::expr r = parts.back();
+        for ( unsigned i = parts.size() - 1u; i > 0u; --i )
+        {
+          r = make_concat( r, parts[i - 1u] );
+        }
+        return r;
+      }
+      break;
+
+    case Z3_OP_ZERO_EXT:
+    case Z3_OP_SIGN_EXT:
+      {
+        const unsigned wx = width_of( n.arg( 0u ) );
+        if ( d <= wx )
+        {
+          return fit( n.arg( 0u ), d );
+        }
+        else if ( d < w )
+        {
+          return make_extend( kind, fit( n.arg( 0u ), wx ), d - wx );
+        }
+      }
+      break;
+
+    case Z3_OP_EXTRACT:
+      return slice( fit( n.arg( 0u ), lo( n ) + d ), lo( n ) + d - 1u, lo( n ) );
+
+    case Z3_OP_BSHL:
+      if ( has_constant_amount( n ) )
+      {
+        const unsigned k = constant_amount( n );
+        if ( k >= d )
+        {
+          return n.ctx().bv_val( 0, d );
+        }
+        const z3::expr x = fit( n.arg( 0u ), d - k );
+        return k == 0u ? x : make_concat( x, n.ctx().bv_val( 0, k ) );
+      }
+      break;
+
+    default:
+      break;
+    }
+    return truncate( rebuild_generic( n ), d );
+  }
+
+  z3::expr root;
+  std::vector< z3::expr > order;
+  std::unordered_map< unsigned, term_info > infos;
+  std::unordered_map< unsigned, z3::expr > low;
+};
+
+}
+
+z3::expr reduce_widths( const z3::expr& instance, width_reduction_stats& stats )
+{
+  width_reducer reducer( instance );
+  const z3::expr reduced = reducer();
+  stats.bits_before += total_bits( instance );
+  stats.bits_after += total_bits( reduced );
+  return reduced;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
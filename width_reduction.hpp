@@ -0,0 +1,60 @@
+/* metaSMT SMT2 Evaluator
+ * Copyright (C) 2015  German Aerospace Center (DLR, e.V.)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file width_reduction.hpp
+ *
+ * @brief narrowing of bit-vector terms to the bits that matter
+ *
+ * Two analyses run over the DAG.  Forward, the number of leading
+ * zero bits and of redundant sign bits is bounded for every term,
+ * e.g., (zero_extend[56] x) has 56 leading zeros.  Comparisons of
+ * terms that share leading zeros (unsigned) or sign bits (signed,
+ * equality) only compare the remaining low bits.  Backward, the
+ * demanded low bits of every term are collected from its users:
+ * extract, concat, extensions and constant left shifts only read
+ * some bits, addition, multiplication and bitwise operators only
+ * need the low bits of their operands for low bits of the result.
+ * Every term is then rebuilt at its demanded width.
+ *
+ * @author Heinz Riener
+ * @since  1.0
+ */
+
+#include <z3++.h>
+
+#pragma once
+
+struct width_reduction_stats
+{
+  width_reduction_stats()
+    : bits_before( 0u )
+    , bits_after( 0u )
+  {}
+
+  /* sum of the widths of all distinct bit-vector terms */
+  unsigned long bits_before;
+  unsigned long bits_after;
+};
+
+z3::expr reduce_widths( const z3::expr& instance, width_reduction_stats& stats );
+
+// Local Variables:
+// c-basic-offset: 2
+// eval: (c-set-offset 'substatement-open 0)
+// eval: (c-set-offset 'innamespace 0)
+// End:
@@ -24,6 +24,10 @@
  * @since  1.0
  */
 
+#include "array_lemmas.hpp"
+#include "ite_chains.hpp"
+#include "nonlinear_abstraction.hpp"
+#include "operator_conversion.hpp"
 #include "z3_utils.hpp"
 
 #include <metaSMT/support/default_visitation_unrolling_limit.hpp>
@@ -33,24 +37,64 @@
 
 #include <z3++.h>
 
-#include <map>
+#include <deque>
 #include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #pragma once
 
+struct conversion_stats
+{
+  conversion_stats()
+    : nodes( 0u )
+    , memo_hits( 0u )
+    , ite_chains( 0u )
+  {}
+
+  std::size_t nodes;
+  std::size_t memo_hits;
+  std::size_t ite_chains;
+};
+
+/**
+ * Every converted node is stored exactly once in `results'; the memo
+ * table maps Z3 expression ids to positions in it.  A deque never
+ * moves its elements, hence the returned references stay valid for
+ * the lifetime of the generator and are passed on to
+ * convert_application() without copying.
+ *
+ * Arrays are converted natively if the backend supports them (see
+ * array_backend).  Otherwise reads and array equalities are abstracted
+ * and refine() has to be called after every satisfiable answer (see
+ * solve_with_refinement).  The same holds for bvmul, bvudiv and bvurem
+ * if abstract_nonlinear() is enabled.
+ */
 template < typename Solver >
 class result_type_generator
 {
 public:
   using result_type = typename Solver::result_type;
 
+  static const bool lazy_arrays = !array_backend< Solver >::value;
+
   result_type_generator( Solver& solver )
     : solver( solver )
+    , arrays( solver )
+    , nonlinear( solver )
   {}
 
+  /* replaces bvmul, bvudiv and bvurem by refinable abstractions */
+  void abstract_nonlinear( bool enable )
+  {
+    nonlinear.enable( enable );
+  }
+
   virtual ~result_type_generator() {}
 
-  result_type convert_constant_or_variable( const z3::expr& e )
+  const result_type& convert_constant_or_variable( const z3::expr& e )
   {
     using namespace metaSMT;
     using namespace metaSMT::logic;
@@ -93,6 +137,10 @@ public:
         const unsigned w = decl.range().bv_size();
         r = evaluate( solver, new_bitvector( w ) );
       }
+      else if ( sort_kind == Z3_ARRAY_SORT )
+      {
+        r = make_array_variable( solver, sort.array_range().bv_size(), sort.array_domain().bv_size(), std::integral_constant< bool, !lazy_arrays >() );
+      }
       else if ( sort_kind == Z3_INT_SORT )
       {
         assert( false && "Integer variables are not supported by metaSMT" );
@@ -108,18 +156,11 @@ public:
       assert( false );
     }
 
-    /*** update map ***/
-    const unsigned id = z3_expr_id( e );
-    the_map.insert( std::make_pair(id,r) );
-    return r;
+    return store( e, std::move( r ) );
   }
 
-  result_type convert_operator( const z3::expr& e )
+  const result_type& convert_operator( const z3::expr& e )
   {
-    using namespace metaSMT;
-    using namespace metaSMT::logic;
-    using namespace metaSMT::logic::QF_BV;
-
     const z3::func_decl& decl = e.decl();
     assert( decl.arity() > 0 && "Expression is not an operator" );
 
@@ -127,471 +168,31 @@ public:
     // const std::string name = decl.name().str();
     // std::cout << "CONVERT OP:" << name << '\n';
 
-    const Z3_decl_kind& decl_kind = decl.decl_kind();
-
-    result_type r;
-    switch( decl_kind )
+    if ( decl.decl_kind() == Z3_OP_ITE )
     {
-    case Z3_OP_EQ:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, logic::equal( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_DISTINCT:
-      {
-        if( e.num_args() == 2u )
-        {
-          const result_type lhs = operator()( e.arg( 0u ) );
-          const result_type rhs = operator()( e.arg( 1u ) );
-          r = evaluate( solver, Not( logic::equal( lhs, rhs ) ) );
-        }
-        else
-        {
-          std::vector< result_type > c;
-          for ( unsigned n = 0u; n < e.num_args(); ++n )
-          {
-            c.push_back( operator()( e.arg( n ) ) );
-          }
-          r = evaluate( solver, logic::True );
-          for ( unsigned i = 0u; i < e.num_args(); ++i )
-          {
-            for ( unsigned j = i+1; j < e.num_args(); ++j )
-            {
-              r = evaluate( solver, And( r, logic::nequal( c[i], c[j] ) ) );
-            }
-          }
-        }
-      }
-      break;
-    case Z3_OP_ITE:
-      {
-        assert( e.num_args() == 3u );
-        const result_type cond = operator()( e.arg( 0u ) );
-        const result_type x = operator()( e.arg( 1u ) );
-        const result_type y = operator()( e.arg( 2u ) );
-        r = evaluate( solver, Ite( cond, x, y ) );
-      }
-      break;
-    case Z3_OP_AND:
-      {
-        const unsigned size = e.num_args();
-        result_type compound = operator()( e.arg( size-1u ) );
-        for ( unsigned i = 1u; i < size; ++i )
-        {
-          const result_type arg = operator()( e.arg( size-1u-i ) );
-          compound = evaluate( solver, And( arg, compound ) );
-        }
-        r = compound;
-      }
-      break;
-    case Z3_OP_OR:
-      {
-        const unsigned size = e.num_args();
-        result_type compound = operator()( e.arg( size-1u ) );
-        for ( unsigned i = 1u; i < size; ++i )
-        {
-          const result_type arg = operator()( e.arg( size-1u-i ) );
-          compound = evaluate( solver, Or( arg, compound ) );
-        }
-        r = compound;
-      }
-      break;
-    case Z3_OP_IFF:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, logic::equal( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_XOR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, Xor( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_NOT:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, Not( arg ) );
-      }
-      break;
-    case Z3_OP_IMPLIES:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, implies( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BNEG:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, bvneg( arg ) );
-      }
-      break;
-    case Z3_OP_BADD:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvadd( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BSUB:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsub( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BMUL:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvmul( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BSDIV:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsdiv( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BUDIV:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvudiv( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BSMOD:
-    case Z3_OP_BSREM:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsrem( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BUREM:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvurem( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BSDIV0:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BSDIV0" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BUDIV0:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BUDIV0" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BSREM0:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BSREM0" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BUREM0:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BUREM0" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BSMOD0:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BSMOD0" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_ULEQ:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvule( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_SLEQ:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsle( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_UGEQ:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvuge( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_SGEQ:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsge( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_ULT:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvult( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_SLT:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvslt( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_UGT:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvugt( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_SGT:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvsgt( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BAND:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvand( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BOR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvor( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BNOT:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, bvnot( arg ) );
-      }
-      break;
-    case Z3_OP_BXOR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvxor( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BNAND:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvnand( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BNOR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvnor( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BXNOR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvxnor( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_CONCAT:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, concat( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_SIGN_EXT:
-      {
-        assert( e.num_args() == 1u );
-        const unsigned result_size = decl.range().bv_size();
-        const unsigned arg_size = e.arg( 0 ).decl().range().bv_size();
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, sign_extend( result_size - arg_size, arg ) );
-      }
-      break;
-    case Z3_OP_ZERO_EXT:
-      {
-        assert( e.num_args() == 1u );
-        const unsigned result_size = decl.range().bv_size();
-        const unsigned arg_size = e.arg( 0 ).decl().range().bv_size();
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, zero_extend( result_size - arg_size, arg ) );
-      }
-      break;
-    case Z3_OP_EXTRACT:
+      ite_chain chain( e );
+      if ( match_ite_chain( e, chain ) )
       {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = evaluate( solver, extract( hi( e ), lo( e ), arg ) );
+        return convert_chain( e, chain );
       }
-      break;
-    case Z3_OP_REPEAT:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        r = arg;
-        const unsigned how_many = decl_int_parameter( e, 0u );
-        for ( unsigned i = 1u; i < how_many; ++i )
-        {
-          r = evaluate( solver, concat(r, arg) );
-        }
-      }
-      break;
-    case Z3_OP_BREDOR:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BREDOR" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BREDAND:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_BREDAND" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_BCOMP:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvcomp( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BSHL:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvshl( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BLSHR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvshr( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_BASHR:
-      {
-        assert( e.num_args() == 2u );
-        const result_type lhs = operator()( e.arg( 0u ) );
-        const result_type rhs = operator()( e.arg( 1u ) );
-        r = evaluate( solver, bvashr( lhs, rhs ) );
-      }
-      break;
-    case Z3_OP_ROTATE_LEFT:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        const unsigned n = decl_int_parameter( e, 0u );
-        if ( n > 0u )
-        {
-          const unsigned size = decl.range().bv_size();
-          const result_type lower = evaluate( solver, extract( size-1u-n, 0u, arg ) );
-          const result_type higher = evaluate( solver, extract( size-1u, size-n, arg ) );
-          r = evaluate( solver, concat( lower, higher ) );
-        }
-        else
-        {
-          r = evaluate( solver, arg );
-        }
-      }
-      break;
-    case Z3_OP_ROTATE_RIGHT:
-      {
-        assert( e.num_args() == 1u );
-        const result_type arg = operator()( e.arg( 0u ) );
-        const unsigned n = decl_int_parameter( e, 0u );
-        if ( n > 0u )
-        {
-          const unsigned size = decl.range().bv_size();
-          const result_type lower = evaluate( solver, extract( n-1u, 0u, arg ) );
-          const result_type higher = evaluate( solver, extract( size-1u, n, arg ) );
-          r = evaluate( solver, concat( lower, higher ) );
-        }
-        else
-        {
-          r = evaluate( solver, arg );
-        }
-      }
-      break;
-    case Z3_OP_EXT_ROTATE_LEFT:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_EXT_ROTATE_LEFT" << '\n';
-        assert( false );
-      }
-      break;
-    case Z3_OP_EXT_ROTATE_RIGHT:
-      {
-        std::cout << "NOT IMPLEMENTED: Z3_OP_EXT_ROTATE_RIGHT" << '\n';
-        assert( false );
-      }
-      break;
-    default:
-      std::cerr << "[e] convert_operator: does not support expression of type " << decl.name().str() << " [ " << std::hex << decl_kind << "]\n";
-      break;
     }
 
-    /*** update map ***/
-    const unsigned id = z3_expr_id( e );
-    the_map.insert( std::make_pair(id,r) );
-    return r;
+    argument_refs< result_type > args;
+    args.reserve( e.num_args() );
+    for ( unsigned i = 0u; i < e.num_args(); ++i )
+    {
+      args.push_back( operator()( e.arg( i ) ) );
+    }
+
+    const operator_node node = make_operator_node( e );
+    if ( nonlinear.is_abstracted( node.kind ) && args.size() == 2u )
+    {
+      return store( e, nonlinear.abstract( node.kind, node.width, args[0u], args[1u] ) );
+    }
+    return store( e, convert_application( solver, node, args ) );
   }
 
-  result_type operator()( const z3::expr& e )
+  const result_type& operator()( const z3::expr& e )
   {
     using namespace metaSMT;
     using namespace metaSMT::logic;
@@ -601,7 +202,21 @@ public:
     auto it = the_map.find( id );
     if ( it != the_map.end() )
     {
-      return it->second;
+      ++stats.memo_hits;
+      return results[it->second];
+    }
+
+    if ( lazy_arrays && e.is_app() )
+    {
+      const Z3_decl_kind kind = e.decl().decl_kind();
+      if ( kind == Z3_OP_SELECT )
+      {
+        return convert_read( e );
+      }
+      else if ( kind == Z3_OP_EQ && e.arg( 0u ).get_sort().is_array() )
+      {
+        return convert_array_equality( e );
+      }
     }
 
     if ( e.is_app() )
@@ -614,10 +229,6 @@ public:
       }
       else
       {
-        for ( unsigned i = 0u; i < size; ++i )
-        {
-          this->operator()( e.arg( i ) );
-        }
         return convert_operator( e );
       }
     }
@@ -630,14 +241,183 @@ public:
     {
       assert( false && "yet not implemented." );
     }
-    return evaluate( solver, False );
+    return store( e, evaluate( solver, False ) );
+  }
+
+  const conversion_stats& statistics() const
+  {
+    return stats;
+  }
+
+  /**
+   * Adds lemmas for the array reads and nonlinear operators violated
+   * by the current model.
+   * Returns false if the model is consistent, i.e., the answer of the
+   * solver holds for the instance.
+   */
+  bool refine()
+  {
+    unsigned num_lemmas = 0u;
+    if ( !arrays.empty() )
+    {
+      num_lemmas += arrays.refine( *this );
+    }
+    if ( !nonlinear.empty() )
+    {
+      num_lemmas += nonlinear.refine();
+    }
+    return num_lemmas > 0u;
+  }
+
+  /* true if arrays or nonlinear operators were abstracted */
+  bool needs_refinement() const
+  {
+    return !arrays.empty() || !nonlinear.empty();
+  }
+
+  const nonlinear_abstraction< Solver >& nonlinear_operators() const
+  {
+    return nonlinear;
   }
 
 protected:
+  /* converts an ITE cascade over one selector as a lookup, see ite_chains.hpp */
+  const result_type& convert_chain( const z3::expr& e, const ite_chain& chain )
+  {
+    const result_type& selector = operator()( chain.selector );
+    argument_refs< result_type > values;
+    values.reserve( chain.values.size() );
+    for ( const auto& v : chain.values )
+    {
+      values.push_back( operator()( v ) );
+    }
+    const result_type& otherwise = operator()( chain.otherwise );
+
+    ++stats.ite_chains;
+    return store( e, convert_ite_chain( solver, chain, selector, values, otherwise ) );
+  }
+
+  const result_type& convert_read( const z3::expr& e )
+  {
+    const z3::expr array = e.arg( 0u );
+    const result_type& index = operator()( e.arg( 1u ) );
+    prepare_array( array );
+
+    const result_type r = new_element( array.get_sort() );
+    arrays.add_read( array, index, r );
+    return store( e, r );
+  }
+
+  const result_type& convert_array_equality( const z3::expr& e )
+  {
+    using namespace metaSMT;
+    using namespace metaSMT::logic;
+    using namespace metaSMT::logic::QF_BV;
+
+    const z3::expr lhs = e.arg( 0u );
+    const z3::expr rhs = e.arg( 1u );
+    prepare_array( lhs );
+    prepare_array( rhs );
+
+    const result_type eq = evaluate( solver, new_variable() );
+    arrays.add_equality( lhs, rhs, eq );
+
+    /*** extensionality: unequal arrays differ at some index ***/
+    const result_type k = evaluate( solver, new_bitvector( lhs.get_sort().array_domain().bv_size() ) );
+    const result_type a = new_element( lhs.get_sort() );
+    const result_type b = new_element( rhs.get_sort() );
+    arrays.add_read( lhs, k, a );
+    arrays.add_read( rhs, k, b );
+    assertion( solver, evaluate( solver, Or( eq, nequal( a, b ) ) ) );
+
+    return store( e, eq );
+  }
+
+  /* fresh variable for an element of an array of the given sort */
+  result_type new_element( const z3::sort& sort )
+  {
+    if ( !sort.array_domain().is_bv() || !sort.array_range().is_bv() )
+    {
+      std::cerr << "[e] result_type_generator: only arrays from bit-vectors to bit-vectors are supported\n";
+      assert( false );
+    }
+    return metaSMT::evaluate( solver, metaSMT::logic::QF_BV::new_bitvector( sort.array_range().bv_size() ) );
+  }
+
+  /*
+   * Converts the indices, values and conditions inside the array term
+   * `a' such that array_lemmas::refine() can read their values.
+   */
+  void prepare_array( const z3::expr& a )
+  {
+    std::vector< z3::expr > stack( 1u, a );
+    while ( !stack.empty() )
+    {
+      const z3::expr t = stack.back();
+      stack.pop_back();
+      if ( !prepared_arrays.insert( z3_expr_id( t ) ).second )
+      {
+        continue;
+      }
+
+      switch ( t.decl().decl_kind() )
+      {
+      case Z3_OP_STORE:
+        operator()( t.arg( 1u ) );
+        operator()( t.arg( 2u ) );
+        stack.push_back( t.arg( 0u ) );
+        break;
+      case Z3_OP_ITE:
+        operator()( t.arg( 0u ) );
+        stack.push_back( t.arg( 1u ) );
+        stack.push_back( t.arg( 2u ) );
+        break;
+      case Z3_OP_CONST_ARRAY:
+        operator()( t.arg( 0u ) );
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  const result_type& store( const z3::expr& e, result_type r )
+  {
+    /*** update map ***/
+    const unsigned id = z3_expr_id( e );
+    the_map.insert( std::make_pair( id, results.size() ) );
+    results.push_back( std::move( r ) );
+    ++stats.nodes;
+    return results.back();
+  }
+
   Solver& solver;
-  std::map< unsigned, result_type > the_map;
+  std::deque< result_type > results;
+  std::unordered_map< unsigned, std::size_t > the_map;
+  conversion_stats stats;
+
+  array_lemmas< Solver > arrays;
+  std::unordered_set< unsigned > prepared_arrays;
+  nonlinear_abstraction< Solver > nonlinear;
 }; /* z3_expr_visitor */
 
+/**
+ * Solves and refines the array abstraction of `generator' until the
+ * instance is unsatisfiable or the model is consistent.
+ */
+template < typename Solver >
+bool solve_with_refinement( Solver& solver, result_type_generator< Solver >& generator )
+{
+  while ( metaSMT::solve( solver ) )
+  {
+    if ( !generator.refine() )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)
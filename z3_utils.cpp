@@ -18,6 +18,9 @@
 #include "z3_utils.hpp"
 #include "conversion_utils.hpp"
 
+#include <unordered_set>
+#include <utility>
+
 const bool expr_to_bool( const z3::expr& e )
 {
   assert( e.decl().decl_kind() == Z3_OP_TRUE ||
@@ -47,6 +50,17 @@ const std::string expr_to_bin( const z3::expr &e )
   }
 }
 
+bv_value expr_to_bv_value( const z3::expr& e )
+{
+  return bv_value::from_binary( expr_to_bin( e ) );
+}
+
+z3::expr bv_value_to_expr( z3::context& ctx, const bv_value& v )
+{
+  const std::string dec = v.fits_word() ? std::to_string( v.word() ) : convert_bin2dec( v.to_binary() );
+  return ctx.bv_val( dec.c_str(), v.width() );
+}
+
 unsigned decl_num_parameters( const z3::expr& e )
 {
   assert( e.is_app() );
@@ -75,6 +89,103 @@ unsigned z3_expr_id( const z3::expr& e )
   return Z3_get_ast_id( e.ctx(), e );
 }
 
+bool is_variable( const z3::expr& e )
+{
+  return e.is_app() && e.num_args() == 0u && e.decl().decl_kind() == Z3_OP_UNINTERPRETED;
+}
+
+/**
+ * The variables of `e` in the order of their first occurrence in a
+ * depth-first traversal.
+ */
+std::vector< z3::expr > collect_variables( const z3::expr& e )
+{
+  std::vector< z3::expr > variables;
+  std::unordered_set< unsigned > visited;
+  std::vector< z3::expr > stack( 1u, e );
+  while ( !stack.empty() )
+  {
+    const z3::expr n = stack.back();
+    stack.pop_back();
+    if ( !visited.insert( z3_expr_id( n ) ).second )
+    {
+      continue;
+    }
+    if ( is_variable( n ) )
+    {
+      variables.push_back( n );
+    }
+    else if ( n.is_app() )
+    {
+      for ( unsigned i = n.num_args(); i > 0u; --i )
+      {
+        stack.push_back( n.arg( i-1u ) );
+      }
+    }
+  }
+  return variables;
+}
+
+/* the distinct terms of `root', children before parents */
+std::vector< z3::expr > topological_order( const z3::expr& root )
+{
+  std::vector< z3::expr > order;
+  std::unordered_set< unsigned > visited;
+  std::vector< std::pair< z3::expr, bool > > stack( 1u, std::make_pair( root, false ) );
+  while ( !stack.empty() )
+  {
+    const z3::expr n = stack.back().first;
+    if ( stack.back().second )
+    {
+      stack.pop_back();
+      order.push_back( n );
+      continue;
+    }
+    if ( !visited.insert( z3_expr_id( n ) ).second )
+    {
+      stack.pop_back();
+      continue;
+    }
+
+    stack.back().second = true;
+    if ( n.is_app() )
+    {
+      for ( unsigned i = n.num_args(); i > 0u; --i )
+      {
+        stack.push_back( std::make_pair( n.arg( i-1u ), false ) );
+      }
+    }
+  }
+  return order;
+}
+
+bool contains_arrays( const z3::expr& e )
+{
+  std::unordered_set< unsigned > visited;
+  std::vector< z3::expr > stack( 1u, e );
+  while ( !stack.empty() )
+  {
+    const z3::expr n = stack.back();
+    stack.pop_back();
+    if ( !visited.insert( z3_expr_id( n ) ).second )
+    {
+      continue;
+    }
+    if ( n.get_sort().is_array() )
+    {
+      return true;
+    }
+    if ( n.is_app() )
+    {
+      for ( unsigned i = 0u; i < n.num_args(); ++i )
+      {
+        stack.push_back( n.arg( i ) );
+      }
+    }
+  }
+  return false;
+}
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)
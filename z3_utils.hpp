@@ -25,11 +25,16 @@
  * @since  1.0
  */
 
+#include "bv_value.hpp"
+
 #include <z3++.h>
 #include <string>
+#include <vector>
 
 const bool expr_to_bool( const z3::expr& e );
 const std::string expr_to_bin( const z3::expr &e );
+bv_value expr_to_bv_value( const z3::expr& e );
+z3::expr bv_value_to_expr( z3::context& ctx, const bv_value& v );
 
 unsigned decl_num_parameters( const z3::expr& e );
 unsigned decl_int_parameter( const z3::expr& e, const unsigned n );
@@ -37,6 +42,11 @@ unsigned hi( const z3::expr& e );
 unsigned lo( const z3::expr& e );
 unsigned z3_expr_id( const z3::expr& e );
 
+bool is_variable( const z3::expr& e );
+std::vector< z3::expr > collect_variables( const z3::expr& e );
+std::vector< z3::expr > topological_order( const z3::expr& root );
+bool contains_arrays( const z3::expr& e );
+
 // Local Variables:
 // c-basic-offset: 2
 // eval: (c-set-offset 'substatement-open 0)